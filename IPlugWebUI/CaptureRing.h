@@ -0,0 +1,126 @@
+#pragma once
+
+// Lock-free single-producer, single-consumer ring of the plug-in's input and
+// output for the editor's spectrum analyser. The audio thread writes the
+// input side of a block before rendering and the output side after, so
+// in-place buffers work, and publishes both with one release store; the
+// analysis worker reads them with acquire. Channels are mixed to mono and
+// decimated by a boxcar average down to no less than kMinCaptureRate.
+//
+// Storage is fixed and nothing allocates, locks or waits. When the worker
+// falls behind, the rest of the block is dropped on both sides so the two
+// streams stay aligned.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "TapeSaturatorDSP.h"
+
+class CaptureRing
+{
+public:
+  struct Frame
+  {
+    float input;
+    float output;
+  };
+
+  static constexpr int kCapacity = 1 << 14;  // frames, ~0.34 s at 48 kHz
+  static constexpr double kMinCaptureRate = 44100.0;
+
+  // Audio thread, or while not processing. Picks the decimation for the
+  // sample rate; the worker drops what it has when the generation changes.
+  void Reset(double sampleRate)
+  {
+    mFactor = std::max(1, static_cast<int>(sampleRate / kMinCaptureRate));
+    mInput = Decimator();
+    mOutput = Decimator();
+    mCaptureRate.store(std::max(sampleRate, 1.0) / mFactor, std::memory_order_relaxed);
+    mGeneration.fetch_add(1, std::memory_order_release);
+  }
+
+  // Audio thread, before rendering. Mixes channels [0, numChannels).
+  template <typename T>
+  void WriteInput(const T* const* inputs, int nFrames, int numChannels)
+  {
+    const uint32_t write = mWrite.load(std::memory_order_relaxed);
+    mBlockSpace = kCapacity - static_cast<int>(write - mRead.load(std::memory_order_acquire));
+    Decimate(inputs, nFrames, numChannels, mInput, write, &Frame::input);
+  }
+
+  // Audio thread, after rendering the same frames; publishes the block
+  template <typename T>
+  void WriteOutput(const T* const* outputs, int nFrames, int numChannels)
+  {
+    const uint32_t write = mWrite.load(std::memory_order_relaxed);
+    const int count = Decimate(outputs, nFrames, numChannels, mOutput, write, &Frame::output);
+    const int written = std::min(count, mBlockSpace);
+    if (written < count)
+      mDroppedFrames.fetch_add(static_cast<uint64_t>(count - written), std::memory_order_relaxed);
+    mWrite.store(write + static_cast<uint32_t>(written), std::memory_order_release);
+  }
+
+  // Worker: moves up to maxFrames of the oldest frames to dest
+  int Read(Frame* dest, int maxFrames)
+  {
+    const uint32_t read = mRead.load(std::memory_order_relaxed);
+    const int available = static_cast<int>(mWrite.load(std::memory_order_acquire) - read);
+    const int count = std::min(available, maxFrames);
+    for (int i = 0; i < count; ++i)
+      dest[i] = mFrames[(read + static_cast<uint32_t>(i)) & (kCapacity - 1)];
+    mRead.store(read + static_cast<uint32_t>(count), std::memory_order_release);
+    return count;
+  }
+
+  // Worker: skips everything published so far
+  void Discard() { mRead.store(mWrite.load(std::memory_order_acquire), std::memory_order_release); }
+
+  double GetCaptureRate() const { return mCaptureRate.load(std::memory_order_relaxed); }
+  uint32_t GetGeneration() const { return mGeneration.load(std::memory_order_acquire); }
+  uint64_t GetDroppedFrames() const { return mDroppedFrames.load(std::memory_order_relaxed); }
+
+private:
+  struct Decimator
+  {
+    double sum = 0.0;
+    int phase = 0;
+  };
+
+  // Both sides run the same number of frames from the same phase, so they
+  // finish the same frames; only the first mBlockSpace are stored
+  template <typename T>
+  int Decimate(const T* const* data, int nFrames, int numChannels, Decimator& state, uint32_t write, float Frame::*side)
+  {
+    const double scale = 1.0 / (mFactor * std::max(numChannels, 1));
+    int count = 0;
+    for (int s = 0; s < nFrames; ++s)
+    {
+      for (int c = 0; c < numChannels; ++c)
+        state.sum += static_cast<double>(data[c][s]);
+      if (++state.phase < mFactor)
+        continue;
+      if (count < mBlockSpace)
+        mFrames[(write + static_cast<uint32_t>(count)) & (kCapacity - 1)].*side = static_cast<float>(state.sum * scale);
+      ++count;
+      state.sum = 0.0;
+      state.phase = 0;
+    }
+    return count;
+  }
+
+  // Producer and consumer indices on separate cache lines
+  alignas(tapedsp::kCacheLineSize) std::atomic<uint32_t> mWrite {0};
+  std::atomic<uint64_t> mDroppedFrames {0};
+  std::atomic<uint32_t> mGeneration {0};
+  std::atomic<double> mCaptureRate {48000.0};
+  alignas(tapedsp::kCacheLineSize) std::atomic<uint32_t> mRead {0};
+
+  // Audio thread only
+  alignas(tapedsp::kCacheLineSize) int mFactor = 1;
+  int mBlockSpace = 0;
+  Decimator mInput;
+  Decimator mOutput;
+  std::array<Frame, kCapacity> mFrames {};
+};
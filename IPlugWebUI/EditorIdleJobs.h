@@ -0,0 +1,148 @@
+#pragma once
+
+// The editor jobs OnIdle runs (EIdleJob), shared by the plug-in and
+// lofi-render idle-sim so both run the same code. Editor is whatever shows
+// the page, the plug-in itself or idle-sim's mock, and provides
+//
+//   void EvaluateJavaScript(const char* script, std::function<void(const char*)> reply = nullptr);
+//   void Resize(int width, int height);
+//   void OnMetersSent(unsigned changed);  // EMeterReadings mask of the batch just sent
+//
+// The size check runs when the page reports that its window changed (the
+// page's resize listener posts kMsgTagEditorResized), whoever resized it:
+// the host, docking or display scaling. Nothing polls while the window stays
+// put. One per plug-in instance, main thread only.
+
+#include <string>
+
+#include "EditorMeters.h"
+#include "IdleScheduler.h"
+
+template <typename Editor>
+class EditorIdleJobs
+{
+public:
+  // width and height: the size the editor window is kept at
+  EditorIdleJobs(int width, int height)
+  : mWidth(width)
+  , mHeight(height)
+  {
+    for (int job = 0; job < kNumIdleJobs; ++job)
+      mJobs.SetInterval(job, kIdleJobIntervals[job]);
+  }
+
+  // A new page: nothing has been sent to it, the window is set to the
+  // editor size, and layout and size are checked once the page has loaded
+  void Open(Editor& editor)
+  {
+    mMeters.Reset();
+    mJobs.CancelAll();
+    mScaledWidth = mScaledHeight = 0.0;
+    Resize(editor, mWidth, mHeight);
+    mVerifyAttempts = 0;
+    mJobs.Trigger(kIdleJobVerifySize, kIdleSettleTicks);
+  }
+
+  void Close() { mJobs.CancelAll(); }
+
+  // Resizes the window; the page is laid out again once it has settled
+  void Resize(Editor& editor, int width, int height)
+  {
+    editor.Resize(width, height);
+    mJobs.Trigger(kIdleJobScale, kIdleSettleTicks);
+  }
+
+  // The page's window changed size. A burst of these (a drag) is merged
+  // into one check per interval.
+  void OnPageResized() { mJobs.Trigger(kIdleJobWatchSize); }
+
+  // Readings for the meter job
+  EditorMeters& GetMeters() { return mMeters; }
+  const IdleScheduler& GetScheduler() const { return mJobs; }
+
+  // One OnIdle tick: runs the jobs that are due
+  void Tick(Editor& editor)
+  {
+    if (mMeters.IsPending())
+      mJobs.Trigger(kIdleJobMeters);
+    mJobs.Tick([this, &editor](int job) { Run(editor, job); });
+  }
+
+private:
+  void Run(Editor& editor, int job)
+  {
+    switch (job)
+    {
+      case kIdleJobScale:
+        editor.EvaluateJavaScript(kApplyScaleScript, [this](const char* json) { ParseEditorSize(json, mScaledWidth, mScaledHeight); });
+        break;
+      case kIdleJobVerifySize:
+        VerifySize(editor);
+        break;
+      case kIdleJobMeters:
+        PushMeters(editor);
+        break;
+      case kIdleJobWatchSize:
+        WatchSize(editor);
+        break;
+      default:
+        break;
+    }
+  }
+
+  // Verify wrapper size and correct if host opened too small (e.g., FL Studio
+  // at 25%). Each attempt schedules the next; a matching size cancels it.
+  void VerifySize(Editor& editor)
+  {
+    if (mVerifyAttempts >= kMaxSizeVerifyAttempts)
+      return;
+
+    ++mVerifyAttempts;
+    mJobs.Trigger(kIdleJobVerifySize);
+    editor.EvaluateJavaScript(kSizeQueryScript, [this, &editor](const char* json) {
+      double w = 0.0, h = 0.0;
+      if (!ParseEditorSize(json, w, h))
+        return;
+      if (!SameEditorSize(w, h, mWidth, mHeight))
+      {
+        // Keep wrapper at the intended fixed size; avoid oversizing the host
+        Resize(editor, mWidth, mHeight);
+      }
+      else
+      {
+        mJobs.Cancel(kIdleJobVerifySize);
+      }
+    });
+  }
+
+  // Compares the page size with the one applyScale last laid out for and
+  // runs the scale job again if it changed
+  void WatchSize(Editor& editor)
+  {
+    if (mJobs.IsPending(kIdleJobScale))
+      return;
+    editor.EvaluateJavaScript(kSizeQueryScript, [this](const char* json) {
+      double w = 0.0, h = 0.0;
+      if (ParseEditorSize(json, w, h) && !SameEditorSize(w, h, mScaledWidth, mScaledHeight))
+        mJobs.Trigger(kIdleJobScale);
+    });
+  }
+
+  // One script for every reading whose text changed since it was last sent
+  void PushMeters(Editor& editor)
+  {
+    const unsigned changed = mMeters.Build(mMeterScript);
+    editor.OnMetersSent(changed);
+    if (!mMeterScript.empty())
+      editor.EvaluateJavaScript(mMeterScript.c_str());
+  }
+
+  const int mWidth;
+  const int mHeight;
+  IdleScheduler mJobs;
+  EditorMeters mMeters;
+  std::string mMeterScript;
+  int mVerifyAttempts = 0;
+  double mScaledWidth = 0.0;  // page size applyScale last laid out for
+  double mScaledHeight = 0.0;
+};
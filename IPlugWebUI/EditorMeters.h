@@ -0,0 +1,204 @@
+#pragma once
+
+// What OnIdle sends to the editor page, shared by the plug-in and
+// lofi-render idle-sim: the layout and size scripts, and the meter batch.
+// Readings are handed to EditorMeters as they come in from the audio thread
+// and the analyser; the meter job calls Build, which formats the pending
+// ones and returns a single script with every reading whose text changed
+// since it was last sent. Main thread only.
+
+#include <array>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "SpectrumAnalyser.h"
+
+// Values sent to the editor with the meters, in LUFS (gain in dB)
+enum ELoudnessReadings
+{
+  kLoudnessInputMomentary = 0,
+  kLoudnessInputShortTerm,
+  kLoudnessInputIntegrated,
+  kLoudnessOutputMomentary,
+  kLoudnessOutputShortTerm,
+  kLoudnessOutputIntegrated,
+  kLoudnessAutoGain,
+  kNumLoudnessReadings
+};
+
+// Editor readings sent by the meter job, each only when its script changed
+enum EMeterReadings
+{
+  kMeterQualityTier = 0,
+  kMeterNonFinite,
+  kMeterLoudness,
+  kMeterSpectrum,
+  kMeterDriveVU,
+  kNumMeterReadings
+};
+
+// Both return the page size as {"w":..,"h":..}; applyScale lays the page out
+// for the size it reports
+constexpr const char* kApplyScaleScript =
+  "(function(){if(window.applyScale){window.applyScale()}try{return JSON.stringify({w:window.innerWidth,h:window.innerHeight})}catch(e){return '{}'}})()";
+constexpr const char* kSizeQueryScript =
+  "(function(){try{return JSON.stringify({w:window.innerWidth,h:window.innerHeight})}catch(e){return '{}'}})()";
+
+// Reads the reply of kApplyScaleScript or kSizeQueryScript; false if it
+// holds no usable size
+inline bool ParseEditorSize(const char* json, double& width, double& height)
+{
+  if (!json)
+    return false;
+  const char* wpos = std::strstr(json, "\"w\":");
+  const char* hpos = std::strstr(json, "\"h\":");
+  if (!wpos || !hpos)
+    return false;
+  width = std::strtod(wpos + 4, nullptr);
+  height = std::strtod(hpos + 4, nullptr);
+  return width > 0.0 && height > 0.0;
+}
+
+// Sizes within a pixel are the same (the page reports CSS pixels)
+inline bool SameEditorSize(double width, double height, double otherWidth, double otherHeight)
+{
+  return std::abs(width - otherWidth) <= 1.0 && std::abs(height - otherHeight) <= 1.0;
+}
+
+class EditorMeters
+{
+public:
+  EditorMeters() { Reset(); }
+
+  // A new page: nothing has been sent to it yet
+  void Reset()
+  {
+    for (std::string& sent : mSent)
+      sent.clear();
+    mPending = 0;
+    mSpectrum = SpectrumAnalyser::Snapshot();
+    mSpectrum.topHz = -1.0f;  // differs from any result
+  }
+
+  void SetQualityTier(int tier)
+  {
+    mQualityTier = tier;
+    mPending |= 1u << kMeterQualityTier;
+  }
+
+  void SetNonFiniteEvents(uint32_t count)
+  {
+    mNonFiniteEvents = count;
+    mPending |= 1u << kMeterNonFinite;
+  }
+
+  void SetLoudness(const std::array<float, kNumLoudnessReadings>& values)
+  {
+    mLoudness = values;
+    mPending |= 1u << kMeterLoudness;
+  }
+
+  // A snapshot with the same displayed values is not sent again
+  void SetSpectrum(const SpectrumAnalyser::Snapshot& snapshot)
+  {
+    if (snapshot.SameReadings(mSpectrum))
+      return;
+    mSpectrum = snapshot;
+    mPending |= 1u << kMeterSpectrum;
+  }
+
+  void SetDriveVU(float value)
+  {
+    mDriveVU = value;
+    mPending |= 1u << kMeterDriveVU;
+  }
+
+  bool IsPending() const { return mPending != 0; }
+  float GetDriveVU() const { return mDriveVU; }
+
+  // Puts the scripts of the pending readings whose text changed into js, in
+  // EMeterReadings order, and returns those readings as a bit mask
+  unsigned Build(std::string& js)
+  {
+    js.clear();
+    unsigned changed = 0;
+    for (int reading = 0; reading < kNumMeterReadings; ++reading)
+    {
+      if (!(mPending & (1u << reading)))
+        continue;
+      Format(reading, mScript);
+      if (mScript == mSent[reading])
+        continue;
+      js += mScript;
+      mSent[reading].swap(mScript);
+      changed |= 1u << reading;
+    }
+    mPending = 0;
+    return changed;
+  }
+
+  // The script of one reading with its current value, pending or not
+  void Format(int reading, std::string& js) const
+  {
+    js.clear();
+    switch (reading)
+    {
+      case kMeterQualityTier:
+        AppendFormatted(js, "if(window.__updateQualityTier){window.__updateQualityTier(%d)}", mQualityTier);
+        break;
+      case kMeterNonFinite:
+        AppendFormatted(js, "if(window.__updateNonFiniteEvents){window.__updateNonFiniteEvents(%u)}", mNonFiniteEvents);
+        break;
+      case kMeterLoudness:
+        AppendFormatted(js,
+          "if(window.__updateLoudness){window.__updateLoudness({input:{momentary:%.2f,shortTerm:%.2f,integrated:%.2f},"
+          "output:{momentary:%.2f,shortTerm:%.2f,integrated:%.2f},autoGainDb:%.2f})}",
+          mLoudness[kLoudnessInputMomentary], mLoudness[kLoudnessInputShortTerm], mLoudness[kLoudnessInputIntegrated],
+          mLoudness[kLoudnessOutputMomentary], mLoudness[kLoudnessOutputShortTerm], mLoudness[kLoudnessOutputIntegrated],
+          mLoudness[kLoudnessAutoGain]);
+        break;
+      case kMeterSpectrum:
+        // Bands are log-spaced from SpectrumAnalyser::kMinHz to topHz
+        AppendFormatted(js, "if(window.__updateSpectrum){window.__updateSpectrum({minHz:%.0f,topHz:%.0f,input:[",
+          SpectrumAnalyser::kMinHz, mSpectrum.topHz);
+        for (int band = 0; band < SpectrumAnalyser::kNumBands; ++band)
+          AppendFormatted(js, band > 0 ? ",%.1f" : "%.1f", mSpectrum.input[band]);
+        js += "],output:[";
+        for (int band = 0; band < SpectrumAnalyser::kNumBands; ++band)
+          AppendFormatted(js, band > 0 ? ",%.1f" : "%.1f", mSpectrum.output[band]);
+        AppendFormatted(js, "],harmonics:{fundamentalHz:%.1f,secondDb:%.1f,thirdDb:%.1f,balanceDb:%.1f}})}",
+          mSpectrum.fundamentalHz, mSpectrum.secondDb, mSpectrum.thirdDb, mSpectrum.secondDb - mSpectrum.thirdDb);
+        break;
+      case kMeterDriveVU:
+        AppendFormatted(js, "if(window.__updateDriveVU){window.__updateDriveVU(%f)}", mDriveVU);
+        break;
+      default:
+        break;
+    }
+  }
+
+private:
+  static void AppendFormatted(std::string& js, const char* format, ...)
+  {
+    char text[512];
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    js += text;
+  }
+
+  unsigned mPending = 0;  // 1 << EMeterReadings
+  int mQualityTier = 0;
+  uint32_t mNonFiniteEvents = 0;
+  std::array<float, kNumLoudnessReadings> mLoudness {};
+  SpectrumAnalyser::Snapshot mSpectrum;
+  float mDriveVU = 0.0f;
+  std::string mScript;
+  std::array<std::string, kNumMeterReadings> mSent;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+// In-place radix-2 FFT for the editor's SpectrumAnalyser and the
+// measurements of lofi-render verify (tools/Spectrum.h). Accuracy over
+// speed; it never runs on the audio thread.
+
+#include <cmath>
+#include <complex>
+#include <utility>
+#include <vector>
+
+#include "TapeSaturatorDSP.h"
+
+namespace tapedsp
+{
+// x.size() must be a power of two
+inline void FFT(std::vector<std::complex<double>>& x)
+{
+  const size_t n = x.size();
+  for (size_t i = 1, j = 0; i < n; ++i)
+  {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1)
+      j ^= bit;
+    j ^= bit;
+    if (i < j)
+      std::swap(x[i], x[j]);
+  }
+
+  for (size_t len = 2; len <= n; len <<= 1)
+  {
+    const double angle = -kTwoPi / static_cast<double>(len);
+    const std::complex<double> step(std::cos(angle), std::sin(angle));
+    for (size_t start = 0; start < n; start += len)
+    {
+      std::complex<double> w(1.0, 0.0);
+      for (size_t k = 0; k < len / 2; ++k)
+      {
+        const std::complex<double> a = x[start + k];
+        const std::complex<double> b = x[start + k + len / 2] * w;
+        x[start + k] = a + b;
+        x[start + k + len / 2] = a - b;
+        w *= step;
+      }
+    }
+  }
+}
+} // namespace tapedsp
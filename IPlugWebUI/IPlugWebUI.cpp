@@ -2,185 +2,12 @@
 #include "IPlug_include_in_plug_src.h"
 #include "IPlugPaths.h"
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
 #include <cstring>
 #include <cstdlib>
 
-namespace
-{
-constexpr double kRandNorm = 1.0 / 4294967296.0; // 1 / 2^32
-
-inline double NextRandom(uint32_t& state)
-{
-  state ^= state << 13;
-  state ^= state >> 17;
-  state ^= state << 5;
-  return static_cast<double>(state) * kRandNorm;
-}
-}
-
-namespace
-{
-constexpr double kPi = 3.14159265358979323846;
-constexpr double kMinQ = 0.0001;
-
-inline void NormaliseBiquad(double& b0, double& b1, double& b2, double& a0, double& a1, double& a2)
-{
-  if (std::fabs(a0) < 1e-12)
-  {
-    b0 = 1.0;
-    b1 = b2 = a1 = a2 = 0.0;
-    return;
-  }
-  b0 /= a0;
-  b1 /= a0;
-  b2 /= a0;
-  a1 /= a0;
-  a2 /= a0;
-}
-}
-
-double BiquadFilter::Process(double input, int channel)
-{
-  const size_t idx = static_cast<size_t>(channel > 0 ? 1 : 0);
-  const double out = b0 * input + z1[idx];
-  z1[idx] = b1 * input - a1 * out + z2[idx];
-  z2[idx] = b2 * input - a2 * out;
-  return out;
-}
-
-void BiquadFilter::Reset()
-{
-  z1.fill(0.0);
-  z2.fill(0.0);
-}
-
-void BiquadFilter::SetLowShelf(double sampleRate, double freq, double gainDB, double q)
-{
-  if (sampleRate <= 0.0 || freq <= 0.0)
-  {
-    b0 = 1.0;
-    b1 = b2 = a1 = a2 = 0.0;
-    return;
-  }
-
-  const double A = std::pow(10.0, gainDB / 40.0);
-  const double w0 = 2.0 * kPi * freq / sampleRate;
-  const double cosw0 = std::cos(w0);
-  const double sinw0 = std::sin(w0);
-  const double alpha = sinw0 / (2.0 * std::max(q, kMinQ));
-  const double beta = 2.0 * std::sqrt(A) * alpha;
-
-  double a0 = (A + 1.0) + (A - 1.0) * cosw0 + beta;
-  double a1Tmp = -2.0 * ((A - 1.0) + (A + 1.0) * cosw0);
-  double a2Tmp = (A + 1.0) + (A - 1.0) * cosw0 - beta;
-  double b0Tmp = A * ((A + 1.0) - (A - 1.0) * cosw0 + beta);
-  double b1Tmp = 2.0 * A * ((A - 1.0) - (A + 1.0) * cosw0);
-  double b2Tmp = A * ((A + 1.0) - (A - 1.0) * cosw0 - beta);
-
-  b0 = b0Tmp;
-  b1 = b1Tmp;
-  b2 = b2Tmp;
-  a1 = a1Tmp;
-  a2 = a2Tmp;
-
-  NormaliseBiquad(b0, b1, b2, a0, a1, a2);
-}
-
-void BiquadFilter::SetHighShelf(double sampleRate, double freq, double gainDB, double q)
-{
-  if (sampleRate <= 0.0 || freq <= 0.0)
-  {
-    b0 = 1.0;
-    b1 = b2 = a1 = a2 = 0.0;
-    return;
-  }
-
-  const double A = std::pow(10.0, gainDB / 40.0);
-  const double w0 = 2.0 * kPi * freq / sampleRate;
-  const double cosw0 = std::cos(w0);
-  const double sinw0 = std::sin(w0);
-  const double alpha = sinw0 / (2.0 * std::max(q, kMinQ));
-  const double beta = 2.0 * std::sqrt(A) * alpha;
-
-  double a0 = (A + 1.0) - (A - 1.0) * cosw0 + beta;
-  double a1Tmp = 2.0 * ((A - 1.0) - (A + 1.0) * cosw0);
-  double a2Tmp = (A + 1.0) - (A - 1.0) * cosw0 - beta;
-  double b0Tmp = A * ((A + 1.0) + (A - 1.0) * cosw0 + beta);
-  double b1Tmp = -2.0 * A * ((A - 1.0) + (A + 1.0) * cosw0);
-  double b2Tmp = A * ((A + 1.0) + (A - 1.0) * cosw0 - beta);
-
-  b0 = b0Tmp;
-  b1 = b1Tmp;
-  b2 = b2Tmp;
-  a1 = a1Tmp;
-  a2 = a2Tmp;
-
-  NormaliseBiquad(b0, b1, b2, a0, a1, a2);
-}
-
-void BiquadFilter::SetPeaking(double sampleRate, double freq, double gainDB, double q)
-{
-  if (sampleRate <= 0.0 || freq <= 0.0)
-  {
-    b0 = 1.0;
-    b1 = b2 = a1 = a2 = 0.0;
-    return;
-  }
-
-  const double A = std::pow(10.0, gainDB / 40.0);
-  const double w0 = 2.0 * kPi * freq / sampleRate;
-  const double cosw0 = std::cos(w0);
-  const double sinw0 = std::sin(w0);
-  const double alpha = sinw0 / (2.0 * std::max(q, kMinQ));
-
-  double a0 = 1.0 + alpha / A;
-  double a1Tmp = -2.0 * cosw0;
-  double a2Tmp = 1.0 - alpha / A;
-  double b0Tmp = 1.0 + alpha * A;
-  double b1Tmp = -2.0 * cosw0;
-  double b2Tmp = 1.0 - alpha * A;
-
-  b0 = b0Tmp;
-  b1 = b1Tmp;
-  b2 = b2Tmp;
-  a1 = a1Tmp;
-  a2 = a2Tmp;
-
-  NormaliseBiquad(b0, b1, b2, a0, a1, a2);
-}
-
-void BiquadFilter::SetLowPass(double sampleRate, double freq, double resonance)
-{
-  if (sampleRate <= 0.0 || freq <= 0.0)
-  {
-    b0 = 1.0;
-    b1 = b2 = a1 = a2 = 0.0;
-    return;
-  }
-
-  const double w0 = 2.0 * kPi * freq / sampleRate;
-  const double cosw0 = std::cos(w0);
-  const double sinw0 = std::sin(w0);
-  const double alpha = sinw0 / (2.0 * std::max(resonance, kMinQ));
-
-  double a0 = 1.0 + alpha;
-  double a1Tmp = -2.0 * cosw0;
-  double a2Tmp = 1.0 - alpha;
-  double b0Tmp = (1.0 - cosw0) * 0.5;
-  double b1Tmp = 1.0 - cosw0;
-  double b2Tmp = (1.0 - cosw0) * 0.5;
-
-  b0 = b0Tmp;
-  b1 = b1Tmp;
-  b2 = b2Tmp;
-  a1 = a1Tmp;
-  a2 = a2Tmp;
-
-  NormaliseBiquad(b0, b1, b2, a0, a1, a2);
-}
-
 IPlugWebUI::IPlugWebUI(const InstanceInfo& info)
 : Plugin(info, MakeConfig(kNumParams, kNumPresets))
 {
@@ -210,7 +37,35 @@ IPlugWebUI::IPlugWebUI(const InstanceInfo& info)
   GetParam(kParamClipMode)->SetDisplayText(kClipModeTanh, "Tanh");
   GetParam(kParamClipSlope)->InitDouble("ClipSlope", 0.5, 0.0, 1.0, 0.001, "");
   GetParam(kParamPower)->InitBool("Power", true);
+  GetParam(kParamTruePeak)->InitBool("TruePeak", false);
+  GetParam(kParamAutoGain)->InitBool("AutoGain", false);
+  GetParam(kParamTruePeakLookahead)->InitDouble("TruePeakLookahead", 1.5, 0.0, 5.0, 0.1, "ms");
+  GetParam(kParamQualityMode)->InitEnum("QualityMode", kQualityModeAuto, kNumQualityModes);
+  GetParam(kParamQualityMode)->SetDisplayText(kQualityModeAuto, "Auto");
+  GetParam(kParamQualityMode)->SetDisplayText(kQualityModeHigh, "High");
+  GetParam(kParamQualityMode)->SetDisplayText(kQualityModeEco, "Eco");
+  GetParam(kParamQualityMode)->SetDisplayText(kQualityModeDraft, "Draft");
+  GetParam(kParamQualityTier)->InitEnum("QualityTier", kQualityTierHigh, kNumQualityTiers, "", IParam::kFlagCannotAutomate);
+  GetParam(kParamQualityTier)->SetDisplayText(kQualityTierHigh, "High");
+  GetParam(kParamQualityTier)->SetDisplayText(kQualityTierEco, "Eco");
+  GetParam(kParamQualityTier)->SetDisplayText(kQualityTierDraft, "Draft");
+  GetParam(kParamMachine)->InitEnum("Machine", kMachineStudio, kNumMachines);
+  GetParam(kParamMachine)->SetDisplayText(kMachineStudio, "Studio");
+  GetParam(kParamMachine)->SetDisplayText(kMachineCassette, "Cassette");
+  GetParam(kParamMachine)->SetDisplayText(kMachineCart, "Cart");
+  GetParam(kParamMachine)->SetDisplayText(kMachineSampler, "Sampler");
+  GetParam(kParamBands)->InitInt("Bands", 1, 1, 4, "bands");
+  GetParam(kParamCrossoverLow)->InitFrequency("CrossoverLow", 250.0, 40.0, 1000.0, 1.0);
+  GetParam(kParamCrossoverMid)->InitFrequency("CrossoverMid", 1800.0, 300.0, 6000.0, 1.0);
+  GetParam(kParamCrossoverHigh)->InitFrequency("CrossoverHigh", 7000.0, 2000.0, 16000.0, 1.0);
+  // Per band: drive offset added to DriveGain, sag depth multiplier
+  for (int band = 0; band < 4; ++band)
+  {
+    GetParam(kParamBandDrive1 + band)->InitDouble(GetTapeParamSpec(kParamBandDrive1 + band).name, 0.0, -1.0, 1.0, 0.001, "");
+    GetParam(kParamBandSag1 + band)->InitDouble(GetTapeParamSpec(kParamBandSag1 + band).name, 1.0, 0.0, 2.0, 0.01, "x");
+  }
 
+#if LOFI_WEB_EDITOR
 #ifdef DEBUG
   SetEnableDevTools(true);
 #endif
@@ -231,7 +86,9 @@ IPlugWebUI::IPlugWebUI(const InstanceInfo& info)
     // Let the WebView fill the editor via WebViewEditorDelegate; avoid manual bounds
     EnableScroll(true);
   };
+#endif
 
+  // Only stores the values; the DSP designs its filters in OnReset
   for (int i = 0; i < kNumParams; ++i)
     OnParamChange(i);
   
@@ -239,352 +96,161 @@ IPlugWebUI::IPlugWebUI(const InstanceInfo& info)
 
 void IPlugWebUI::ProcessBlock(sample** inputs, sample** outputs, int nFrames)
 {
+  const auto blockStart = std::chrono::steady_clock::now();
   const int nIn = NInChansConnected();
   const int nOut = NOutChansConnected();
-  const int channels = std::min(nIn, nOut);
+  const int channels = std::min({nIn, nOut, TapeSaturatorDSP::kMaxChannels});
 
-  // === SMOOTH POWER/BYPASS ===
-  // Smooth ramp to avoid clicks: 0.0 = fully bypassed, 1.0 = fully active
-  const double targetRamp = mPowerOn ? 1.0 : 0.0;
-  const double rampSpeed = 0.02; // Faster response to power toggles
-  
-  if (std::abs(mBypassRamp - targetRamp) < 0.0001)
+  // VST3 delivers one queue per parameter; the cores expect frame order
+  for (int i = 1; i < mNumParamEvents; ++i)
   {
-    mBypassRamp = targetRamp;
+    const TapeParamEvent event = mParamEvents[i];
+    int j = i;
+    for (; j > 0 && mParamEvents[j - 1].offset > event.offset; --j)
+      mParamEvents[j] = mParamEvents[j - 1];
+    mParamEvents[j] = event;
   }
-  else
+
+  mBlockInputs = inputs;
+  mBlockOutputs = outputs;
+  mBlockFrames = nFrames;
+
+#if LOFI_WEB_EDITOR
+  // Only metered and captured for the analyser while the editor is open; the
+  // readings start over each time it opens. Input before rendering, in case
+  // the host processes in place.
+  const bool capture = mUIOpen.load(std::memory_order_acquire);
+  if (capture)
   {
-    mBypassRamp += (targetRamp - mBypassRamp) * rampSpeed;
+    if (!mMeteringLoudness)
+      mLoudnessMeter.Reset(GetSampleRate());
+    mLoudnessMeter.Process(LoudnessMeter::kSideInput, inputs, nFrames, 0, channels);
+    mCapture.WriteInput(inputs, nFrames, channels);
   }
-  
-  // If fully bypassed, just copy input to output
-  if (mBypassRamp < 0.0001)
+  mMeteringLoudness = capture;
+#endif
+
+#if defined CLAP_API
+  // One task per channel, on the host's workers when it grants the thread
+  // pool for this block, otherwise here in turn
+  mCoreProcessed.fill(false);
+  if (channels < 2 || !_host.canUseThreadPool() || !_host.threadPoolRequestExec(static_cast<uint32_t>(channels)))
   {
     for (int c = 0; c < channels; ++c)
-    {
-      std::copy(inputs[c], inputs[c] + nFrames, outputs[c]);
-    }
-    return;
+      threadPoolExec(static_cast<uint32_t>(c));
   }
 
-  // Signal flow: Input → Drive/Transformer → Tone → Bit Reduction → Resampler → Wow/Flutter → Low-pass → Dry/Wet → Clipper → Output
-  float drivePeak = 0.0f;
-
-  // Cache drive gain smoothing (convert 0..1 → dB up to +24dB headroom)
-  const double driveLinear = std::clamp(mDriveSmoother.Process(mDriveGain), 0.0, 1.0);
-  const double preampDb = driveLinear * 30.0 - 4.0; // gently biased boost emulating transformer input
-  const double driveGain = std::pow(10.0, preampDb / 20.0);
-
-  // Transformer-inspired dynamic coefficients
-  const double sagCoeff = std::clamp(0.992 - driveLinear * 0.028, 0.9, 0.999);
-  const double biasFollowCoeff = 0.982;
-  const double asymmetryBase = 0.02 + driveLinear * 0.09;
-  const double evenEnhancer = 0.35 + driveLinear * 0.4;
-  const double triodeAmount = 1.15 + driveLinear * 1.3;
-  const double oddBlend = 0.45 + driveLinear * 0.25;
-  const double finalSaturation = 0.95 + driveLinear * 1.2;
-
-  // Gentle HF roll-off for transformer-like sheen
-  constexpr double twoPi = 6.28318530717958647693;
-  const double sampleRate = std::max(GetSampleRate(), 1.0);
-  const double lowpassHz = std::clamp(16000.0 - driveLinear * 5500.0, 8000.0, 18000.0);
-  const double lpAlpha = std::exp(-twoPi * lowpassHz / sampleRate);
-  const double lpComp = 1.0 - lpAlpha;
-  const int bits = std::clamp(mMpcBits, 1, 16);
-  // bitLevels removed - was unused
-  const double bitTransientGain = 3.0 + (16 - bits) * 0.45;
-  const double bitTransientMix = 0.015 + (16 - bits) * 0.02;
-  const double resampleRatio = std::clamp(mResampleRatio, 0.25, 4.0);
-  const double aliasBase = std::clamp(0.05 + (1.0 - std::min(resampleRatio, 1.0)) * 0.6, 0.0, 0.8);
-  const double wowDepthSamples = std::max(0.0, mWowAmount) * (0.0032 * sampleRate);
-  // INCREASED FLUTTER DEPTH for more noticeable effect (was 0.0009, now 0.0025)
-  const double flutterDepthSamples = std::max(0.0, mFlutterAmount) * (0.0025 * sampleRate);
-  const double baseDelaySamples = std::max(12.0, sampleRate * 0.0012);
-  const double noiseAmount = std::clamp(mNoiseLevel, 0.0, 1.0);
-
-  for (int s = 0; s < nFrames; ++s)
+  // Idle cores still follow the automation
+  for (int c = channels; c < kNumDSPCores; ++c)
   {
-    const double wowValue = std::sin(mWowPhase);
-    const double flutterValue = std::sin(mFlutterPhase);
-    mWowPhase += mWowPhaseInc;
-    if (mWowPhase > twoPi)
-      mWowPhase -= twoPi;
-    mFlutterPhase += mFlutterPhaseInc;
-    if (mFlutterPhase > twoPi)
-      mFlutterPhase -= twoPi;
-
-    const double modDelay = baseDelaySamples + wowValue * wowDepthSamples + flutterValue * flutterDepthSamples;
-    const double clampedDelay = std::clamp(modDelay, 1.0, static_cast<double>(kWowBufferSize - 3));
-    // INCREASED FLUTTER PITCH INFLUENCE for more noticeable tape-like effect (was 0.05, now 0.18)
-    const double pitchInfluence = wowValue * mWowAmount * 0.12 + flutterValue * mFlutterAmount * 0.18;
-
-    for (int c = 0; c < channels; ++c)
-    {
-      double inputSample = inputs[c][s];
-      double processed = inputSample;
-
-      // === PREAMP / DRIVE ===
-      processed *= driveGain;
-
-      double rectified = std::fabs(processed);
-      double& sagState = mTransformerSaturation[c];
-      sagState = sagCoeff * sagState + (1.0 - sagCoeff) * rectified;
-
-      const double sagCompression = 1.0 / (1.0 + sagState * (0.35 + driveLinear * 0.45));
-      processed *= sagCompression;
-
-      const double polarity = processed >= 0.0 ? 1.0 : -1.0;
-      double biasTarget = asymmetryBase * sagState * polarity;
-      double& biasState = mTransformerBias[c];
-      biasState = biasFollowCoeff * biasState + (1.0 - biasFollowCoeff) * biasTarget;
-
-      const double transformerInput = processed + biasState * (0.65 + driveLinear * 0.25);
-
-      // Transformer-style asymmetric saturation encourages even harmonics
-      const double evenStage = transformerInput + evenEnhancer * transformerInput * std::fabs(transformerInput);
-      const double triodeStage = std::tanh(evenStage * triodeAmount);
-
-      const double oddStageInput = transformerInput * (1.0 + driveLinear * 0.25);
-      const double oddStage = oddStageInput - (oddStageInput * oddStageInput * oddStageInput) * (0.22 + driveLinear * 0.18);
-
-      processed = oddBlend * triodeStage + (1.0 - oddBlend) * oddStage;
-      processed = std::tanh(processed * finalSaturation);
-      processed -= biasState * 0.55; // remove DC introduced by transformer bias
-
-      // Single-pole low-pass for transformer coil roll-off
-    double& lpState = mTransformerLowpass[c];
-    lpState = lpAlpha * lpState + lpComp * processed;
-    processed = lpState;
-
-    drivePeak = std::max(drivePeak, static_cast<float>(std::fabs(processed)));
-
-      // === TONE: Studer A800-inspired curve ===
-      double toneProcessed = processed;
-      toneProcessed = mToneLowShelf.Process(toneProcessed, c);
-      toneProcessed = mToneMidBell.Process(toneProcessed, c);
-      toneProcessed = mToneHighShelf.Process(toneProcessed, c);
-
-      double detector = std::fabs(toneProcessed);
-      double& env = mToneEnvelope[c];
-      if (detector > env)
-        env = mToneAttackCoeff * env + (1.0 - mToneAttackCoeff) * detector;
-      else
-        env = mToneReleaseCoeff * env + (1.0 - mToneReleaseCoeff) * detector;
-
-      const double compression = 1.0 / (1.0 + env * (0.28 + driveLinear * 0.22));
-      const double compressed = toneProcessed * compression;
-      const double tapeSaturation = std::tanh(compressed * (1.25 + driveLinear * 0.35));
-      processed = (1.0 - mToneSaturationMix) * compressed + mToneSaturationMix * tapeSaturation;
-
-      // === MPC BIT REDUCTION ===
-      // Apply bit reduction for all bit depths (including 16-bit)
-      // Use proper bit depth calculation: for N bits, we have 2^N levels
-      const double maxLevel = static_cast<double>((1 << bits) - 1);
-      const double scaled = (processed + 1.0) * 0.5 * maxLevel; // Map -1..1 to 0..maxLevel
-      const double quantized = (std::floor(scaled + 0.5) / maxLevel) * 2.0 - 1.0; // Quantize and map back to -1..1
-      
-      double transient = processed - mMpcPrevSample[c];
-      double transientShape = std::tanh(transient * bitTransientGain);
-      mMpcPrevSample[c] = quantized;
-      processed = quantized + transientShape * bitTransientMix;
-
-      // === RESAMPLER (aliasing sample & hold) ===
-      double& phase = mResamplePhase[c];
-      double& hold = mResampleHold[c];
-      if (phase <= 0.0)
-        hold = processed;
-
-      double step = std::max(0.05, resampleRatio + pitchInfluence);
-      phase += step;
-      if (phase >= 1.0)
-      {
-        phase -= std::floor(phase);
-        hold = processed;
-      }
-
-      const double aliasBlend = std::clamp(aliasBase + std::fabs(pitchInfluence) * 0.25, 0.0, 0.85);
-      processed = hold + (processed - hold) * aliasBlend;
-
-      // === WOW & FLUTTER DELAYED PLAYBACK ===
-      auto& buffer = mWowBuffer[c];
-      int& writeIdx = mWowWriteIndex[c];
-      buffer[writeIdx] = processed;
-
-      double readPos = static_cast<double>(writeIdx) - clampedDelay;
-      while (readPos < 0.0)
-        readPos += static_cast<double>(kWowBufferSize);
-
-      const int idxA = static_cast<int>(readPos) % kWowBufferSize;
-      const int idxB = (idxA + 1) % kWowBufferSize;
-      const double frac = readPos - static_cast<double>(idxA);
-      const double delayed = buffer[idxA] + (buffer[idxB] - buffer[idxA]) * frac;
+    for (int i = 0; i < mNumParamEvents; ++i)
+      mDSP[c].SetParam(mParamEvents[i].paramIdx, mParamEvents[i].value);
+  }
+  const bool processed = std::find(mCoreProcessed.begin(), mCoreProcessed.begin() + channels, true) != mCoreProcessed.begin() + channels;
+#else
+  const bool processed = RenderChannels(0, channels);
+#endif
+  mNumParamEvents = 0;
 
-      writeIdx = (writeIdx + 1) % kWowBufferSize;
-      processed = delayed;
+#if LOFI_WEB_EDITOR
+  if (capture)
+  {
+    mLoudnessMeter.Process(LoudnessMeter::kSideOutput, outputs, nFrames, 0, channels);
+    SendLoudness();
+    mCapture.WriteOutput(outputs, nFrames, channels);
+  }
+#endif
 
-      // === LOW-PASS SMOOTHER ===
-      processed = mLowPassFilter.Process(processed, c);
+  // Blocks the DSP sentinel recovered from NaN/Inf; reported by OnIdle
+  uint32_t nonFiniteEvents = 0;
+  for (const auto& dsp : mDSP)
+    nonFiniteEvents += dsp.GetNonFiniteEvents();
+  mNonFiniteEvents.store(nonFiniteEvents, std::memory_order_relaxed);
 
-      // === VINYL NOISE GENERATOR (IMPROVED) ===
-      if (noiseAmount > 0.0)
-      {
-        uint32_t& seed = mNoiseSeeds[c];
-        const double white = NextRandom(seed) - 0.5;
-        
-        // Hiss component - more gentle high-frequency roll-off
-        double& hissState = mNoiseFilter[c];
-        hissState = 0.96 * hissState + 0.04 * white; // Softer filtering
-        const double hissGain = noiseAmount * 0.25; // Reduced gain
-        const double hiss = (0.8 * hissState + 0.2 * white) * hissGain;
-        
-        // Apply dedicated LPF to reduce harshness (around 6kHz)
-        const double filteredHiss = mNoiseLowPassFilter.Process(hiss, c);
-
-        // Crackle/Pop component - more realistic vinyl behavior
-        double crackle = 0.0;
-        double& env = mCrackleEnvelope[c];
-        int& cooldown = mCrackleCooldown[c];
-        if (cooldown <= 0)
-        {
-          // Much lower trigger probability for subtle vinyl effect
-          const double triggerProbability = 0.000008 + noiseAmount * 0.00015;
-          if (NextRandom(seed) < triggerProbability)
-          {
-            // REDUCED: Much lower intensity for crackle peaks (was 0.6-1.2, now 0.15-0.35)
-            env = 0.15 + NextRandom(seed) * 0.2;
-            // Longer cooldown for more spaced-out pops
-            cooldown = std::max(1, static_cast<int>(sampleRate * (0.04 + NextRandom(seed) * 0.12)));
-          }
-        }
-        else
-        {
-          --cooldown;
-        }
-
-        if (env > 0.0001)
-        {
-          const double pop = NextRandom(seed) * 2.0 - 1.0;
-          // REDUCED: Much lower crackle gain (was 0.3-1.0, now 0.08-0.25)
-          crackle = pop * env * (0.08 + noiseAmount * 0.17);
-          // Slower decay for more natural sound
-          env *= 0.65 + noiseAmount * 0.15;
-          if (env < 0.00005)
-            env = 0.0;
-        }
-
-        // Apply LPF to crackle as well to reduce harshness
-        const double filteredCrackle = mNoiseLowPassFilter.Process(crackle, c);
-        
-        processed += filteredHiss + filteredCrackle;
-      }
+  if (processed)
+  {
+    // pass-through additional outputs if any
+    for (int c = channels; c < nOut; ++c)
+      std::fill(outputs[c], outputs[c] + nFrames, 0.0);
 
-      // DRY/WET removed - now 100% wet with output gain control
+    float drivePeak = 0.0f;
+    for (const auto& dsp : mDSP)
+      drivePeak = std::max(drivePeak, dsp.GetDrivePeak());
+    SendDriveVUMeter(drivePeak);
+  }
 
-      // === CLIPPER ===
-      const double threshold = std::max(0.0001, mClipThreshold);
-      double clipped = processed;
-      if (mClipMode == kClipModeHard)
-      {
-        clipped = std::max(-threshold, std::min(processed, threshold));
-      }
-      else if (mClipMode == kClipModeSoft)
-      {
-        const double slope = std::clamp(mClipSlope, 0.0, 1.0);
-        const double softLimit = threshold * (1.0 + slope);
-        if (processed > threshold)
-        {
-          clipped = threshold + (processed - threshold) / (1.0 + slope * (processed - threshold));
-          clipped = std::min(clipped, softLimit);
-        }
-        else if (processed < -threshold)
-        {
-          clipped = -threshold + (processed + threshold) / (1.0 + slope * (-processed - threshold));
-          clipped = std::max(clipped, -softLimit);
-        }
-      }
-      else // tanh
-      {
-        clipped = threshold * std::tanh(processed / threshold);
-      }
+  const double elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - blockStart).count();
+  UpdateQualityTier(elapsedSec, nFrames);
+}
 
-      // Apply output gain and smooth bypass crossfade
-      const double wetSignal = clipped;
-      const double drySignal = inputSample;
-      const double mixedOutput = drySignal * (1.0 - mBypassRamp) + wetSignal * mBypassRamp;
-      
-      // Apply output gain to final mixed signal
-      const double finalOutput = mixedOutput * mOutputGainLinear;
+// Renders channels [firstChan, lastChan) of the current block, applying the
+// queued automation at its frames
+bool IPlugWebUI::RenderChannels(int firstChan, int lastChan)
+{
+  TapeSaturatorDSP& dsp = mDSP[kNumDSPCores > 1 ? firstChan : 0];
+  return dsp.ProcessChannels(mBlockInputs, mBlockOutputs, mBlockFrames, firstChan, lastChan, mParamEvents.data(), mNumParamEvents);
+}
 
-      outputs[c][s] = static_cast<sample>(finalOutput);
+#if defined CLAP_API
+void IPlugWebUI::threadPoolExec(uint32_t taskIndex) noexcept
+{
+  const int channel = static_cast<int>(taskIndex);
+  mCoreProcessed[channel] = RenderChannels(channel, channel + 1);
+}
+#endif
 
-      (void) c; // VU metering already captured after drive stage
-    }
+int IPlugWebUI::GetRequestedQualityTier() const
+{
+  // Offline renders always run at full quality
+  if (GetRenderingOffline())
+    return kQualityTierHigh;
+
+  const int mode = mQualityMode.load(std::memory_order_relaxed);
+  if (mode == kQualityModeAuto)
+    return mGovernor.GetTier();
+  return mode - kQualityModeHigh;
+}
 
-    // pass-through additional outputs if any
-    for (int c = channels; c < nOut; ++c)
-      outputs[c][s] = 0.0;
-  }
+void IPlugWebUI::UpdateQualityTier(double elapsedSec, int nFrames)
+{
+  mGovernor.Update(elapsedSec, nFrames, GetSampleRate(), kNumQualityTiers);
+  mGovernorLoad.store(static_cast<float>(mGovernor.GetLoad()), std::memory_order_relaxed);
 
-  // Update peak with decay (approx 300ms)
-  const float decayFactor = 0.9f;
-  mLastPeak = std::max(drivePeak, mLastPeak * decayFactor);
+  const int tier = GetRequestedQualityTier();
+  if (tier == mDSP[0].GetQualityTier())
+    return;
 
-  SendDriveVUMeter(mLastPeak);
+  for (auto& dsp : mDSP)
+    dsp.SetQualityTier(tier);
+  mQualityTier.store(tier, std::memory_order_release);
+  mQualityTierQueued.store(true, std::memory_order_release);
 }
 
 void IPlugWebUI::OnReset()
 {
   auto sr = GetSampleRate();
   mOscillator.SetSampleRate(sr);
-  mDriveSmoother.SetSmoothTime(5., sr);
-  mDriveSmoother.SetValue(mDriveGain);
-  mLastPeak = 0.0f;
   mDriveVUQueued.store(false, std::memory_order_release);
   mPendingDriveVU.store(0.0f, std::memory_order_release);
-  mTransformerSaturation.fill(0.0);
-  mTransformerBias.fill(0.0);
-  mTransformerLowpass.fill(0.0);
-  mToneEnvelope.fill(0.0);
-
-  const double sampleRate = std::max(sr, 1.0);
-  const double attackTime = 0.004;  // ~4ms attack for tape compression
-  const double releaseTime = 0.12;  // ~120ms release mimicking tape recovery
-  mToneAttackCoeff = std::exp(-1.0 / (attackTime * sampleRate));
-  mToneReleaseCoeff = std::exp(-1.0 / (releaseTime * sampleRate));
-  mToneSaturationMix = 0.32;
-
-  mToneLowShelf.Reset();
-  mToneHighShelf.Reset();
-  mToneMidBell.Reset();
-  UpdateToneFilters();
-  mLowPassFilter.Reset();
-  UpdateLowPassFilter();
-  
-  // Initialize dedicated noise LPF at 6kHz for softer vinyl sound
-  mNoiseLowPassFilter.Reset();
-  mNoiseLowPassFilter.SetLowPass(sampleRate, 6000.0, 0.7);
-
-  mResamplePhase.fill(0.0);
-  mResampleHold.fill(0.0);
-  mMpcPrevSample.fill(0.0);
-  mNoiseFilter.fill(0.0);
-  mCrackleEnvelope.fill(0.0);
-  mCrackleCooldown.fill(0);
-  const uint32_t baseSeed = static_cast<uint32_t>(std::max(1.0, sr)) ^ 0x9E3779B9u;
-  mNoiseSeeds[0] ^= (baseSeed | 1u);
-  mNoiseSeeds[1] ^= ((baseSeed << 16) | 1u);
-  for (auto& seed : mNoiseSeeds)
+  mGovernor.Reset();
+#if LOFI_WEB_EDITOR
+  mLoudnessMeter.Reset(sr);
+  mCapture.Reset(sr);
+#endif
+  const int tier = GetRequestedQualityTier();
+  for (auto& dsp : mDSP)
   {
-    if (seed == 0)
-      seed = 1u;
+    // Automation left over from an interrupted block takes effect now
+    for (int i = 0; i < mNumParamEvents; ++i)
+      dsp.SetParam(mParamEvents[i].paramIdx, mParamEvents[i].value);
+    dsp.SetQualityTier(tier);
+    dsp.Reset(sr);
   }
-
-  for (auto& buffer : mWowBuffer)
-    buffer.fill(0.0);
-  mWowWriteIndex.fill(0);
-  mWowPhase = 0.0;
-  mFlutterPhase = 0.0;
-  RefreshWowFlutterIncrements();
+  mNumParamEvents = 0;
+  mQualityTier.store(mDSP[0].GetQualityTier(), std::memory_order_release);
+  mQualityTierQueued.store(true, std::memory_order_release);
+  SetLatency(mDSP[0].GetLatencySamples());
+  mLatencyChanged.store(false, std::memory_order_release);
 }
 
 void IPlugWebUI::SendDriveVUMeter(float linearValue)
@@ -594,129 +260,145 @@ void IPlugWebUI::SendDriveVUMeter(float linearValue)
   mDriveVUQueued.store(true, std::memory_order_release);
 }
 
-void IPlugWebUI::UpdateToneFilters()
+#if LOFI_WEB_EDITOR
+// Queues the readings only when one of them moved at the displayed precision
+void IPlugWebUI::SendLoudness()
 {
-  const double sampleRate = std::max(GetSampleRate(), 1.0);
-  const double lowShelfGain = 1.5 + mToneLowGain;
-  const double lowShelfQ = 0.74;
-  const double highShelfGain = -1.75 + mToneHighGain;
-  const double highShelfQ = 0.8;
-  const double midGainDb = 0.6 + (mToneMidQ - 1.0) * 2.0;
-  const double midQ = std::clamp(1.1 + (mToneMidQ - 1.0) * 0.7, 0.4, 3.0);
-
-  mToneLowShelf.SetLowShelf(sampleRate, 110.0, lowShelfGain, lowShelfQ);
-  mToneHighShelf.SetHighShelf(sampleRate, 12500.0, highShelfGain, highShelfQ);
-  mToneMidBell.SetPeaking(sampleRate, 3800.0, midGainDb, midQ);
-}
+  using Side = LoudnessMeter::ESide;
+  const Side sides[] = {LoudnessMeter::kSideInput, LoudnessMeter::kSideOutput};
+  double values[kNumLoudnessReadings];
+  for (int i = 0; i < 2; ++i)
+  {
+    values[kLoudnessInputMomentary + 3 * i] = mLoudnessMeter.GetMomentary(sides[i]);
+    values[kLoudnessInputShortTerm + 3 * i] = mLoudnessMeter.GetShortTerm(sides[i]);
+    values[kLoudnessInputIntegrated + 3 * i] = mLoudnessMeter.GetIntegrated(sides[i]);
+  }
 
-void IPlugWebUI::UpdateLowPassFilter()
-{
-  const double sampleRate = std::max(GetSampleRate(), 1.0);
-  const double nyquist = sampleRate * 0.5;
-  const double cutoff = std::clamp(mLowPassCutoff, 20.0, nyquist * 0.98);
-  const double resonance = std::clamp(mLowPassResonance, 0.3, 8.0);
-  mLowPassFilter.SetLowPass(sampleRate, cutoff, resonance);
-}
+  // Mean over the channels; each CLAP core compensates its own channel
+  double gainDb = 0.0;
+  for (int c = 0; c < TapeSaturatorDSP::kMaxChannels; ++c)
+    gainDb += mDSP[kNumDSPCores > 1 ? c : 0].GetCompensationDb(c);
+  values[kLoudnessAutoGain] = gainDb / TapeSaturatorDSP::kMaxChannels;
 
-void IPlugWebUI::RefreshWowFlutterIncrements()
-{
-  const double sampleRate = std::max(GetSampleRate(), 1.0);
-  const double wowRate = std::clamp(mWowRate, 0.05, 5.0);
-  const double flutterRate = std::clamp(mFlutterRate, 1.0, 40.0);
-  mWowPhaseInc = (2.0 * kPi * wowRate) / sampleRate;
-  mFlutterPhaseInc = (2.0 * kPi * flutterRate) / sampleRate;
+  bool changed = false;
+  for (int i = 0; i < kNumLoudnessReadings; ++i)
+  {
+    const float value = static_cast<float>(std::round(values[i] * 100.0) / 100.0);
+    if (value == mLoudness[i].load(std::memory_order_relaxed))
+      continue;
+    mLoudness[i].store(value, std::memory_order_relaxed);
+    changed = true;
+  }
+  if (changed)
+    mLoudnessQueued.store(true, std::memory_order_release);
 }
+#endif
 
 void IPlugWebUI::OnIdle()
 {
   Plugin::OnIdle();
-#if IPLUG_EDITOR
-  if (!mUIOpen.load(std::memory_order_acquire))
-    return;
 
-  // Periodically trigger responsive layout from C++ side
-  static int sScaleCounter = 0;
-  if ((++sScaleCounter % 60) == 0) // roughly every ~60 idle ticks
+  // True-peak mode changes the latency; report it from the main thread
+  if (mLatencyChanged.exchange(false, std::memory_order_acq_rel))
+    SetLatency(mDSP[0].GetLatencySamples());
+
+  if (mQualityTierQueued.exchange(false, std::memory_order_acq_rel))
   {
-    EvaluateJavaScript("if(window.applyScale){window.applyScale()}");
+    const int tier = mQualityTier.load(std::memory_order_acquire);
+    GetParam(kParamQualityTier)->Set(static_cast<double>(tier));
+    DBGMSG("Quality tier %d (load %.2f)\n", tier, mGovernorLoad.load(std::memory_order_relaxed));
+#if LOFI_WEB_EDITOR
+    mEditorJobs.GetMeters().SetQualityTier(tier);
+#endif
   }
 
-  // Verify wrapper size and correct if host opened too small (e.g., FL Studio at 25%)
-  static int sVerifyCounter = 0;
-  if (mVerifySizePending.load(std::memory_order_acquire))
+  const uint32_t nonFiniteEvents = mNonFiniteEvents.load(std::memory_order_relaxed);
+  if (nonFiniteEvents != mReportedNonFiniteEvents)
   {
-    if ((++sVerifyCounter % 30) == 0 && mVerifyAttempts < 3)
-    {
-      ++mVerifyAttempts;
-      EvaluateJavaScript(
-        "(function(){try{return JSON.stringify({w:window.innerWidth,h:window.innerHeight})}catch(e){return '{}'}})()",
-        [this](const char* json){
-          if (!json) return;
-          const char* wpos = std::strstr(json, "\"w\":");
-          const char* hpos = std::strstr(json, "\"h\":");
-          if (!wpos || !hpos) return;
-          const double w = std::strtod(wpos+4, nullptr);
-          const double h = std::strtod(hpos+4, nullptr);
-          if (w <= 0.0 || h <= 0.0) return;
-          const double targetW = 250.0, targetH = 350.0;
-          const double dw = std::abs(w - targetW);
-          const double dh = std::abs(h - targetH);
-          if (dw > 1.0 || dh > 1.0)
-          {
-            // Keep wrapper at the intended fixed size; avoid oversizing the host
-            Resize(static_cast<int>(targetW), static_cast<int>(targetH));
-          }
-          else
-          {
-            mVerifySizePending.store(false, std::memory_order_release);
-          }
-        }
-      );
-      if (mVerifyAttempts >= 3)
-        mVerifySizePending.store(false, std::memory_order_release);
-    }
+    mReportedNonFiniteEvents = nonFiniteEvents;
+    DBGMSG("Recovered from NaN/Inf in %u blocks\n", nonFiniteEvents);
+#if LOFI_WEB_EDITOR
+    mEditorJobs.GetMeters().SetNonFiniteEvents(nonFiniteEvents);
+#endif
+  }
+
+  const uint32_t paramEventOverflows = mParamEventOverflows.load(std::memory_order_relaxed);
+  if (paramEventOverflows != mReportedParamEventOverflows)
+  {
+    mReportedParamEventOverflows = paramEventOverflows;
+    DBGMSG("%u automation events merged into a full queue\n", paramEventOverflows);
   }
 
-  if (!mDriveVUQueued.exchange(false, std::memory_order_acq_rel))
+#if LOFI_WEB_EDITOR
+  if (!mUIOpen.load(std::memory_order_acquire))
     return;
 
-  const float value = mPendingDriveVU.load(std::memory_order_acquire);
+  // The meter job sends what changed; anything new from the audio thread or
+  // the analyser triggers it
+  EditorMeters& meters = mEditorJobs.GetMeters();
+  SpectrumAnalyser::Snapshot spectrum;
+  if (mAnalyser.TakeSnapshot(spectrum))
+    meters.SetSpectrum(spectrum);
+  if (mLoudnessQueued.exchange(false, std::memory_order_acq_rel))
+  {
+    std::array<float, kNumLoudnessReadings> values;
+    for (int i = 0; i < kNumLoudnessReadings; ++i)
+      values[i] = mLoudness[i].load(std::memory_order_relaxed);
+    meters.SetLoudness(values);
+  }
+  if (mDriveVUQueued.exchange(false, std::memory_order_acq_rel))
+    meters.SetDriveVU(mPendingDriveVU.load(std::memory_order_acquire));
 
-  WDL_String js;
-  js.SetFormatted(128, "if(window.__updateDriveVU){window.__updateDriveVU(%f)}", value);
-  EvaluateJavaScript(js.Get());
-  GetParam(kParamDriveVU)->Set(static_cast<double>(value));
+  mEditorJobs.Tick(*this);
 #endif
 }
 
-#if IPLUG_EDITOR
+#if LOFI_WEB_EDITOR
+void IPlugWebUI::OnMetersSent(unsigned changed)
+{
+  if (changed & (1u << kMeterDriveVU))
+    GetParam(kParamDriveVU)->Set(static_cast<double>(mEditorJobs.GetMeters().GetDriveVU()));
+}
+
 void IPlugWebUI::OnUIOpen()
 {
   Plugin::OnUIOpen();
+  mAnalyser.Start(mCapture);
   mUIOpen.store(true, std::memory_order_release);
+
+  // A new page: every reading is sent again, layout and size are checked
+  // once it has loaded. Force host container to match fixed 50% GUI size
+  // (250x350).
+  mEditorJobs.Open(*this);
+  mEditorJobs.GetMeters().SetQualityTier(mQualityTier.load(std::memory_order_acquire));
+  mEditorJobs.GetMeters().SetNonFiniteEvents(mReportedNonFiniteEvents);
   mDriveVUQueued.store(true, std::memory_order_release);
-  // Force host container to match fixed 50% GUI size (250x350)
-  Resize(250, 350);
-  mVerifySizePending.store(true, std::memory_order_release);
-  mVerifyAttempts = 0;
+  mLoudnessQueued.store(true, std::memory_order_release);
 }
 
 void IPlugWebUI::OnUIClose()
 {
   mUIOpen.store(false, std::memory_order_release);
+  mAnalyser.Stop();
+  mEditorJobs.Close();
   Plugin::OnUIClose();
 }
 #endif
 
 bool IPlugWebUI::OnMessage(int msgTag, int ctrlTag, int dataSize, const void* pData)
 {
+#if LOFI_WEB_EDITOR
   if (msgTag == kMsgTagButton1)
-    Resize(512, 335);
+    mEditorJobs.Resize(*this, 512, 335);
   else if(msgTag == kMsgTagButton2)
-    Resize(1024, 335);
+    mEditorJobs.Resize(*this, 1024, 335);
   else if(msgTag == kMsgTagButton3)
-    Resize(1024, 768);
-  else if (msgTag == kMsgTagBinaryTest)
+    mEditorJobs.Resize(*this, 1024, 768);
+  else if (msgTag == kMsgTagEditorResized)
+    mEditorJobs.OnPageResized();
+  else
+#endif
+  if (msgTag == kMsgTagBinaryTest)
   {
     // Use the data parameter to avoid warning
     (void)pData;
@@ -731,75 +413,62 @@ bool IPlugWebUI::OnMessage(int msgTag, int ctrlTag, int dataSize, const void* pD
 
 void IPlugWebUI::OnParamChange(int paramIdx)
 {
-  switch (paramIdx)
+  if (paramIdx == kParamDriveVU || paramIdx == kParamQualityTier)
+    return; // read-only displays updated from audio thread
+
+  if (paramIdx == kParamQualityMode)
+  {
+    mQualityMode.store(GetParam(paramIdx)->Int(), std::memory_order_relaxed);
+    return;
+  }
+
+  for (auto& dsp : mDSP)
+    dsp.SetParam(paramIdx, GetParam(paramIdx)->Value());
+
+  if (paramIdx == kParamTruePeak || paramIdx == kParamTruePeakLookahead)
+    mLatencyChanged.store(true, std::memory_order_release);
+}
+
+void IPlugWebUI::OnParamChange(int paramIdx, EParamSource source, int sampleOffset)
+{
+  // Host automation inside the block is queued for ProcessBlock, which
+  // applies it at its frame; the rest takes effect from the next block on
+  const bool dspParam = paramIdx != kParamDriveVU && paramIdx != kParamQualityTier && paramIdx != kParamQualityMode;
+  if (source == kHost && sampleOffset > 0 && dspParam)
   {
-    case kParamDriveGain:
-      mDriveGain = GetParam(kParamDriveGain)->Value();
-      mDriveSmoother.SetValue(mDriveGain);
-      break;
-  case kParamDriveVU: break; // read-only meter updated from audio thread
-    case kParamToneLowGain:
-      mToneLowGain = GetParam(kParamToneLowGain)->Value();
-      UpdateToneFilters();
-      break;
-    case kParamToneHighGain:
-      mToneHighGain = GetParam(kParamToneHighGain)->Value();
-      UpdateToneFilters();
-      break;
-    case kParamToneMidQ:
-      mToneMidQ = GetParam(kParamToneMidQ)->Value();
-      UpdateToneFilters();
-      break;
-    case kParamMpcBits:
-      mMpcBits = GetParam(kParamMpcBits)->Int();
-      break;
-    case kParamResampleRatio:
-      mResampleRatio = GetParam(kParamResampleRatio)->Value();
-      break;
-    case kParamWowAmount:
-      mWowAmount = GetParam(kParamWowAmount)->Value();
-      break;
-    case kParamWowRate:
-      mWowRate = GetParam(kParamWowRate)->Value();
-      RefreshWowFlutterIncrements();
-      break;
-    case kParamFlutterAmount:
-      mFlutterAmount = GetParam(kParamFlutterAmount)->Value();
-      break;
-    case kParamFlutterRate:
-      mFlutterRate = GetParam(kParamFlutterRate)->Value();
-      RefreshWowFlutterIncrements();
-      break;
-    case kParamNoiseLevel:
-      mNoiseLevel = GetParam(kParamNoiseLevel)->Value() * 0.01;
-      break;
-    case kParamLowPassCutoff:
-      mLowPassCutoff = GetParam(kParamLowPassCutoff)->Value();
-      UpdateLowPassFilter();
-      break;
-    case kParamLowPassResonance:
-      mLowPassResonance = GetParam(kParamLowPassResonance)->Value();
-      UpdateLowPassFilter();
-      break;
-    case kParamOutputGain:
-      mOutputGainDB = GetParam(kParamOutputGain)->Value();
-      mOutputGainLinear = std::pow(10.0, mOutputGainDB / 20.0);
-      break;
-    case kParamClipThreshold: mClipThreshold = GetParam(kParamClipThreshold)->Value(); break;
-    case kParamClipMode: mClipMode = GetParam(kParamClipMode)->Int(); break;
-    case kParamClipSlope: mClipSlope = GetParam(kParamClipSlope)->Value(); break;
-    case kParamPower: mPowerOn = GetParam(kParamPower)->Bool(); break;
-    default: break;
+    const double value = GetParam(paramIdx)->Value();
+    if (paramIdx == kParamTruePeak || paramIdx == kParamTruePeakLookahead)
+      mLatencyChanged.store(true, std::memory_order_release);
+    if (mNumParamEvents < kMaxParamEvents)
+    {
+      mParamEvents[mNumParamEvents++] = {sampleOffset, paramIdx, value};
+      return;
+    }
+
+    // Queue full: the newest value replaces the parameter's last queued one,
+    // which would otherwise be applied after it and win
+    mParamEventOverflows.fetch_add(1, std::memory_order_relaxed);
+    for (int i = mNumParamEvents - 1; i >= 0; --i)
+    {
+      if (mParamEvents[i].paramIdx == paramIdx)
+      {
+        mParamEvents[i].value = value;
+        return;
+      }
+    }
   }
+
+  OnParamChange(paramIdx);
 }
 
+// Audio thread: no logging here, PrintMsg formats and writes to the debug
+// console under a lock
 void IPlugWebUI::ProcessMidiMsg(const IMidiMsg& msg)
 {
-  TRACE;
-  msg.PrintMsg();
   SendMidiMsg(msg);
 }
 
+#if LOFI_WEB_EDITOR
 bool IPlugWebUI::CanNavigateToURL(const char* url)
 {
   DBGMSG("Navigating to URL %s\n", url);
@@ -830,3 +499,4 @@ void IPlugWebUI::OnGetLocalDownloadPathForFile(const char* fileName, WDL_String&
   DesktopPath(localPath);
   localPath.AppendFormatted(MAX_WIN32_PATH_LEN, "/%s", fileName);
 }
+#endif
@@ -2,71 +2,47 @@
 
 #include "IPlug_include_in_plug_hdr.h"
 #include "Oscillator.h"
-#include "Smoothers.h"
+#include "TapeSaturatorDSP.h"
+#include "QualityGovernor.h"
+#include "CaptureRing.h"
+#include "SpectrumAnalyser.h"
+#include "EditorIdleJobs.h"
 #include <atomic>
 #include <array>
 #include <cstdint>
+#include <string>
 
 using namespace iplug;
 
 const int kNumPresets = 3;
 
-struct BiquadFilter
-{
-  double b0 = 1.0;
-  double b1 = 0.0;
-  double b2 = 0.0;
-  double a1 = 0.0;
-  double a2 = 0.0;
-  std::array<double, 2> z1 {{0.0, 0.0}};
-  std::array<double, 2> z2 {{0.0, 0.0}};
-
-  double Process(double input, int channel);
-  void Reset();
-  void SetLowShelf(double sampleRate, double freq, double gainDB, double q);
-  void SetHighShelf(double sampleRate, double freq, double gainDB, double q);
-  void SetPeaking(double sampleRate, double freq, double gainDB, double q);
-  void SetLowPass(double sampleRate, double freq, double resonance);
-};
+// The editor is the WebView UI. Linux builds are headless and define no
+// editor delegate.
+#if IPLUG_EDITOR && defined WEBVIEW_EDITOR_DELEGATE
+  #define LOFI_WEB_EDITOR 1
+#else
+  #define LOFI_WEB_EDITOR 0
+#endif
 
-enum EParams
-{
-  kParamDriveGain = 0,
-  kParamDriveVU,
-  kParamToneLowGain,
-  kParamToneHighGain,
-  kParamToneMidQ,
-  kParamMpcBits,
-  kParamResampleRatio,
-  kParamWowAmount,
-  kParamWowRate,
-  kParamFlutterAmount,
-  kParamFlutterRate,
-  kParamNoiseLevel,
-  kParamLowPassCutoff,
-  kParamLowPassResonance,
-  kParamOutputGain,
-  kParamClipThreshold,
-  kParamClipMode,
-  kParamClipSlope,
-  kParamPower,
-  kNumParams
-};
+// CLAP builds render each channel with its own DSP core, so the host thread
+// pool can process the channels in parallel. Elsewhere one core renders all
+// channels.
+#if defined CLAP_API
+constexpr int kNumDSPCores = TapeSaturatorDSP::kMaxChannels;
+#else
+constexpr int kNumDSPCores = 1;
+#endif
 
-enum EClipMode
-{
-  kClipModeHard = 0,
-  kClipModeSoft,
-  kClipModeTanh,
-  kNumClipModes
-};
+// Sample-accurate parameter changes queued per block
+constexpr int kMaxParamEvents = 256;
 
 enum EMsgTags
 {
   kMsgTagButton1 = 0,
   kMsgTagButton2 = 1,
   kMsgTagButton3 = 2,
-  kMsgTagBinaryTest = 3
+  kMsgTagBinaryTest = 3,
+  kMsgTagEditorResized = 4  // from the page's resize listener
 };
 
 class IPlugWebUI final : public Plugin
@@ -80,81 +56,97 @@ public:
   void OnIdle() override;
   bool OnMessage(int msgTag, int ctrlTag, int dataSize, const void* pData) override;
   void OnParamChange(int paramIdx) override;
+  void OnParamChange(int paramIdx, EParamSource source, int sampleOffset) override;
+#if LOFI_WEB_EDITOR
   bool CanNavigateToURL(const char* url);
   bool OnCanDownloadMIMEType(const char* mimeType) override;
   void OnFailedToDownloadFile(const char* path) override;
   void OnDownloadedFile(const char* path) override;
   void OnGetLocalDownloadPathForFile(const char* fileName, WDL_String& localPath) override;
+#endif
+#if defined CLAP_API
+  bool implementsThreadPool() const noexcept override { return true; }
+  void threadPoolExec(uint32_t taskIndex) noexcept override;
+#endif
 
 private:
-  float mLastPeak = 0.f;
-  FastSinOscillator<sample> mOscillator {0., 440.};
-  LogParamSmooth<sample, 1> mDriveSmoother;
-#if IPLUG_EDITOR
+#if LOFI_WEB_EDITOR
   void OnUIOpen() override;
   void OnUIClose() override;
-  std::atomic<bool> mUIOpen {false};
 #endif
-  std::atomic<bool> mDriveVUQueued {false};
+  void SendDriveVUMeter(float linearValue);
+#if LOFI_WEB_EDITOR
+  void SendLoudness();
+  // EditorIdleJobs calls back after sending a meter batch
+  friend class EditorIdleJobs<IPlugWebUI>;
+  void OnMetersSent(unsigned changed);
+#endif
+  bool RenderChannels(int firstChan, int lastChan);
+  int GetRequestedQualityTier() const;
+  void UpdateQualityTier(double elapsedSec, int nFrames);
+
+  // Cross-thread atomics are grouped by writer, each group on its own cache
+  // line, so the audio thread's stores do not invalidate the line the main
+  // thread polls (and vice versa) or share a line with mDSP.
+
+  // Written by the audio thread, polled from OnIdle
+  alignas(tapedsp::kCacheLineSize) std::atomic<bool> mDriveVUQueued {false};
   std::atomic<float> mPendingDriveVU {0.0f};
+  std::atomic<int> mQualityTier {kQualityTierHigh};
+  std::atomic<bool> mQualityTierQueued {false};
+  std::atomic<float> mGovernorLoad {0.0f};
+  std::atomic<uint32_t> mNonFiniteEvents {0};
+  std::atomic<uint32_t> mParamEventOverflows {0};  // events merged into a full queue
+#if LOFI_WEB_EDITOR
+  std::atomic<bool> mLoudnessQueued {false};
+  std::array<std::atomic<float>, kNumLoudnessReadings> mLoudness {};  // rounded to 0.01
+#endif
 
-  std::array<double, 2> mTransformerSaturation {{0.0, 0.0}};
-  std::array<double, 2> mTransformerBias {{0.0, 0.0}};
-  std::array<double, 2> mTransformerLowpass {{0.0, 0.0}};
-  std::array<double, 2> mToneEnvelope {{0.0, 0.0}};
-  std::array<double, 2> mResamplePhase {{0.0, 0.0}};
-  std::array<double, 2> mResampleHold {{0.0, 0.0}};
-  std::array<double, 2> mMpcPrevSample {{0.0, 0.0}};
-  std::array<uint32_t, 2> mNoiseSeeds {{0x243F6A88u, 0x13198A2Eu}};
-  std::array<double, 2> mNoiseFilter {{0.0, 0.0}};
-  std::array<double, 2> mCrackleEnvelope {{0.0, 0.0}};
-  std::array<int, 2> mCrackleCooldown {{0, 0}};
-
-  BiquadFilter mToneLowShelf;
-  BiquadFilter mToneHighShelf;
-  BiquadFilter mToneMidBell;
-  BiquadFilter mLowPassFilter;
-  BiquadFilter mNoiseLowPassFilter;  // Dedicated LPF for vinyl noise
-
-  static constexpr int kWowBufferSize = 8192;
-  std::array<std::array<double, kWowBufferSize>, 2> mWowBuffer {};
-  std::array<int, 2> mWowWriteIndex {{0, 0}};
-  double mWowPhase = 0.0;
-  double mFlutterPhase = 0.0;
-  double mWowPhaseInc = 0.0;
-  double mFlutterPhaseInc = 0.0;
-
-  // Cached parameter state (synchronised in OnParamChange)
-  double mDriveGain = 0.2;
-  double mToneLowGain = 0.0;
-  double mToneHighGain = 0.0;
-  double mToneMidQ = 1.0;
-  int mMpcBits = 16;
-  double mResampleRatio = 1.0;
-  double mWowAmount = 0.02;
-  double mWowRate = 0.2;
-  double mFlutterAmount = 0.01;
-  double mFlutterRate = 8.0;
-  double mNoiseLevel = 0.0;
-  double mLowPassCutoff = 18000.0;
-  double mLowPassResonance = 0.7;
-  double mOutputGainDB = 0.0;      // -12 to +12 dB
-  double mOutputGainLinear = 1.0;  // Linear conversion
-  double mClipThreshold = 1.0;
-  int mClipMode = kClipModeTanh;
-  double mClipSlope = 0.5;
-  bool mPowerOn = true;
-  double mBypassRamp = 1.0;  // Smooth bypass ramp (0.0 = bypassed, 1.0 = active)
-  double mToneAttackCoeff = 0.0;
-  double mToneReleaseCoeff = 0.0;
-  double mToneSaturationMix = 0.3;
+  // Written by the main thread
+  alignas(tapedsp::kCacheLineSize) std::atomic<int> mQualityMode {kQualityModeAuto};
+  std::atomic<bool> mLatencyChanged {false};
+#if LOFI_WEB_EDITOR
+  std::atomic<bool> mUIOpen {false};
+#endif
 
-  void SendDriveVUMeter(float linearValue);
-  void UpdateToneFilters();
-  void UpdateLowPassFilter();
-  void RefreshWowFlutterIncrements();
+  // Audio thread only (TapeSaturatorDSP starts on a cache line of its own).
+  // The quality governor picks the tier here; OnIdle publishes it to the
+  // QualityTier display and the UI.
+  std::array<TapeSaturatorDSP, kNumDSPCores> mDSP;
+  QualityGovernor mGovernor;
+#if LOFI_WEB_EDITOR
+  // Host input and output of the whole plug-in, all channels together, for
+  // the editor's readout; runs only while the editor is open
+  LoudnessMeter mLoudnessMeter;
+  bool mMeteringLoudness = false;
+#endif
 
-  // Enforce host wrapper size consistency on open (for FL Studio scaling quirks)
-  std::atomic<bool> mVerifySizePending { false };
-  int mVerifyAttempts = 0;
+  // Host automation with a frame offset, applied by ProcessBlock at that
+  // frame. Filled and drained on the audio thread during process.
+  std::array<TapeParamEvent, kMaxParamEvents> mParamEvents {};
+  int mNumParamEvents = 0;
+
+  // The block being rendered, read by the thread-pool tasks
+  sample** mBlockInputs = nullptr;
+  sample** mBlockOutputs = nullptr;
+  int mBlockFrames = 0;
+  std::array<bool, kNumDSPCores> mCoreProcessed {};
+  FastSinOscillator<sample> mOscillator {0., 440.};
+
+#if LOFI_WEB_EDITOR
+  // Input and output for the spectrum analyser, written by the audio thread
+  // while the editor is open and drained by the analyser's worker. The
+  // analyser runs from OnUIOpen to OnUIClose and is owned by the main thread.
+  CaptureRing mCapture;
+  SpectrumAnalyser mAnalyser;
+#endif
+
+  // Main thread only
+  alignas(tapedsp::kCacheLineSize) uint32_t mReportedNonFiniteEvents = 0;
+  uint32_t mReportedParamEventOverflows = 0;
+#if LOFI_WEB_EDITOR
+  // Editor work done in OnIdle, scheduled per instance (see
+  // EditorIdleJobs.h)
+  EditorIdleJobs<IPlugWebUI> mEditorJobs {PLUG_WIDTH, PLUG_HEIGHT};
+#endif
 };
@@ -0,0 +1,101 @@
+#pragma once
+
+// Per-instance scheduling of the editor work OnIdle does on the host's UI
+// thread. A job runs only after something triggered it, no sooner than the
+// requested delay and at most once every interval ticks; triggers that
+// arrive while it is pending are merged into that one run. Ticks with no
+// due job cost a few comparisons. Plain data, one per plug-in instance, used
+// from the main thread only.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+class IdleScheduler
+{
+public:
+  static constexpr int kMaxJobs = 8;
+
+  // Minimum number of ticks between two runs of the job
+  void SetInterval(int job, int minTicks) { mJobs[job].interval = std::max(minTicks, 1); }
+
+  // Requests a run at least delayTicks from now
+  void Trigger(int job, int delayTicks = 0)
+  {
+    Job& j = mJobs[job];
+    if (j.pending)
+    {
+      ++j.coalesced;
+      return;
+    }
+    j.pending = true;
+    j.due = std::max(mTick + std::max(delayTicks, 0), j.lastRun + j.interval);
+  }
+
+  void Cancel(int job) { mJobs[job].pending = false; }
+
+  void CancelAll()
+  {
+    for (Job& j : mJobs)
+      j.pending = false;
+  }
+
+  bool IsPending(int job) const { return mJobs[job].pending; }
+
+  // Advances one tick and runs the due jobs in job order. run(job) may
+  // trigger jobs again, including itself; they are due on a later tick.
+  template <typename F>
+  int Tick(F&& run)
+  {
+    ++mTick;
+    int ran = 0;
+    for (int job = 0; job < kMaxJobs; ++job)
+    {
+      Job& j = mJobs[job];
+      if (!j.pending || j.due > mTick)
+        continue;
+      j.pending = false;
+      j.lastRun = mTick;
+      ++j.runs;
+      ++ran;
+      run(job);
+    }
+    return ran;
+  }
+
+  int64_t GetTick() const { return mTick; }
+  uint64_t GetRuns(int job) const { return mJobs[job].runs; }
+  // Triggers merged into a pending run
+  uint64_t GetCoalesced(int job) const { return mJobs[job].coalesced; }
+
+private:
+  struct Job
+  {
+    int interval = 1;
+    bool pending = false;
+    int64_t due = 0;
+    int64_t lastRun = INT32_MIN;
+    uint64_t runs = 0;
+    uint64_t coalesced = 0;
+  };
+
+  int64_t mTick = 0;
+  std::array<Job, kMaxJobs> mJobs {};
+};
+
+// The plug-in editor's jobs (EditorIdleJobs.h), shared with lofi-render
+// idle-sim
+enum EIdleJob
+{
+  kIdleJobScale = 0,   // window.applyScale after the editor opened or resized
+  kIdleJobVerifySize,  // JS size round trip, Resize if the host got it wrong
+  kIdleJobMeters,      // one script with every reading that changed
+  kIdleJobWatchSize,   // size check after the page resized, re-runs the scale job when it drifted
+  kNumIdleJobs
+};
+
+constexpr int kIdleJobIntervals[kNumIdleJobs] = {30, 30, 2, 60};
+// Ticks after opening or resizing before the page is asked to lay out or
+// report its size, so it has loaded
+constexpr int kIdleSettleTicks = 30;
+constexpr int kMaxSizeVerifyAttempts = 3;
@@ -0,0 +1,253 @@
+#pragma once
+
+// ITU-R BS.1770 loudness of the input and the output: momentary (400 ms),
+// short-term (3 s) and integrated (absolute gate at -70 LUFS, relative gate
+// 10 LU below the ungated mean), in LUFS, channels weighted 1.0.
+//
+// Each side is K-weighted with both filter stages for both channels in one
+// tapedsp::Double4: lanes 0 and 1 run the high-shelf pre-filter on the left
+// and right sample, lanes 2 and 3 run the RLB high-pass on the pre-filter
+// output of the previous frame. One vector biquad step per frame does the
+// whole cascade; the one-frame pipeline delay does not change the energy.
+//
+// Energies are collected in 100 ms steps (the 75% overlap of the 400 ms
+// gating blocks). The integrated value keeps a histogram of gating-block
+// loudness in 0.1 LU bins instead of every block, so memory is fixed and the
+// meter never allocates, plus the running sum of the bins above the relative
+// gate, so a new block costs a few bins rather than a scan. Feed the input before rendering and the output
+// after, so in-place buffers work. Everything is plain data and can be
+// copied and serialised as is.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include "Multiband.h"
+
+class LoudnessMeter
+{
+public:
+  enum ESide
+  {
+    kSideInput = 0,
+    kSideOutput,
+    kNumSides
+  };
+
+  static constexpr int kMaxChannels = 2;
+  static constexpr double kStepSec = 0.1;
+  static constexpr int kMomentarySteps = 4;    // 400 ms
+  static constexpr int kShortTermSteps = 30;   // 3 s
+  static constexpr double kAbsoluteGateLUFS = -70.0;
+  static constexpr double kRelativeGateLU = -10.0;
+  static constexpr double kFloorLUFS = -120.0; // reported for silence
+  static constexpr int kHistogramBins = 800;   // 0.1 LU from the absolute gate up
+
+  // Designs the K-weighting for the sample rate and clears all readings
+  void Reset(double sampleRate)
+  {
+    const double sr = std::max(sampleRate, 1.0);
+    mStepLength = std::max(1, static_cast<int>(std::lround(kStepSec * sr)));
+    DesignKWeighting(sr);
+    for (Side& side : mSides)
+      side = Side();
+  }
+
+  // Accumulates channels [firstChan, lastChan) of one side; the others count
+  // as silent
+  template <typename T>
+  void Process(ESide sideIdx, const T* const* data, int nFrames, int firstChan, int lastChan)
+  {
+    using tapedsp::Double4;
+
+    Side& side = mSides[sideIdx];
+    const T* left = firstChan <= 0 && lastChan > 0 ? data[0] : nullptr;
+    const T* right = firstChan <= 1 && lastChan > 1 ? data[1] : nullptr;
+    Double4 y = side.y;
+    Double4 z1 = side.z1;
+    Double4 z2 = side.z2;
+    Double4 energy = side.energy;
+    for (int s = 0; s < nFrames; ++s)
+    {
+      const Double4 x = tapedsp::ShiftIn(left ? static_cast<double>(left[s]) : 0.0, right ? static_cast<double>(right[s]) : 0.0, y);
+      y = mB0 * x + z1;
+      z1 = mB1 * x - mA1 * y + z2;
+      z2 = mB2 * x - mA2 * y;
+      energy = energy + y * y;
+      if (++side.stepFrames == mStepLength)
+      {
+        side.y = y;
+        side.z1 = z1;
+        side.z2 = z2;
+        side.energy = energy;
+        FinishStep(side);
+        y = side.y;
+        z1 = side.z1;
+        z2 = side.z2;
+        energy = side.energy;
+      }
+    }
+    side.y = y;
+    side.z1 = z1;
+    side.z2 = z2;
+    side.energy = energy;
+  }
+
+  double GetMomentary(ESide side) const { return ToLUFS(mSides[side].momentary[0] + mSides[side].momentary[1]); }
+  double GetShortTerm(ESide side) const { return ToLUFS(mSides[side].shortTerm[0] + mSides[side].shortTerm[1]); }
+  double GetShortTermChannel(ESide side, int channel) const { return ToLUFS(mSides[side].shortTerm[std::clamp(channel, 0, kMaxChannels - 1)]); }
+  // kFloorLUFS until a gating block passes both gates
+  double GetIntegrated(ESide side) const { return mSides[side].integrated; }
+
+  static double ToLUFS(double meanSquare) { return meanSquare > 0.0 ? std::max(-0.691 + 10.0 * std::log10(meanSquare), kFloorLUFS) : kFloorLUFS; }
+
+private:
+  static constexpr double kPi = 3.14159265358979323846;
+
+  struct Side
+  {
+    tapedsp::Double4 y;       // last output: pre-filtered L, R | K-weighted L, R
+    tapedsp::Double4 z1;
+    tapedsp::Double4 z2;
+    tapedsp::Double4 energy;  // sum of squares in the current step
+    int stepFrames = 0;
+    // Mean square per channel of the last kShortTermSteps steps
+    std::array<std::array<double, kMaxChannels>, kShortTermSteps> steps {};
+    int stepIndex = 0;
+    uint64_t numSteps = 0;
+    std::array<double, kMaxChannels> momentary {};
+    std::array<double, kMaxChannels> shortTerm {};
+    std::array<uint32_t, kHistogramBins> histogram {};
+    double gatedEnergy = 0.0;  // sum over blocks above the absolute gate
+    uint64_t gatedBlocks = 0;
+    int gateBin = 0;           // first histogram bin above the relative gate
+    double aboveEnergy = 0.0;  // bin-centre energy of the blocks from gateBin up
+    uint64_t aboveBlocks = 0;
+    double integrated = kFloorLUFS;
+  };
+
+  // Mean square at the centre of every histogram bin
+  static const std::array<double, kHistogramBins> kBinEnergy;
+
+  void DesignKWeighting(double sr)
+  {
+    // Stage 1, high shelf (+4 dB above ~1.7 kHz), at any sample rate
+    const double f1 = 1681.974450955533;
+    const double g1 = 3.999843853973347;
+    const double q1 = 0.7071752369554196;
+    const double k1 = std::tan(kPi * std::min(f1, 0.49 * sr) / sr);
+    const double vh = std::pow(10.0, g1 / 20.0);
+    const double vb = std::pow(vh, 0.4996667741545416);
+    const double a01 = 1.0 + k1 / q1 + k1 * k1;
+    const double shelf[5] = {(vh + vb * k1 / q1 + k1 * k1) / a01, 2.0 * (k1 * k1 - vh) / a01, (vh - vb * k1 / q1 + k1 * k1) / a01,
+                             2.0 * (k1 * k1 - 1.0) / a01, (1.0 - k1 / q1 + k1 * k1) / a01};
+
+    // Stage 2, RLB high-pass at ~38 Hz
+    const double f2 = 38.13547087602444;
+    const double q2 = 0.5003270373238773;
+    const double k2 = std::tan(kPi * f2 / sr);
+    const double a02 = 1.0 + k2 / q2 + k2 * k2;
+    const double highPass[5] = {1.0, -2.0, 1.0, 2.0 * (k2 * k2 - 1.0) / a02, (1.0 - k2 / q2 + k2 * k2) / a02};
+
+    mB0 = tapedsp::Double4(shelf[0], shelf[0], highPass[0], highPass[0]);
+    mB1 = tapedsp::Double4(shelf[1], shelf[1], highPass[1], highPass[1]);
+    mB2 = tapedsp::Double4(shelf[2], shelf[2], highPass[2], highPass[2]);
+    mA1 = tapedsp::Double4(shelf[3], shelf[3], highPass[3], highPass[3]);
+    mA2 = tapedsp::Double4(shelf[4], shelf[4], highPass[4], highPass[4]);
+  }
+
+  void FinishStep(Side& side)
+  {
+    double lanes[4];
+    tapedsp::Store(side.energy, lanes);
+    side.energy = 0.0;
+    side.stepFrames = 0;
+
+    // NaN or Inf input would stay in the filters: drop the step and restart
+    // them
+    const double scale = 1.0 / mStepLength;
+    std::array<double, kMaxChannels> meanSquare {{lanes[2] * scale, lanes[3] * scale}};
+    if (!std::isfinite(meanSquare[0] + meanSquare[1]))
+    {
+      meanSquare = {};
+      side.y = side.z1 = side.z2 = 0.0;
+    }
+
+    side.steps[side.stepIndex] = meanSquare;
+    side.stepIndex = (side.stepIndex + 1) % kShortTermSteps;
+    ++side.numSteps;
+
+    // Until a window is full it averages the steps so far
+    const int shortSteps = static_cast<int>(std::min<uint64_t>(side.numSteps, kShortTermSteps));
+    const int momentarySteps = std::min(shortSteps, kMomentarySteps);
+    side.momentary = {};
+    side.shortTerm = {};
+    for (int i = 1; i <= shortSteps; ++i)
+    {
+      const auto& step = side.steps[(side.stepIndex - i + kShortTermSteps) % kShortTermSteps];
+      for (int c = 0; c < kMaxChannels; ++c)
+      {
+        side.shortTerm[c] += step[c];
+        if (i <= momentarySteps)
+          side.momentary[c] += step[c];
+      }
+    }
+    for (int c = 0; c < kMaxChannels; ++c)
+    {
+      side.shortTerm[c] /= shortSteps;
+      side.momentary[c] /= momentarySteps;
+    }
+
+    if (side.numSteps >= kMomentarySteps)
+      AddGatingBlock(side, side.momentary[0] + side.momentary[1]);
+  }
+
+  static void AddGatingBlock(Side& side, double blockEnergy)
+  {
+    const double loudness = ToLUFS(blockEnergy);
+    if (loudness <= kAbsoluteGateLUFS)
+      return;
+    const int bin = std::clamp(static_cast<int>((loudness - kAbsoluteGateLUFS) * 10.0), 0, kHistogramBins - 1);
+    ++side.histogram[bin];
+    side.gatedEnergy += blockEnergy;
+    ++side.gatedBlocks;
+    if (bin >= side.gateBin)
+    {
+      side.aboveEnergy += kBinEnergy[bin];
+      ++side.aboveBlocks;
+    }
+
+    // Relative gate from the exact mean; the blocks above it are taken at
+    // their bin centres. The gate moves by a few bins per block at most, so
+    // the sum above it follows bin by bin.
+    const double relativeGate = ToLUFS(side.gatedEnergy / static_cast<double>(side.gatedBlocks)) + kRelativeGateLU;
+    const int firstBin = std::clamp(static_cast<int>(std::ceil((relativeGate - kAbsoluteGateLUFS) * 10.0)), 0, kHistogramBins);
+    for (; side.gateBin < firstBin; ++side.gateBin)
+    {
+      side.aboveEnergy -= side.histogram[side.gateBin] * kBinEnergy[side.gateBin];
+      side.aboveBlocks -= side.histogram[side.gateBin];
+    }
+    while (side.gateBin > firstBin)
+    {
+      --side.gateBin;
+      side.aboveEnergy += side.histogram[side.gateBin] * kBinEnergy[side.gateBin];
+      side.aboveBlocks += side.histogram[side.gateBin];
+    }
+    if (side.aboveBlocks == 0)
+      side.aboveEnergy = 0.0; // no rounding residue from the subtractions
+    side.integrated = side.aboveBlocks > 0 ? ToLUFS(side.aboveEnergy / static_cast<double>(side.aboveBlocks)) : kFloorLUFS;
+  }
+
+  tapedsp::Double4 mB0, mB1, mB2, mA1, mA2;
+  int mStepLength = 4410;
+  std::array<Side, kNumSides> mSides {};
+};
+
+// Filled once at static initialisation, so the audio thread never computes it
+inline const std::array<double, LoudnessMeter::kHistogramBins> LoudnessMeter::kBinEnergy = [] {
+  std::array<double, kHistogramBins> energy {};
+  for (int i = 0; i < kHistogramBins; ++i)
+    energy[i] = std::pow(10.0, (kAbsoluteGateLUFS + (i + 0.5) * 0.1 + 0.691) / 10.0);
+  return energy;
+}();
@@ -0,0 +1,353 @@
+#pragma once
+
+// Band split for the multiband drive mode. Up to four bands are carried as
+// the four lanes of a Double4, so the crossover and the transformer run once
+// per sample for all bands together: two SSE2/NEON registers on x86-64 and
+// AArch64, a plain array elsewhere. Each band is a cascade of three
+// Linkwitz-Riley 4th-order sections, one per crossover frequency:
+//
+//   band 0   LP(f1) AP(f2) AP(f3)
+//   band 1   HP(f1) LP(f2) AP(f3)
+//   band 2   HP(f1) HP(f2) LP(f3)
+//   band 3   HP(f1) HP(f2) HP(f3)
+//
+// LP + HP of an LR4 pair is the 2nd-order all-pass AP at the same frequency,
+// so the bands sum to AP(f1) AP(f2) AP(f3): flat magnitude and no latency.
+// With fewer bands the unused crossovers become identity sections and the
+// unused lanes are silent.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define TAPEDSP_MULTIBAND_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  #include <arm_neon.h>
+  #define TAPEDSP_MULTIBAND_NEON 1
+#endif
+
+namespace tapedsp
+{
+// Four double lanes. Converts implicitly from double (broadcast), so the
+// transformer code reads the same for one band and for four.
+struct Double4
+{
+#if defined(TAPEDSP_MULTIBAND_SSE2)
+  __m128d lo, hi;
+
+  Double4() : lo(_mm_setzero_pd()), hi(_mm_setzero_pd()) {}
+  Double4(double x) : lo(_mm_set1_pd(x)), hi(_mm_set1_pd(x)) {}
+  Double4(__m128d l, __m128d h) : lo(l), hi(h) {}
+  Double4(double a, double b, double c, double d) : lo(_mm_set_pd(b, a)), hi(_mm_set_pd(d, c)) {}
+
+  double Sum() const
+  {
+    const __m128d s = _mm_add_pd(lo, hi);
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+  }
+#elif defined(TAPEDSP_MULTIBAND_NEON)
+  float64x2_t lo, hi;
+
+  Double4() : lo(vdupq_n_f64(0.0)), hi(vdupq_n_f64(0.0)) {}
+  Double4(double x) : lo(vdupq_n_f64(x)), hi(vdupq_n_f64(x)) {}
+  Double4(float64x2_t l, float64x2_t h) : lo(l), hi(h) {}
+  Double4(double a, double b, double c, double d)
+  {
+    const double v[4] = {a, b, c, d};
+    lo = vld1q_f64(v);
+    hi = vld1q_f64(v + 2);
+  }
+
+  double Sum() const { return vaddvq_f64(vaddq_f64(lo, hi)); }
+#else
+  std::array<double, 4> v {};
+
+  Double4() = default;
+  Double4(double x) : v {{x, x, x, x}} {}
+  Double4(double a, double b, double c, double d) : v {{a, b, c, d}} {}
+
+  double Sum() const { return (v[0] + v[2]) + (v[1] + v[3]); }
+#endif
+};
+
+#if defined(TAPEDSP_MULTIBAND_SSE2)
+inline Double4 operator+(const Double4& a, const Double4& b) { return {_mm_add_pd(a.lo, b.lo), _mm_add_pd(a.hi, b.hi)}; }
+inline Double4 operator-(const Double4& a, const Double4& b) { return {_mm_sub_pd(a.lo, b.lo), _mm_sub_pd(a.hi, b.hi)}; }
+inline Double4 operator*(const Double4& a, const Double4& b) { return {_mm_mul_pd(a.lo, b.lo), _mm_mul_pd(a.hi, b.hi)}; }
+inline Double4 operator/(const Double4& a, const Double4& b) { return {_mm_div_pd(a.lo, b.lo), _mm_div_pd(a.hi, b.hi)}; }
+inline Double4 Min(const Double4& a, const Double4& b) { return {_mm_min_pd(a.lo, b.lo), _mm_min_pd(a.hi, b.hi)}; }
+inline Double4 Max(const Double4& a, const Double4& b) { return {_mm_max_pd(a.lo, b.lo), _mm_max_pd(a.hi, b.hi)}; }
+inline Double4 Abs(const Double4& a)
+{
+  const __m128d sign = _mm_set1_pd(-0.0);
+  return {_mm_andnot_pd(sign, a.lo), _mm_andnot_pd(sign, a.hi)};
+}
+// 1 where a >= 0, -1 elsewhere
+inline Double4 Polarity(const Double4& a)
+{
+  const __m128d zero = _mm_setzero_pd();
+  const __m128d one = _mm_set1_pd(1.0);
+  const __m128d sign = _mm_set1_pd(-0.0);
+  return {_mm_or_pd(one, _mm_andnot_pd(_mm_cmpge_pd(a.lo, zero), sign)), _mm_or_pd(one, _mm_andnot_pd(_mm_cmpge_pd(a.hi, zero), sign))};
+}
+inline bool operator!=(const Double4& a, const Double4& b)
+{
+  return (_mm_movemask_pd(_mm_cmpneq_pd(a.lo, b.lo)) | _mm_movemask_pd(_mm_cmpneq_pd(a.hi, b.hi))) != 0;
+}
+// (a, b, x[0], x[1]): two new lanes in front, the low half of x moves up
+inline Double4 ShiftIn(double a, double b, const Double4& x) { return {_mm_set_pd(b, a), x.lo}; }
+inline void Store(const Double4& x, double* out)
+{
+  _mm_storeu_pd(out, x.lo);
+  _mm_storeu_pd(out + 2, x.hi);
+}
+#elif defined(TAPEDSP_MULTIBAND_NEON)
+inline Double4 operator+(const Double4& a, const Double4& b) { return {vaddq_f64(a.lo, b.lo), vaddq_f64(a.hi, b.hi)}; }
+inline Double4 operator-(const Double4& a, const Double4& b) { return {vsubq_f64(a.lo, b.lo), vsubq_f64(a.hi, b.hi)}; }
+inline Double4 operator*(const Double4& a, const Double4& b) { return {vmulq_f64(a.lo, b.lo), vmulq_f64(a.hi, b.hi)}; }
+inline Double4 operator/(const Double4& a, const Double4& b) { return {vdivq_f64(a.lo, b.lo), vdivq_f64(a.hi, b.hi)}; }
+inline Double4 Min(const Double4& a, const Double4& b) { return {vminq_f64(a.lo, b.lo), vminq_f64(a.hi, b.hi)}; }
+inline Double4 Max(const Double4& a, const Double4& b) { return {vmaxq_f64(a.lo, b.lo), vmaxq_f64(a.hi, b.hi)}; }
+inline Double4 Abs(const Double4& a) { return {vabsq_f64(a.lo), vabsq_f64(a.hi)}; }
+inline Double4 Polarity(const Double4& a)
+{
+  const float64x2_t one = vdupq_n_f64(1.0);
+  const float64x2_t minusOne = vdupq_n_f64(-1.0);
+  return {vbslq_f64(vcgezq_f64(a.lo), one, minusOne), vbslq_f64(vcgezq_f64(a.hi), one, minusOne)};
+}
+inline bool operator!=(const Double4& a, const Double4& b)
+{
+  const uint64x2_t same = vandq_u64(vceqq_f64(a.lo, b.lo), vceqq_f64(a.hi, b.hi));
+  return (vgetq_lane_u64(same, 0) & vgetq_lane_u64(same, 1)) == 0;
+}
+inline Double4 ShiftIn(double a, double b, const Double4& x)
+{
+  const double v[2] = {a, b};
+  return {vld1q_f64(v), x.lo};
+}
+inline void Store(const Double4& x, double* out)
+{
+  vst1q_f64(out, x.lo);
+  vst1q_f64(out + 2, x.hi);
+}
+#else
+template <typename Op>
+inline Double4 Lanewise(const Double4& a, const Double4& b, Op op)
+{
+  return {op(a.v[0], b.v[0]), op(a.v[1], b.v[1]), op(a.v[2], b.v[2]), op(a.v[3], b.v[3])};
+}
+inline Double4 operator+(const Double4& a, const Double4& b) { return Lanewise(a, b, [](double x, double y) { return x + y; }); }
+inline Double4 operator-(const Double4& a, const Double4& b) { return Lanewise(a, b, [](double x, double y) { return x - y; }); }
+inline Double4 operator*(const Double4& a, const Double4& b) { return Lanewise(a, b, [](double x, double y) { return x * y; }); }
+inline Double4 operator/(const Double4& a, const Double4& b) { return Lanewise(a, b, [](double x, double y) { return x / y; }); }
+inline Double4 Min(const Double4& a, const Double4& b) { return Lanewise(a, b, [](double x, double y) { return std::min(x, y); }); }
+inline Double4 Max(const Double4& a, const Double4& b) { return Lanewise(a, b, [](double x, double y) { return std::max(x, y); }); }
+inline Double4 Abs(const Double4& a) { return Lanewise(a, a, [](double x, double) { return std::fabs(x); }); }
+inline Double4 Polarity(const Double4& a) { return Lanewise(a, a, [](double x, double) { return x >= 0.0 ? 1.0 : -1.0; }); }
+inline bool operator!=(const Double4& a, const Double4& b) { return a.v != b.v; }
+inline Double4 ShiftIn(double a, double b, const Double4& x) { return {a, b, x.v[0], x.v[1]}; }
+inline void Store(const Double4& x, double* out) { std::copy(x.v.begin(), x.v.end(), out); }
+#endif
+
+// Two double lanes, one per channel: the tone cascade filters left and right
+// together. Load/Store move both lanes to and from two adjacent doubles.
+#if defined(TAPEDSP_MULTIBAND_SSE2)
+struct Double2
+{
+  __m128d v;
+};
+
+inline Double2 Broadcast2(double x) { return {_mm_set1_pd(x)}; }
+inline Double2 Load2(const double* in) { return {_mm_loadu_pd(in)}; }
+inline void Store(const Double2& x, double* out) { _mm_storeu_pd(out, x.v); }
+inline Double2 operator+(const Double2& a, const Double2& b) { return {_mm_add_pd(a.v, b.v)}; }
+inline Double2 operator-(const Double2& a, const Double2& b) { return {_mm_sub_pd(a.v, b.v)}; }
+inline Double2 operator*(const Double2& a, const Double2& b) { return {_mm_mul_pd(a.v, b.v)}; }
+#elif defined(TAPEDSP_MULTIBAND_NEON)
+struct Double2
+{
+  float64x2_t v;
+};
+
+inline Double2 Broadcast2(double x) { return {vdupq_n_f64(x)}; }
+inline Double2 Load2(const double* in) { return {vld1q_f64(in)}; }
+inline void Store(const Double2& x, double* out) { vst1q_f64(out, x.v); }
+inline Double2 operator+(const Double2& a, const Double2& b) { return {vaddq_f64(a.v, b.v)}; }
+inline Double2 operator-(const Double2& a, const Double2& b) { return {vsubq_f64(a.v, b.v)}; }
+inline Double2 operator*(const Double2& a, const Double2& b) { return {vmulq_f64(a.v, b.v)}; }
+#else
+struct Double2
+{
+  std::array<double, 2> v;
+};
+
+inline Double2 Broadcast2(double x) { return {{{x, x}}}; }
+inline Double2 Load2(const double* in) { return {{{in[0], in[1]}}}; }
+inline void Store(const Double2& x, double* out) { std::copy(x.v.begin(), x.v.end(), out); }
+inline Double2 operator+(const Double2& a, const Double2& b) { return {{{a.v[0] + b.v[0], a.v[1] + b.v[1]}}}; }
+inline Double2 operator-(const Double2& a, const Double2& b) { return {{{a.v[0] - b.v[0], a.v[1] - b.v[1]}}}; }
+inline Double2 operator*(const Double2& a, const Double2& b) { return {{{a.v[0] * b.v[0], a.v[1] * b.v[1]}}}; }
+#endif
+
+// Scalar counterparts, so code templated on the sample type works for both
+inline double Abs(double a) { return std::fabs(a); }
+inline double Polarity(double a) { return a >= 0.0 ? 1.0 : -1.0; }
+
+// Rational tanh of FastTanh, per lane
+inline Double4 FastTanh(Double4 x)
+{
+  x = Min(Max(x, -4.97), 4.97);
+  const Double4 x2 = x * x;
+  return x * (135135.0 + x2 * (17325.0 + x2 * (378.0 + x2))) / (135135.0 + x2 * (62370.0 + x2 * (3150.0 + 28.0 * x2)));
+}
+
+class BandSplitter
+{
+public:
+  static constexpr int kMaxBands = 4;
+  static constexpr int kMaxChannels = 2;
+
+  // Designs the crossovers for numBands (2..4); crossover[i] is the split
+  // between band i and band i + 1. Keeps the filter state.
+  void Design(int numBands, const double* crossover, double sampleRate)
+  {
+    numBands = std::clamp(numBands, 2, kMaxBands);
+    const double nyquistGuard = 0.45 * sampleRate;
+    std::array<Section, kMaxBands> sections[kMaxBands - 1];
+    for (int x = 0; x < kMaxBands - 1; ++x)
+    {
+      const double freq = std::min(crossover[x], nyquistGuard);
+      for (int band = 0; band < kMaxBands; ++band)
+      {
+        // Crossover x splits band x from everything above; the bands below
+        // only see its phase, the ones above its high-pass
+        EShape shape = band < x ? kAllPass : band == x ? kLowPass : kHighPass;
+        if (x >= numBands - 1)
+          shape = band < numBands ? kIdentity : kSilent;
+        sections[x][band] = DesignSection(shape, sampleRate, freq);
+      }
+    }
+
+    // Section x becomes stages 2x and 2x + 1: LR4 = the Butterworth biquad
+    // twice; an all-pass runs once and leaves the second stage as identity
+    for (int x = 0; x < kMaxBands - 1; ++x)
+    {
+      for (int half = 0; half < 2; ++half)
+      {
+        Stage& stage = mStages[2 * x + half];
+        double b0[kMaxBands], b1[kMaxBands], b2[kMaxBands], a1[kMaxBands], a2[kMaxBands];
+        for (int band = 0; band < kMaxBands; ++band)
+        {
+          const Section& s = half == 1 && sections[x][band].once ? kIdentitySection : sections[x][band];
+          b0[band] = s.b0;
+          b1[band] = s.b1;
+          b2[band] = s.b2;
+          a1[band] = s.a1;
+          a2[band] = s.a2;
+        }
+        stage.b0 = Double4(b0[0], b0[1], b0[2], b0[3]);
+        stage.b1 = Double4(b1[0], b1[1], b1[2], b1[3]);
+        stage.b2 = Double4(b2[0], b2[1], b2[2], b2[3]);
+        stage.a1 = Double4(a1[0], a1[1], a1[2], a1[3]);
+        stage.a2 = Double4(a2[0], a2[1], a2[2], a2[3]);
+      }
+    }
+  }
+
+  void Reset()
+  {
+    for (auto& channel : mState)
+      channel = ChannelState();
+  }
+
+  // False once any filter state is NaN or infinite (x * 0 is zero for every
+  // finite x)
+  bool IsFinite() const
+  {
+    Double4 probe = 0.0;
+    for (const ChannelState& state : mState)
+    {
+      for (int i = 0; i < kNumStages; ++i)
+        probe = probe + state.z1[i] * 0.0 + state.z2[i] * 0.0;
+    }
+    return probe.Sum() == 0.0;
+  }
+
+  // The input split into its bands, lane i = band i
+  inline Double4 Process(double input, int channel)
+  {
+    ChannelState& state = mState[channel > 0 ? 1 : 0];
+    Double4 x = input;
+    for (int i = 0; i < kNumStages; ++i)
+    {
+      const Stage& c = mStages[i];
+      const Double4 y = c.b0 * x + state.z1[i];
+      state.z1[i] = c.b1 * x - c.a1 * y + state.z2[i];
+      state.z2[i] = c.b2 * x - c.a2 * y;
+      x = y;
+    }
+    return x;
+  }
+
+private:
+  static constexpr int kNumStages = 2 * (kMaxBands - 1);
+
+  enum EShape
+  {
+    kLowPass = 0,
+    kHighPass,
+    kAllPass,
+    kIdentity,
+    kSilent
+  };
+
+  struct Section
+  {
+    double b0, b1, b2, a1, a2;
+    bool once;  // all-pass, identity and silence are not doubled
+  };
+
+  static constexpr Section kIdentitySection = {1.0, 0.0, 0.0, 0.0, 0.0, true};
+
+  // Butterworth (Q = 1/sqrt 2) RBJ sections, bilinear with prewarping, so
+  // LP^2 + HP^2 equals AP exactly
+  static Section DesignSection(EShape shape, double sampleRate, double freq)
+  {
+    if (shape == kIdentity)
+      return kIdentitySection;
+    if (shape == kSilent)
+      return {0.0, 0.0, 0.0, 0.0, 0.0, true};
+
+    const double w0 = 6.28318530717958647693 * freq / sampleRate;
+    const double cosw0 = std::cos(w0);
+    const double alpha = std::sin(w0) * 0.70710678118654752440; // sin / (2Q)
+    const double a0 = 1.0 + alpha;
+    const double a1 = -2.0 * cosw0 / a0;
+    const double a2 = (1.0 - alpha) / a0;
+    switch (shape)
+    {
+      case kLowPass: return {(1.0 - cosw0) * 0.5 / a0, (1.0 - cosw0) / a0, (1.0 - cosw0) * 0.5 / a0, a1, a2, false};
+      case kHighPass: return {(1.0 + cosw0) * 0.5 / a0, -(1.0 + cosw0) / a0, (1.0 + cosw0) * 0.5 / a0, a1, a2, false};
+      case kAllPass:
+      default: return {a2, a1, 1.0, a1, a2, true};
+    }
+  }
+
+  struct Stage
+  {
+    Double4 b0 = 1.0;
+    Double4 b1, b2, a1, a2;
+  };
+
+  struct ChannelState
+  {
+    std::array<Double4, kNumStages> z1 {};
+    std::array<Double4, kNumStages> z2 {};
+  };
+
+  std::array<Stage, kNumStages> mStages {};
+  std::array<ChannelState, kMaxChannels> mState {};
+};
+} // namespace tapedsp
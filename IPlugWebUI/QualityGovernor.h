@@ -0,0 +1,86 @@
+#pragma once
+
+// Picks a quality tier (EQualityTier) from measured processing load.
+// Load is the time spent in a block divided by the block's real-time budget
+// (nFrames / sampleRate). Preemption shows up as longer blocks too, so the
+// measurement also rises when the machine as a whole is short on CPU.
+// Separate thresholds and hold times give hysteresis: the tier drops quickly
+// under sustained load and recovers only after a longer quiet period.
+
+#include <algorithm>
+#include <cmath>
+
+class QualityGovernor
+{
+public:
+  struct Settings
+  {
+    double stepDownLoad = 0.5;      // smoothed load above which quality drops
+    double stepUpLoad = 0.2;        // smoothed load below which quality recovers
+    double stepDownHoldSec = 0.15;  // how long the load must stay high
+    double stepUpHoldSec = 2.0;     // how long the load must stay low
+    double smoothingSec = 0.05;     // time constant of the load average
+  };
+
+  QualityGovernor() = default;
+  explicit QualityGovernor(const Settings& settings) : mSettings(settings) {}
+
+  void Reset()
+  {
+    mTier = 0;
+    mLoad = 0.0;
+    mOverSec = 0.0;
+    mUnderSec = 0.0;
+  }
+
+  // Accounts one processed block and returns the tier for the next one
+  int Update(double elapsedSec, int nFrames, double sampleRate, int numTiers)
+  {
+    if (nFrames <= 0 || sampleRate <= 0.0)
+      return mTier;
+
+    const double budgetSec = nFrames / sampleRate;
+    const double load = elapsedSec / budgetSec;
+    const double alpha = 1.0 - std::exp(-budgetSec / mSettings.smoothingSec);
+    mLoad += (load - mLoad) * alpha;
+
+    if (mLoad > mSettings.stepDownLoad)
+    {
+      mOverSec += budgetSec;
+      mUnderSec = 0.0;
+    }
+    else if (mLoad < mSettings.stepUpLoad)
+    {
+      mUnderSec += budgetSec;
+      mOverSec = 0.0;
+    }
+    else
+    {
+      mOverSec = 0.0;
+      mUnderSec = 0.0;
+    }
+
+    if (mOverSec >= mSettings.stepDownHoldSec && mTier < numTiers - 1)
+    {
+      ++mTier;
+      mOverSec = 0.0;
+    }
+    else if (mUnderSec >= mSettings.stepUpHoldSec && mTier > 0)
+    {
+      --mTier;
+      mUnderSec = 0.0;
+    }
+    return mTier;
+  }
+
+  int GetTier() const { return mTier; }
+  // Smoothed load, 1.0 = the whole block budget
+  double GetLoad() const { return mLoad; }
+
+private:
+  Settings mSettings;
+  int mTier = 0;
+  double mLoad = 0.0;
+  double mOverSec = 0.0;
+  double mUnderSec = 0.0;
+};
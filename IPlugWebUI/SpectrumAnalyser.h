@@ -0,0 +1,251 @@
+#pragma once
+
+// Spectrum and harmonic readout for the editor, computed on a worker thread
+// from the CaptureRing. The worker runs only between Start and Stop (the
+// editor opening and closing); while it is stopped the plug-in does not
+// capture either, so a closed editor costs nothing.
+//
+// Every kIntervalSec the worker drains the ring and, when new frames came
+// in, analyses the last kFFTSize of them: Hann-windowed spectra of input
+// and output reduced to kNumBands log-spaced bands (peak bin per band, in
+// dBFS, a full-scale sine reads 0 dB), and the 2nd and 3rd harmonics the
+// DSP added to the strongest input tone. The harmonics are measured
+// relative to the fundamental on both sides and the input's own share is
+// subtracted, so a tone that already carries harmonics reads what the tape
+// and transformer stages added. The main thread picks up the newest result
+// with TakeSnapshot; the worker and the main thread share a mutex, the
+// audio thread never sees it.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "CaptureRing.h"
+#include "FFT.h"
+
+class SpectrumAnalyser
+{
+public:
+  static constexpr int kFFTSize = 4096;
+  static constexpr int kNumBands = 64;
+  static constexpr double kMinHz = 20.0;
+  static constexpr double kMaxHz = 20000.0;
+  static constexpr double kFloorDb = -120.0;
+  static constexpr double kIntervalSec = 0.05;       // at most 20 spectra a second
+  static constexpr double kMinFundamentalDb = -60.0; // no harmonic readout below
+
+  struct Snapshot
+  {
+    std::array<float, kNumBands> input {};
+    std::array<float, kNumBands> output {};
+    float topHz = 0.0f;          // upper edge of the last band
+    float fundamentalHz = 0.0f;  // 0 when no input tone is loud enough
+    float secondDb = static_cast<float>(kFloorDb);
+    float thirdDb = static_cast<float>(kFloorDb);
+    uint64_t droppedFrames = 0;
+
+    // Same displayed values
+    bool SameReadings(const Snapshot& other) const
+    {
+      return input == other.input && output == other.output && topHz == other.topHz && fundamentalHz == other.fundamentalHz
+             && secondDb == other.secondDb && thirdDb == other.thirdDb;
+    }
+  };
+
+  SpectrumAnalyser() = default;
+  SpectrumAnalyser(const SpectrumAnalyser&) = delete;
+  SpectrumAnalyser& operator=(const SpectrumAnalyser&) = delete;
+  ~SpectrumAnalyser() { Stop(); }
+
+  // Main thread. Frames captured before this are skipped.
+  void Start(CaptureRing& ring)
+  {
+    Stop();
+    mRing = &ring;
+    mRunning = true;
+    mThread = std::thread([this] { Run(); });
+  }
+
+  // Main thread; returns once the worker has exited
+  void Stop()
+  {
+    if (!mThread.joinable())
+      return;
+    {
+      std::lock_guard<std::mutex> lock(mWakeMutex);
+      mRunning = false;
+    }
+    mWake.notify_one();
+    mThread.join();
+  }
+
+  // Main thread: copies the newest result, if there is one since the last call
+  bool TakeSnapshot(Snapshot& snapshot)
+  {
+    std::lock_guard<std::mutex> lock(mSnapshotMutex);
+    if (!mSnapshotReady)
+      return false;
+    snapshot = mSnapshot;
+    mSnapshotReady = false;
+    return true;
+  }
+
+private:
+  void Run()
+  {
+    std::vector<CaptureRing::Frame> chunk(CaptureRing::kCapacity);
+    std::vector<CaptureRing::Frame> history(kFFTSize);
+    std::vector<double> window(kFFTSize);
+    for (int i = 0; i < kFFTSize; ++i)
+      window[i] = 0.5 - 0.5 * std::cos(tapedsp::kTwoPi * i / kFFTSize);
+    std::vector<std::complex<double>> inputFrame(kFFTSize);
+    std::vector<std::complex<double>> outputFrame(kFFTSize);
+    std::vector<double> inputPower(kFFTSize / 2 + 1);
+    std::vector<double> outputPower(kFFTSize / 2 + 1);
+
+    uint32_t generation = mRing->GetGeneration() - 1;
+    int historyPos = 0;
+    int filled = 0;
+    const auto interval = std::chrono::duration<double>(kIntervalSec);
+
+    std::unique_lock<std::mutex> lock(mWakeMutex);
+    while (!mWake.wait_for(lock, interval, [this] { return !mRunning; }))
+    {
+      lock.unlock();
+
+      // A new sample rate (or the first pass) starts from an empty history
+      if (mRing->GetGeneration() != generation)
+      {
+        generation = mRing->GetGeneration();
+        mRing->Discard();
+        historyPos = 0;
+        filled = 0;
+      }
+
+      const int count = mRing->Read(chunk.data(), static_cast<int>(chunk.size()));
+      for (int i = std::max(0, count - kFFTSize); i < count; ++i)
+      {
+        history[historyPos] = chunk[i];
+        historyPos = (historyPos + 1) % kFFTSize;
+      }
+      filled = std::min(filled + count, kFFTSize);
+
+      if (count > 0 && filled == kFFTSize)
+      {
+        // Oldest frame first
+        for (int i = 0; i < kFFTSize; ++i)
+        {
+          const CaptureRing::Frame& frame = history[(historyPos + i) % kFFTSize];
+          inputFrame[i] = frame.input * window[i];
+          outputFrame[i] = frame.output * window[i];
+        }
+        PowerSpectrum(inputFrame, inputPower);
+        PowerSpectrum(outputFrame, outputPower);
+
+        Snapshot result;
+        Analyse(inputPower, outputPower, mRing->GetCaptureRate(), result);
+        result.droppedFrames = mRing->GetDroppedFrames();
+
+        std::lock_guard<std::mutex> snapshotLock(mSnapshotMutex);
+        mSnapshot = result;
+        mSnapshotReady = true;
+      }
+
+      lock.lock();
+    }
+  }
+
+  // Power per bin scaled so a full-scale sine peaks at 1 (0 dB)
+  static void PowerSpectrum(std::vector<std::complex<double>>& frame, std::vector<double>& power)
+  {
+    tapedsp::FFT(frame);
+    const double scale = 16.0 / (static_cast<double>(kFFTSize) * kFFTSize);
+    for (size_t k = 0; k < power.size(); ++k)
+      power[k] = std::norm(frame[k]) * scale;
+  }
+
+  static float ToDb(double power) { return static_cast<float>(power > 0.0 ? std::max(10.0 * std::log10(power), kFloorDb) : kFloorDb); }
+
+  static void Analyse(const std::vector<double>& inputPower, const std::vector<double>& outputPower, double rate, Snapshot& result)
+  {
+    const double binHz = rate / kFFTSize;
+    const int lastBin = kFFTSize / 2;
+    const double topHz = std::min(kMaxHz, 0.5 * rate);
+    result.topHz = static_cast<float>(topHz);
+
+    for (int band = 0; band < kNumBands; ++band)
+    {
+      const double lo = kMinHz * std::pow(topHz / kMinHz, static_cast<double>(band) / kNumBands);
+      const double hi = kMinHz * std::pow(topHz / kMinHz, static_cast<double>(band + 1) / kNumBands);
+      int first = static_cast<int>(std::ceil(lo / binHz));
+      int last = std::min(lastBin, static_cast<int>(std::floor(hi / binHz)));
+      // Low bands narrower than a bin take the nearest one
+      if (first > last)
+        first = last = std::clamp(static_cast<int>(std::lround(std::sqrt(lo * hi) / binHz)), 1, lastBin);
+      double inputPeak = 0.0;
+      double outputPeak = 0.0;
+      for (int k = first; k <= last; ++k)
+      {
+        inputPeak = std::max(inputPeak, inputPower[k]);
+        outputPeak = std::max(outputPeak, outputPower[k]);
+      }
+      result.input[band] = ToDb(inputPeak);
+      result.output[band] = ToDb(outputPeak);
+    }
+
+    // Strongest input tone low enough for its 3rd harmonic to fit, refined
+    // by a parabola through the log power around the peak bin
+    const int maxFundamentalBin = std::min(lastBin, static_cast<int>(0.5 * rate / 3.0 / binHz)) - 3;
+    int peak = 0;
+    for (int k = std::max(2, static_cast<int>(kMinHz / binHz)); k <= maxFundamentalBin; ++k)
+    {
+      if (peak == 0 || inputPower[k] > inputPower[peak])
+        peak = k;
+    }
+    if (peak == 0 || ToDb(inputPower[peak]) < kMinFundamentalDb)
+      return;
+
+    const double l = std::log(inputPower[peak - 1] + 1e-30);
+    const double c = std::log(inputPower[peak] + 1e-30);
+    const double r = std::log(inputPower[peak + 1] + 1e-30);
+    const double denom = l - 2.0 * c + r;
+    const double fundamentalBin = peak + (denom < 0.0 ? std::clamp(0.5 * (l - r) / denom, -0.5, 0.5) : 0.0);
+    result.fundamentalHz = static_cast<float>(fundamentalBin * binHz);
+
+    // Hann main lobe is +-2 bins; +-3 keeps the harmonic inside when the
+    // pitch is modulated slightly
+    auto harmonicPower = [&](const std::vector<double>& power, int h) {
+      const int centre = static_cast<int>(std::lround(h * fundamentalBin));
+      double sum = 0.0;
+      for (int k = std::max(1, centre - 3); k <= std::min(lastBin, centre + 3); ++k)
+        sum += power[k];
+      return sum;
+    };
+    const double inputFundamental = harmonicPower(inputPower, 1) + 1e-30;
+    const double outputFundamental = harmonicPower(outputPower, 1) + 1e-30;
+    if (ToDb(outputFundamental) <= kFloorDb)
+      return;
+    auto addedDb = [&](int h) {
+      return ToDb(harmonicPower(outputPower, h) / outputFundamental - harmonicPower(inputPower, h) / inputFundamental);
+    };
+    result.secondDb = addedDb(2);
+    result.thirdDb = addedDb(3);
+  }
+
+  CaptureRing* mRing = nullptr;
+  std::thread mThread;
+  std::mutex mWakeMutex;
+  std::condition_variable mWake;
+  bool mRunning = false;  // guarded by mWakeMutex
+
+  std::mutex mSnapshotMutex;
+  Snapshot mSnapshot;     // guarded by mSnapshotMutex
+  bool mSnapshotReady = false;
+};
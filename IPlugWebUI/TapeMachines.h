@@ -0,0 +1,236 @@
+#pragma once
+
+// Tape machine models. Each policy class describes one machine as a set of
+// constants: the input transformer, the tape compression/saturation stage and
+// the fixed tone curve (head bump, presence, HF loss). TapeSaturatorDSP
+// instantiates its render kernels per policy (MachinePolicy), so the
+// per-sample constants are folded in at compile time; block-rate code reads
+// the same models from kMachineModels. Switching models only selects another
+// kernel and redesigns the tone sections, without allocating.
+//
+// MachineModel's defaults are the Studio machine, the original sound of the
+// plug-in; the other models override what differs.
+
+#include <array>
+#include <tuple>
+
+enum EMachine
+{
+  kMachineStudio = 0,  // studio reel-to-reel (Studer A800-inspired)
+  kMachineCassette,    // compact cassette deck
+  kMachineCart,        // broadcast cart (NAB cartridge)
+  kMachineSampler,     // vintage sampler input stage
+  kNumMachines
+};
+
+struct MachineModel
+{
+  // Preamp: drive 0..1 maps to driveLinear * preampRangeDb + preampOffsetDb
+  double preampRangeDb = 30.0;
+  double preampOffsetDb = -4.0;
+
+  // Transformer (per block, each as base + driveLinear * drive)
+  double sagBase = 0.992;
+  double sagDrive = -0.028;
+  double biasFollow = 0.982;
+  double asymmetryBase = 0.02;
+  double asymmetryDrive = 0.09;
+  double evenBase = 0.35;
+  double evenDrive = 0.4;
+  double triodeBase = 1.15;
+  double triodeDrive = 1.3;
+  double oddBlendBase = 0.45;
+  double oddBlendDrive = 0.25;
+  double finalSatBase = 0.95;
+  double finalSatDrive = 1.2;
+  double coilLowpassHz = 16000.0;
+  double coilLowpassDriveHz = -5500.0;
+  double coilLowpassMinHz = 8000.0;
+  double coilLowpassMaxHz = 18000.0;
+
+  // Transformer (per sample)
+  double sagDepthBase = 0.35;
+  double sagDepthDrive = 0.45;
+  double biasMixBase = 0.65;
+  double biasMixDrive = 0.25;
+  double oddDriveBoost = 0.25;
+  double oddCubicBase = 0.22;
+  double oddCubicDrive = 0.18;
+  double biasRemoval = 0.55;
+
+  // Tape compression and saturation
+  double tapeCompressionBase = 0.28;
+  double tapeCompressionDrive = 0.22;
+  double tapeDriveBase = 1.25;
+  double tapeDriveDrive = 0.35;
+  double attackSec = 0.004;   // ~4ms attack for tape compression
+  double releaseSec = 0.12;   // ~120ms release mimicking tape recovery
+  double saturationMix = 0.32;
+
+  // Fixed tone curve; ToneLow/ToneHigh add to the shelf gains, ToneMidQ
+  // offsets the bell
+  double lowShelfHz = 110.0;
+  double lowShelfDb = 1.5;
+  double lowShelfQ = 0.74;
+  double midHz = 3800.0;
+  double midDb = 0.6;
+  double midQ = 1.1;
+  double highShelfHz = 12500.0;
+  double highShelfDb = -1.75;
+  double highShelfQ = 0.8;
+};
+
+struct StudioMachine
+{
+  static constexpr MachineModel Model() { return MachineModel {}; }
+};
+
+// Narrow tape and small heads: strong head bump, early HF loss, more
+// compression and a grainier transformer
+struct CassetteMachine
+{
+  static constexpr MachineModel Model()
+  {
+    MachineModel m;
+    m.sagBase = 0.989;
+    m.sagDrive = -0.034;
+    m.asymmetryBase = 0.03;
+    m.asymmetryDrive = 0.12;
+    m.evenBase = 0.4;
+    m.evenDrive = 0.45;
+    m.triodeBase = 1.25;
+    m.triodeDrive = 1.4;
+    m.oddBlendBase = 0.5;
+    m.finalSatBase = 1.05;
+    m.finalSatDrive = 1.3;
+    m.coilLowpassHz = 12500.0;
+    m.coilLowpassDriveHz = -4500.0;
+    m.coilLowpassMinHz = 6000.0;
+    m.coilLowpassMaxHz = 14000.0;
+    m.sagDepthBase = 0.45;
+    m.sagDepthDrive = 0.5;
+    m.biasMixBase = 0.7;
+    m.oddDriveBoost = 0.3;
+    m.oddCubicBase = 0.26;
+    m.oddCubicDrive = 0.2;
+    m.tapeCompressionBase = 0.36;
+    m.tapeCompressionDrive = 0.26;
+    m.tapeDriveBase = 1.4;
+    m.tapeDriveDrive = 0.45;
+    m.attackSec = 0.006;
+    m.releaseSec = 0.2;
+    m.saturationMix = 0.4;
+    m.lowShelfHz = 85.0;
+    m.lowShelfDb = 2.5;
+    m.lowShelfQ = 0.7;
+    m.midHz = 2600.0;
+    m.midDb = -0.4;
+    m.midQ = 0.9;
+    m.highShelfHz = 8500.0;
+    m.highShelfDb = -4.5;
+    m.highShelfQ = 0.7;
+    return m;
+  }
+};
+
+// Endless-loop cartridge for radio playout: lean bass, forward presence and
+// fast, firm compression
+struct CartMachine
+{
+  static constexpr MachineModel Model()
+  {
+    MachineModel m;
+    m.sagBase = 0.993;
+    m.sagDrive = -0.025;
+    m.asymmetryBase = 0.015;
+    m.asymmetryDrive = 0.07;
+    m.evenBase = 0.3;
+    m.evenDrive = 0.35;
+    m.triodeBase = 1.1;
+    m.triodeDrive = 1.2;
+    m.oddBlendBase = 0.4;
+    m.finalSatBase = 0.9;
+    m.finalSatDrive = 1.1;
+    m.coilLowpassHz = 14500.0;
+    m.coilLowpassDriveHz = -4000.0;
+    m.coilLowpassMinHz = 9000.0;
+    m.coilLowpassMaxHz = 16000.0;
+    m.tapeCompressionBase = 0.4;
+    m.tapeCompressionDrive = 0.3;
+    m.tapeDriveBase = 1.2;
+    m.tapeDriveDrive = 0.3;
+    m.attackSec = 0.002;
+    m.releaseSec = 0.08;
+    m.saturationMix = 0.26;
+    m.lowShelfHz = 160.0;
+    m.lowShelfDb = -1.5;
+    m.lowShelfQ = 0.7;
+    m.midHz = 2800.0;
+    m.midDb = 1.8;
+    m.midQ = 1.2;
+    m.highShelfHz = 11000.0;
+    m.highShelfDb = -2.5;
+    return m;
+  }
+};
+
+// Sampler line input: clean transformer, little sag, warm low mids and a
+// hard-driven converter front end
+struct SamplerMachine
+{
+  static constexpr MachineModel Model()
+  {
+    MachineModel m;
+    m.preampRangeDb = 28.0;
+    m.preampOffsetDb = -3.0;
+    m.sagBase = 0.995;
+    m.sagDrive = -0.02;
+    m.asymmetryBase = 0.01;
+    m.asymmetryDrive = 0.05;
+    m.evenBase = 0.25;
+    m.evenDrive = 0.3;
+    m.triodeBase = 1.05;
+    m.triodeDrive = 1.1;
+    m.oddBlendBase = 0.55;
+    m.oddBlendDrive = 0.2;
+    m.finalSatBase = 1.0;
+    m.finalSatDrive = 1.35;
+    m.coilLowpassHz = 15000.0;
+    m.coilLowpassDriveHz = -3000.0;
+    m.coilLowpassMinHz = 10000.0;
+    m.coilLowpassMaxHz = 17000.0;
+    m.sagDepthBase = 0.25;
+    m.sagDepthDrive = 0.35;
+    m.tapeCompressionBase = 0.2;
+    m.tapeCompressionDrive = 0.18;
+    m.tapeDriveBase = 1.3;
+    m.tapeDriveDrive = 0.5;
+    m.attackSec = 0.003;
+    m.releaseSec = 0.09;
+    m.saturationMix = 0.22;
+    m.lowShelfHz = 95.0;
+    m.lowShelfDb = 3.0;
+    m.lowShelfQ = 0.8;
+    m.midHz = 1800.0;
+    m.midDb = 0.8;
+    m.midQ = 0.8;
+    m.highShelfHz = 11500.0;
+    m.highShelfDb = -3.0;
+    m.highShelfQ = 0.75;
+    return m;
+  }
+};
+
+// Policy class of each EMachine
+using MachinePolicies = std::tuple<StudioMachine, CassetteMachine, CartMachine, SamplerMachine>;
+static_assert(std::tuple_size_v<MachinePolicies> == kNumMachines, "one policy per EMachine");
+template <int Machine>
+using MachinePolicy = std::tuple_element_t<Machine, MachinePolicies>;
+
+// Indexed by EMachine
+inline constexpr std::array<MachineModel, kNumMachines> kMachineModels = {{
+  MachinePolicy<kMachineStudio>::Model(),
+  MachinePolicy<kMachineCassette>::Model(),
+  MachinePolicy<kMachineCart>::Model(),
+  MachinePolicy<kMachineSampler>::Model(),
+}};
@@ -0,0 +1,2359 @@
+#pragma once
+
+// Headless DSP core of the Lofi Tape Saturator.
+// Has no iPlug2 dependency so the same processing runs inside the plug-in
+// and in the offline tools under tools/.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "LoudnessMeter.h"
+#include "Multiband.h"
+#include "TapeMachines.h"
+#include "TruePeakLimiter.h"
+
+namespace tapedsp
+{
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kTwoPi = 6.28318530717958647693;
+constexpr double kMinQ = 0.0001;
+constexpr double kRandNorm = 1.0 / 4294967296.0; // 1 / 2^32
+constexpr size_t kCacheLineSize = 64;
+
+inline double NextRandom(uint32_t& state)
+{
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return static_cast<double>(state) * kRandNorm;
+}
+
+// Rational (Lambert continued fraction) tanh, within 1e-4 of std::tanh over
+// the whole range. Used by the reduced quality tiers.
+inline double FastTanh(double x)
+{
+  x = std::clamp(x, -4.97, 4.97);
+  const double x2 = x * x;
+  return x * (135135.0 + x2 * (17325.0 + x2 * (378.0 + x2))) / (135135.0 + x2 * (62370.0 + x2 * (3150.0 + 28.0 * x2)));
+}
+
+// True if none of data[0, n) is NaN or infinite. x * 0 is 0 for every finite
+// x and NaN otherwise; four independent sums keep the loop free of a serial
+// dependency so the compiler vectorises it.
+template <typename T>
+inline bool AllFinite(const T* data, int n)
+{
+  T acc[4] = {};
+  int i = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    for (int k = 0; k < 4; ++k)
+      acc[k] += data[i + k] * T(0);
+  }
+  for (; i < n; ++i)
+    acc[0] += data[i] * T(0);
+  return (acc[0] + acc[1]) + (acc[2] + acc[3]) == T(0);
+}
+
+inline void NormaliseBiquad(double& b0, double& b1, double& b2, double& a0, double& a1, double& a2)
+{
+  if (std::fabs(a0) < 1e-12)
+  {
+    b0 = 1.0;
+    b1 = b2 = a1 = a2 = 0.0;
+    return;
+  }
+  b0 /= a0;
+  b1 /= a0;
+  b2 /= a0;
+  a1 /= a0;
+  a2 /= a0;
+}
+} // namespace tapedsp
+
+enum EParams
+{
+  kParamDriveGain = 0,
+  kParamDriveVU,
+  kParamToneLowGain,
+  kParamToneHighGain,
+  kParamToneMidQ,
+  kParamMpcBits,
+  kParamResampleRatio,
+  kParamWowAmount,
+  kParamWowRate,
+  kParamFlutterAmount,
+  kParamFlutterRate,
+  kParamNoiseLevel,
+  kParamLowPassCutoff,
+  kParamLowPassResonance,
+  kParamOutputGain,
+  kParamClipThreshold,
+  kParamClipMode,
+  kParamClipSlope,
+  kParamPower,
+  kParamTruePeak,
+  kParamTruePeakLookahead,
+  kParamQualityMode,
+  kParamQualityTier,
+  kParamMachine,
+  kParamBands,
+  kParamCrossoverLow,
+  kParamCrossoverMid,
+  kParamCrossoverHigh,
+  kParamBandDrive1,
+  kParamBandDrive2,
+  kParamBandDrive3,
+  kParamBandDrive4,
+  kParamBandSag1,
+  kParamBandSag2,
+  kParamBandSag3,
+  kParamBandSag4,
+  kParamAutoGain,
+  kNumParams
+};
+
+enum EClipMode
+{
+  kClipModeHard = 0,
+  kClipModeSoft,
+  kClipModeTanh,
+  kNumClipModes
+};
+
+// Processing cost profiles, most expensive first. High is the reference sound;
+// Eco uses a rational tanh and filters the noise components in one pass;
+// Draft also reads the wow/flutter delay without interpolation and runs the
+// true-peak detector at 2x.
+enum EQualityTier
+{
+  kQualityTierHigh = 0,
+  kQualityTierEco,
+  kQualityTierDraft,
+  kNumQualityTiers
+};
+
+// QualityMode parameter: Auto lets the host-side governor pick the tier
+enum EQualityMode
+{
+  kQualityModeAuto = 0,
+  kQualityModeHigh,
+  kQualityModeEco,
+  kQualityModeDraft,
+  kNumQualityModes
+};
+
+// Name, default and range of each parameter, mirroring the IParam setup in
+// the IPlugWebUI constructor. Used by the headless tools to resolve
+// parameters by name and to start from the plug-in defaults.
+struct TapeParamSpec
+{
+  const char* name;
+  double defaultValue;
+  double minValue;
+  double maxValue;
+};
+
+inline const TapeParamSpec& GetTapeParamSpec(int paramIdx)
+{
+  static const TapeParamSpec kSpecs[kNumParams] = {
+    {"DriveGain", 0.2, 0.0, 1.0},
+    {"DriveVU", 0.0, 0.0, 1.0},
+    {"ToneLow", 0.0, -12.0, 12.0},
+    {"ToneHigh", 0.0, -12.0, 12.0},
+    {"ToneMidQ", 1.0, 0.5, 2.0},
+    {"MPCBits", 16.0, 1.0, 16.0},
+    {"ResampleRatio", 1.0, 0.25, 4.0},
+    {"WowAmount", 0.02, 0.0, 0.1},
+    {"WowRate", 0.2, 0.05, 5.0},
+    {"FlutterAmount", 0.01, 0.0, 0.05},
+    {"FlutterRate", 8.0, 1.0, 40.0},
+    {"NoiseLevel", 0.0, 0.0, 100.0},
+    {"LowPassCutoff", 14000.0, 200.0, 20000.0},
+    {"LowPassResonance", 0.2, 0.0, 1.0},
+    {"Output", 0.0, -12.0, 12.0},
+    {"ClipThreshold", 1.0, 0.0, 1.0},
+    {"ClipMode", static_cast<double>(kClipModeTanh), 0.0, static_cast<double>(kNumClipModes - 1)},
+    {"ClipSlope", 0.5, 0.0, 1.0},
+    {"Power", 1.0, 0.0, 1.0},
+    {"TruePeak", 0.0, 0.0, 1.0},
+    {"TruePeakLookahead", 1.5, 0.0, 5.0},
+    {"QualityMode", static_cast<double>(kQualityModeAuto), 0.0, static_cast<double>(kNumQualityModes - 1)},
+    {"QualityTier", 0.0, 0.0, static_cast<double>(kNumQualityTiers - 1)},
+    {"Machine", static_cast<double>(kMachineStudio), 0.0, static_cast<double>(kNumMachines - 1)},
+    {"Bands", 1.0, 1.0, 4.0},
+    {"CrossoverLow", 250.0, 40.0, 1000.0},
+    {"CrossoverMid", 1800.0, 300.0, 6000.0},
+    {"CrossoverHigh", 7000.0, 2000.0, 16000.0},
+    {"BandDrive1", 0.0, -1.0, 1.0},
+    {"BandDrive2", 0.0, -1.0, 1.0},
+    {"BandDrive3", 0.0, -1.0, 1.0},
+    {"BandDrive4", 0.0, -1.0, 1.0},
+    {"BandSag1", 1.0, 0.0, 2.0},
+    {"BandSag2", 1.0, 0.0, 2.0},
+    {"BandSag3", 1.0, 0.0, 2.0},
+    {"BandSag4", 1.0, 0.0, 2.0},
+    {"AutoGain", 0.0, 0.0, 1.0},
+  };
+  return kSpecs[paramIdx];
+}
+
+// Returns -1 if no parameter has that name (case-sensitive)
+inline int FindTapeParam(const char* name)
+{
+  for (int i = 0; i < kNumParams; ++i)
+  {
+    if (std::strcmp(GetTapeParamSpec(i).name, name) == 0)
+      return i;
+  }
+  return -1;
+}
+
+// A parameter change at a frame inside the block being processed, as
+// delivered by sample-accurate hosts (CLAP events, VST3 parameter queues)
+struct TapeParamEvent
+{
+  int offset;    // frame within the block
+  int paramIdx;
+  double value;  // IParam::Value() domain, as for SetParam
+};
+
+struct BiquadCoeffs
+{
+  double b0 = 1.0;
+  double b1 = 0.0;
+  double b2 = 0.0;
+  double a1 = 0.0;
+  double a2 = 0.0;
+};
+
+enum EBiquadShape
+{
+  kBiquadLowShelf = 0,
+  kBiquadHighShelf,
+  kBiquadPeaking,
+  kBiquadLowPass
+};
+
+// RBJ cookbook designs (resonance is used as Q for the low-pass)
+inline BiquadCoeffs DesignBiquad(EBiquadShape shape, double sampleRate, double freq, double gainDB, double q)
+{
+  using namespace tapedsp;
+
+  BiquadCoeffs c;
+  if (sampleRate <= 0.0 || freq <= 0.0)
+    return c;
+
+  // Past Nyquist sin(w0) turns negative and the poles leave the unit circle
+  // (the machine shelves at 22.05 kHz)
+  freq = std::min(freq, 0.49 * sampleRate);
+  const double w0 = 2.0 * kPi * freq / sampleRate;
+  const double cosw0 = std::cos(w0);
+  const double sinw0 = std::sin(w0);
+  const double alpha = sinw0 / (2.0 * std::max(q, kMinQ));
+
+  double a0 = 1.0;
+
+  switch (shape)
+  {
+    case kBiquadLowShelf:
+    {
+      const double A = std::pow(10.0, gainDB / 40.0);
+      const double beta = 2.0 * std::sqrt(A) * alpha;
+      a0 = (A + 1.0) + (A - 1.0) * cosw0 + beta;
+      c.a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cosw0);
+      c.a2 = (A + 1.0) + (A - 1.0) * cosw0 - beta;
+      c.b0 = A * ((A + 1.0) - (A - 1.0) * cosw0 + beta);
+      c.b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cosw0);
+      c.b2 = A * ((A + 1.0) - (A - 1.0) * cosw0 - beta);
+      break;
+    }
+    case kBiquadHighShelf:
+    {
+      const double A = std::pow(10.0, gainDB / 40.0);
+      const double beta = 2.0 * std::sqrt(A) * alpha;
+      a0 = (A + 1.0) - (A - 1.0) * cosw0 + beta;
+      c.a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cosw0);
+      c.a2 = (A + 1.0) - (A - 1.0) * cosw0 - beta;
+      c.b0 = A * ((A + 1.0) + (A - 1.0) * cosw0 + beta);
+      c.b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cosw0);
+      c.b2 = A * ((A + 1.0) + (A - 1.0) * cosw0 - beta);
+      break;
+    }
+    case kBiquadPeaking:
+    {
+      const double A = std::pow(10.0, gainDB / 40.0);
+      a0 = 1.0 + alpha / A;
+      c.a1 = -2.0 * cosw0;
+      c.a2 = 1.0 - alpha / A;
+      c.b0 = 1.0 + alpha * A;
+      c.b1 = -2.0 * cosw0;
+      c.b2 = 1.0 - alpha * A;
+      break;
+    }
+    case kBiquadLowPass:
+    default:
+    {
+      a0 = 1.0 + alpha;
+      c.a1 = -2.0 * cosw0;
+      c.a2 = 1.0 - alpha;
+      c.b0 = (1.0 - cosw0) * 0.5;
+      c.b1 = 1.0 - cosw0;
+      c.b2 = (1.0 - cosw0) * 0.5;
+      break;
+    }
+  }
+
+  NormaliseBiquad(c.b0, c.b1, c.b2, a0, c.a1, c.a2);
+  return c;
+}
+
+struct BiquadFilter
+{
+  double b0 = 1.0;
+  double b1 = 0.0;
+  double b2 = 0.0;
+  double a1 = 0.0;
+  double a2 = 0.0;
+  std::array<double, 2> z1 {{0.0, 0.0}};
+  std::array<double, 2> z2 {{0.0, 0.0}};
+
+  inline double Process(double input, int channel)
+  {
+    const size_t idx = static_cast<size_t>(channel > 0 ? 1 : 0);
+    const double out = b0 * input + z1[idx];
+    z1[idx] = b1 * input - a1 * out + z2[idx];
+    z2[idx] = b2 * input - a2 * out;
+    return out;
+  }
+
+  void Reset()
+  {
+    z1.fill(0.0);
+    z2.fill(0.0);
+  }
+
+  bool IsFinite() const { return tapedsp::AllFinite(z1.data(), 2) && tapedsp::AllFinite(z2.data(), 2); }
+
+  void SetCoeffs(const BiquadCoeffs& c)
+  {
+    b0 = c.b0;
+    b1 = c.b1;
+    b2 = c.b2;
+    a1 = c.a1;
+    a2 = c.a2;
+  }
+
+  void SetLowShelf(double sampleRate, double freq, double gainDB, double q) { SetCoeffs(DesignBiquad(kBiquadLowShelf, sampleRate, freq, gainDB, q)); }
+  void SetHighShelf(double sampleRate, double freq, double gainDB, double q) { SetCoeffs(DesignBiquad(kBiquadHighShelf, sampleRate, freq, gainDB, q)); }
+  void SetPeaking(double sampleRate, double freq, double gainDB, double q) { SetCoeffs(DesignBiquad(kBiquadPeaking, sampleRate, freq, gainDB, q)); }
+  void SetLowPass(double sampleRate, double freq, double resonance) { SetCoeffs(DesignBiquad(kBiquadLowPass, sampleRate, freq, 0.0, resonance)); }
+};
+
+// TONE stage: low shelf -> mid bell -> high shelf in one call, coefficients
+// next to each other. The sections stay a serial chain (each one needs the
+// previous one's output for the same sample), so the parallelism is across
+// channels: ProcessStereo runs left and right in the two lanes of a Double2,
+// with the same arithmetic per lane as Process. The saving under automation is
+// in ToneCoeffCache.
+struct ToneCascade
+{
+  enum ESection
+  {
+    kLowShelf = 0,
+    kMidBell,
+    kHighShelf,
+    kNumSections
+  };
+
+  std::array<BiquadCoeffs, kNumSections> coeffs {};
+  // z[section] = {z1[left], z1[right], z2[left], z2[right]}
+  std::array<std::array<double, 4>, kNumSections> z {};
+
+  inline double Process(double input, int channel)
+  {
+    const int lane = channel > 0 ? 1 : 0;
+    double x = input;
+    for (int i = 0; i < kNumSections; ++i)
+    {
+      const BiquadCoeffs& c = coeffs[i];
+      double* const s = z[i].data();
+      const double y = c.b0 * x + s[lane];
+      s[lane] = c.b1 * x - c.a1 * y + s[2 + lane];
+      s[2 + lane] = c.b2 * x - c.a2 * y;
+      x = y;
+    }
+    return x;
+  }
+
+  // Both channels at once; out may alias in.
+  inline void ProcessStereo(const double* in, double* out)
+  {
+    tapedsp::Double2 x = tapedsp::Load2(in);
+    for (int i = 0; i < kNumSections; ++i)
+    {
+      const BiquadCoeffs& c = coeffs[i];
+      double* const s = z[i].data();
+      const tapedsp::Double2 y = tapedsp::Broadcast2(c.b0) * x + tapedsp::Load2(s);
+      tapedsp::Store(tapedsp::Broadcast2(c.b1) * x - tapedsp::Broadcast2(c.a1) * y + tapedsp::Load2(s + 2), s);
+      tapedsp::Store(tapedsp::Broadcast2(c.b2) * x - tapedsp::Broadcast2(c.a2) * y, s + 2);
+      x = y;
+    }
+    tapedsp::Store(x, out);
+  }
+
+  void Reset()
+  {
+    for (auto& section : z)
+      section.fill(0.0);
+  }
+
+  bool IsFinite() const
+  {
+    for (const auto& section : z)
+      if (!tapedsp::AllFinite(section.data(), 4))
+        return false;
+    return true;
+  }
+};
+
+// Memoises tone section designs. Each section remembers the inputs of its
+// current design so unchanged sections cost four compares, and a small
+// direct-mapped table per section serves values that come back (automation
+// loops, preset recalls) without touching pow/cos/sin again.
+class ToneCoeffCache
+{
+public:
+  // Returns true if the section's coefficients were (re)assigned.
+  bool Update(int section, EBiquadShape shape, double sampleRate, double freq, double gainDB, double q, BiquadCoeffs& out)
+  {
+    Entry& current = mCurrent[section];
+    if (current.Matches(sampleRate, freq, gainDB, q))
+      return false;
+
+    // Direct-mapped slot from the raw bits of the inputs that actually vary
+    uint64_t gainBits, qBits, srBits;
+    std::memcpy(&gainBits, &gainDB, sizeof(gainBits));
+    std::memcpy(&qBits, &q, sizeof(qBits));
+    std::memcpy(&srBits, &sampleRate, sizeof(srBits));
+    uint64_t h = gainBits ^ (qBits * 0x9E3779B97F4A7C15ull) ^ (srBits >> 17);
+    h ^= h >> 33; // fmix64: parameter values mostly differ in their high bits
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    Entry& slot = mSlots[section][static_cast<size_t>(h % kSlotsPerSection)];
+
+    if (!slot.Matches(sampleRate, freq, gainDB, q))
+    {
+      slot.sampleRate = sampleRate;
+      slot.freq = freq;
+      slot.gainDB = gainDB;
+      slot.q = q;
+      slot.coeffs = DesignBiquad(shape, sampleRate, freq, gainDB, q);
+      slot.valid = true;
+      ++mDesignCount;
+    }
+
+    current = slot;
+    out = slot.coeffs;
+    return true;
+  }
+
+  void Clear()
+  {
+    for (auto& entry : mCurrent)
+      entry.valid = false;
+    for (auto& section : mSlots)
+      for (auto& entry : section)
+        entry.valid = false;
+  }
+
+  uint32_t GetDesignCount() const { return mDesignCount; }
+
+private:
+  struct Entry
+  {
+    double sampleRate = 0.0;
+    double freq = 0.0;
+    double gainDB = 0.0;
+    double q = 0.0;
+    BiquadCoeffs coeffs;
+    bool valid = false;
+
+    bool Matches(double sr, double f, double g, double qq) const
+    {
+      return valid && sampleRate == sr && freq == f && gainDB == g && q == qq;
+    }
+  };
+
+  static constexpr int kSlotsPerSection = 32;
+  std::array<Entry, ToneCascade::kNumSections> mCurrent {};
+  std::array<std::array<Entry, kSlotsPerSection>, ToneCascade::kNumSections> mSlots {};
+  uint32_t mDesignCount = 0;
+};
+
+// One-pole smoother in the log domain, same response as iPlug's LogParamSmooth
+class OnePoleSmoother
+{
+public:
+  void SetSmoothTime(double timeMs, double sampleRate)
+  {
+    mA = std::exp(-tapedsp::kTwoPi / (timeMs * 0.001 * sampleRate));
+    mB = 1.0 - mA;
+  }
+
+  void SetValue(double value) { mState = value; }
+  double GetValue() const { return mState; }
+
+  inline double Process(double input)
+  {
+    mState = input * mB + mState * mA;
+    return mState;
+  }
+
+private:
+  double mA = std::exp(-tapedsp::kTwoPi / (5.0 * 0.001 * 44100.0));
+  double mB = 1.0 - std::exp(-tapedsp::kTwoPi / (5.0 * 0.001 * 44100.0));
+  double mState = 0.0;
+};
+
+// Bit mask of pending work, set from any thread and consumed by the audio
+// thread. Set publishes with release, so the values written before it are
+// visible to the Take that picks the bits up. Copies take a relaxed
+// snapshot, which is only meant for LoadState.
+class DirtyMask
+{
+public:
+  explicit DirtyMask(unsigned bits) : mBits(bits) {}
+  DirtyMask(const DirtyMask& other) : mBits(other.Peek()) {}
+  DirtyMask& operator=(const DirtyMask& other)
+  {
+    mBits.store(other.Peek(), std::memory_order_relaxed);
+    return *this;
+  }
+
+  void Set(unsigned bits) { mBits.fetch_or(bits, std::memory_order_release); }
+  // Clears the mask and returns what was set
+  unsigned Take() { return mBits.exchange(0, std::memory_order_acquire); }
+  // Clears and returns only the given bits
+  unsigned Take(unsigned bits) { return mBits.fetch_and(~bits, std::memory_order_acquire) & bits; }
+  unsigned Peek() const { return mBits.load(std::memory_order_relaxed); }
+  void Store(unsigned bits) { mBits.store(bits, std::memory_order_relaxed); }
+
+private:
+  std::atomic<unsigned> mBits;
+};
+
+class TapeSaturatorDSP
+{
+public:
+  static constexpr int kMaxChannels = 2;
+  static constexpr double kDefaultSampleRate = 44100.0;
+  // Identifies the rendered output. Offline render caches key on it; bump it
+  // in every change that alters the samples ProcessBlock produces for the same
+  // input, parameters and seed, the way kStateVersion follows VisitState.
+  static constexpr uint32_t kRenderVersion = 1;
+
+  // Construction is cheap: the delay line is allocated and the filters are
+  // designed in the first Reset, once the sample rate is known. Until then
+  // SetParam only records values and ProcessBlock passes audio through.
+  TapeSaturatorDSP() = default;
+
+  // Sets every parameter to the plug-in default
+  void ApplyDefaults()
+  {
+    for (int i = 0; i < kNumParams; ++i)
+      SetParam(i, GetTapeParamSpec(i).defaultValue);
+  }
+
+  // value is in the IParam::Value() domain (e.g. NoiseLevel in percent)
+  void SetParam(int paramIdx, double value)
+  {
+    // A non-finite value would poison every derived coefficient; keep the last
+    // good one
+    if (!std::isfinite(value))
+      return;
+
+    switch (paramIdx)
+    {
+      case kParamDriveGain:
+        mDriveGain = value;
+        mDriveSmoother.SetValue(mDriveGain);
+        mDerivedDirty.Set(kDirtyDrive);
+        break;
+      case kParamDriveVU: break; // read-only meter
+      case kParamQualityMode: break; // resolved to a tier by the caller, see SetQualityTier
+      case kParamQualityTier: break; // read-only display
+      case kParamToneLowGain:
+        mToneLowGain = value;
+        UpdateToneFilters();
+        break;
+      case kParamToneHighGain:
+        mToneHighGain = value;
+        UpdateToneFilters();
+        break;
+      case kParamToneMidQ:
+        mToneMidQ = value;
+        UpdateToneFilters();
+        break;
+      case kParamMpcBits:
+        mMpcBits = static_cast<int>(value);
+        mDerivedDirty.Set(kDirtyCrusher);
+        break;
+      case kParamResampleRatio:
+        mResampleRatio = value;
+        mDerivedDirty.Set(kDirtyResampler);
+        break;
+      case kParamWowAmount:
+        mWowAmount = value;
+        mDerivedDirty.Set(kDirtyWow);
+        break;
+      case kParamWowRate:
+        mWowRate = value;
+        RefreshWowFlutterIncrements();
+        break;
+      case kParamFlutterAmount:
+        mFlutterAmount = value;
+        mDerivedDirty.Set(kDirtyWow);
+        break;
+      case kParamFlutterRate:
+        mFlutterRate = value;
+        RefreshWowFlutterIncrements();
+        break;
+      case kParamNoiseLevel:
+        mNoiseLevel = value * 0.01;
+        mDerivedDirty.Set(kDirtyNoise);
+        break;
+      case kParamLowPassCutoff:
+        mLowPassCutoff = value;
+        UpdateLowPassFilter();
+        break;
+      case kParamLowPassResonance:
+        mLowPassResonance = value;
+        UpdateLowPassFilter();
+        break;
+      case kParamOutputGain:
+        mOutputGainDB = value;
+        mOutputGainLinear = std::pow(10.0, mOutputGainDB / 20.0);
+        mDerivedDirty.Set(kDirtyOutput);
+        break;
+      case kParamClipThreshold:
+        mClipThreshold = value;
+        mDerivedDirty.Set(kDirtyClip);
+        break;
+      case kParamClipMode: mClipMode = static_cast<int>(value); break;
+      case kParamClipSlope:
+        mClipSlope = value;
+        mDerivedDirty.Set(kDirtyClip);
+        break;
+      case kParamPower: mPowerOn = value >= 0.5; break;
+      case kParamTruePeak:
+        // Switching on starts from a clean limiter (see ProcessChannels)
+        if (!mTruePeakOn && value >= 0.5)
+          mDerivedDirty.Set(kDirtyLimiter);
+        mTruePeakOn = value >= 0.5;
+        break;
+      case kParamTruePeakLookahead:
+        mTruePeakLookaheadMs = value;
+        mDerivedDirty.Set(kDirtyLimiter);
+        break;
+      case kParamMachine:
+        mMachine = std::clamp(static_cast<int>(value), 0, kNumMachines - 1);
+        mDerivedDirty.Set(kDirtyDrive);
+        UpdateToneFilters();
+        UpdateTapeEnvelope();
+        break;
+      case kParamBands:
+        mBands = std::clamp(static_cast<int>(value), 1, tapedsp::BandSplitter::kMaxBands);
+        mDerivedDirty.Set(kDirtyBands);
+        break;
+      case kParamCrossoverLow:
+      case kParamCrossoverMid:
+      case kParamCrossoverHigh:
+        mCrossover[paramIdx - kParamCrossoverLow] = value;
+        mDerivedDirty.Set(kDirtyBands);
+        break;
+      case kParamBandDrive1:
+      case kParamBandDrive2:
+      case kParamBandDrive3:
+      case kParamBandDrive4:
+        mBandDrive[paramIdx - kParamBandDrive1] = value;
+        mDerivedDirty.Set(kDirtyDrive);
+        break;
+      case kParamBandSag1:
+      case kParamBandSag2:
+      case kParamBandSag3:
+      case kParamBandSag4:
+        mBandSag[paramIdx - kParamBandSag1] = value;
+        mDerivedDirty.Set(kDirtyDrive);
+        break;
+      case kParamAutoGain:
+        // A fresh measurement; the previous one may be long out of date. The
+        // meter belongs to the audio thread, so PrepareBlock resets it.
+        if (!mAutoGainOn && value >= 0.5)
+          mDerivedDirty.Set(kDirtyLoudness);
+        mAutoGainOn = value >= 0.5;
+        break;
+      default: break;
+    }
+  }
+
+  void Reset(double sr)
+  {
+    mSampleRate = sr;
+    mPrepared = true;
+    const double sampleRate = std::max(sr, 1.0);
+
+    mDriveSmoother.SetSmoothTime(5., sr);
+    mDriveSmoother.SetValue(mDriveGain);
+    mDerivedDirty.Set(kDirtyAll | kSnapRamps);
+    mLastPeak = 0.0f;
+    mRecoveryGain.fill(1.0);
+    mLoudness.Reset(sampleRate);
+    mCompensationDb.fill(0.0);
+    mCompensationGain.fill(1.0);
+
+    UpdateTapeEnvelope();
+    UpdateToneFilters();
+    UpdateLowPassFilter();
+
+    // Initialize dedicated noise LPF at 6kHz for softer vinyl sound
+    mNoiseLowPassFilter.SetLowPass(sampleRate, 6000.0, 0.7);
+
+    mLimiter.Configure(sampleRate, mTruePeakLookaheadMs);
+    mDerivedDirty.Take(kDirtyLimiter);
+    mHot.interpBlend = mQualityTier == kQualityTierDraft ? 0.0 : 1.0;
+
+    if (mDeterministic)
+    {
+      // Same seeds on every reset, independent of history and sample rate
+      for (size_t c = 0; c < mHot.noiseSeeds.size(); ++c)
+        mHot.noiseSeeds[c] = DeriveNoiseSeed(mSeed, static_cast<uint32_t>(c));
+    }
+    else
+    {
+      const uint32_t baseSeed = static_cast<uint32_t>(std::max(1.0, sr)) ^ 0x9E3779B9u;
+      mHot.noiseSeeds[0] ^= (baseSeed | 1u);
+      mHot.noiseSeeds[1] ^= ((baseSeed << 16) | 1u);
+    }
+    for (auto& seed : mHot.noiseSeeds)
+    {
+      if (seed == 0)
+        seed = 1u;
+    }
+
+    // Capacity for rates up to 192 kHz is reserved on the first Reset, so a
+    // later sample-rate change resizes within it and never allocates
+    const size_t wowLength = static_cast<size_t>(WowBufferFrames(sampleRate)) * kMaxChannels;
+    mWowBuffer.reserve(std::max(wowLength, static_cast<size_t>(WowBufferFrames(192000.0)) * kMaxChannels));
+    mWowBuffer.resize(wowLength);
+    ClearSignalState();
+    mHot.wowWriteIndex.fill(0);
+    mHot.wowPhase = 0.0;
+    mHot.flutterPhase = 0.0;
+    RefreshWowFlutterIncrements();
+  }
+
+  // Deterministic mode re-seeds the noise generators from seed on every
+  // Reset, so repeated renders of the same input are bit-identical. Otherwise
+  // the seeds keep evolving across resets (the plug-in's default behaviour).
+  // Takes effect at the next Reset.
+  void SetDeterministic(bool enabled, uint32_t seed = 0)
+  {
+    mDeterministic = enabled;
+    mSeed = seed;
+  }
+
+  bool IsDeterministic() const { return mDeterministic; }
+  uint32_t GetSeed() const { return mSeed; }
+
+  // Processes nChans channels. Returns false if the block was passed through
+  // because the processor is fully bypassed.
+  template <typename T>
+  bool ProcessBlock(const T* const* inputs, T** outputs, int nFrames, int nChans)
+  {
+    return ProcessChannels(inputs, outputs, nFrames, 0, nChans);
+  }
+
+  // Processes channels [firstChan, lastChan) only. Shared modulation state
+  // (bypass ramp, drive smoother, wow/flutter LFOs) does not depend on the
+  // audio, so separate instances with identical parameters can each render
+  // one channel and produce the same result as one instance rendering all.
+  template <typename T>
+  bool ProcessChannels(const T* const* inputs, T** outputs, int nFrames, int firstChan, int lastChan)
+  {
+    return ProcessChannels(inputs, outputs, nFrames, firstChan, lastChan, nullptr, 0);
+  }
+
+  // Sample-accurate variant: events (sorted by offset) are applied at their
+  // frame. The block is rendered in segments between event offsets, so the
+  // ramps of the derived values start exactly where the host placed each
+  // change. A ramp always lasts nFrames, the host block length, and carries
+  // on into the next block when it starts late, so an event on the last
+  // frame still ramps like a block-rate change. The bypass fade and the drive
+  // smoother advance once per host block however many events it carries.
+  template <typename T>
+  bool ProcessChannels(const T* const* inputs, T** outputs, int nFrames, int firstChan, int lastChan, const TapeParamEvent* events, int numEvents)
+  {
+    firstChan = std::max(firstChan, 0);
+    lastChan = std::min(lastChan, kMaxChannels);
+
+    if (!mPrepared)
+    {
+      ApplyEvents(events, numEvents);
+      for (int c = firstChan; c < lastChan; ++c)
+        std::copy(inputs[c], inputs[c] + nFrames, outputs[c]);
+      return false;
+    }
+
+    UpdateLimiter();
+
+    // === SMOOTH POWER/BYPASS ===
+    // Smooth ramp to avoid clicks: 0.0 = fully bypassed, 1.0 = fully active
+    const double targetRamp = mPowerOn ? 1.0 : 0.0;
+    const double rampSpeed = 0.02; // Faster response to power toggles
+
+    if (std::abs(mHot.bypassRamp - targetRamp) < 0.0001)
+    {
+      mHot.bypassRamp = targetRamp;
+    }
+    else
+    {
+      mHot.bypassRamp += (targetRamp - mHot.bypassRamp) * rampSpeed;
+    }
+
+    // If fully bypassed, just copy input to output (through the limiter's
+    // delay line while true-peak mode reports latency)
+    if (mHot.bypassRamp < 0.0001)
+    {
+      ApplyEvents(events, numEvents);
+      RenderBypassed(inputs, outputs, nFrames, firstChan, lastChan);
+      return false;
+    }
+
+    mDriveSmoother.Process(mDriveGain);
+
+    const T* segmentInputs[kMaxChannels] = {};
+    T* segmentOutputs[kMaxChannels] = {};
+    float drivePeak = 0.0f;
+    int event = 0;
+    int start = 0;
+    while (start < nFrames)
+    {
+      for (; event < numEvents && events[event].offset <= start; ++event)
+        SetParam(events[event].paramIdx, events[event].value);
+
+      const int end = event < numEvents ? std::min(events[event].offset, nFrames) : nFrames;
+      for (int c = firstChan; c < lastChan; ++c)
+      {
+        segmentInputs[c] = inputs[c] + start;
+        segmentOutputs[c] = outputs[c] + start;
+      }
+      drivePeak = std::max(drivePeak, RenderSegment(segmentInputs, segmentOutputs, end - start, firstChan, lastChan, nFrames));
+      start = end;
+    }
+
+    // Events at or past the end of the block still count
+    ApplyEvents(events + event, numEvents - event);
+
+    // Update peak with decay (approx 300ms)
+    const float decayFactor = 0.9f;
+    mLastPeak = std::max(drivePeak, mLastPeak * decayFactor);
+    return true;
+  }
+
+  // Specialised kernels (the default) are compiled per clip mode and set of
+  // active stages and picked once per block. The generic kernel decides both
+  // per sample, like the original loop. Output is identical either way; the
+  // switch exists for benchmarking and verification.
+  void SetSpecialisedKernels(bool enabled) { mSpecialisedKernels = enabled; }
+
+  // Selects the cost profile (EQualityTier). Offline renders should stay at
+  // kQualityTierHigh. The delay-line interpolation order ramps over 20 ms, so
+  // switching tiers while playing does not click; the other differences are
+  // below audibility.
+  void SetQualityTier(int tier)
+  {
+    mQualityTier = std::clamp(tier, 0, kNumQualityTiers - 1);
+    mDerivedDirty.Set(kDirtyStages);
+    mLimiter.SetFullRateDetector(mQualityTier != kQualityTierDraft);
+  }
+
+  int GetQualityTier() const { return mQualityTier; }
+
+  // Blocks in which the sentinel found NaN or Inf and reset the signal state,
+  // since construction
+  uint32_t GetNonFiniteEvents() const { return mNonFiniteEvents; }
+
+  // Current auto-gain compensation of a channel (0 while AutoGain is off)
+  double GetCompensationDb(int channel) const { return mCompensationDb[std::clamp(channel, 0, kMaxChannels - 1)]; }
+
+  // Decaying peak after the drive stage, for the DriveVU meter
+  float GetDrivePeak() const { return mLastPeak; }
+  // Latency to report to the host; non-zero only in true-peak mode
+  int GetLatencySamples() const { return mTruePeakOn ? mLimiter.GetLatencySamples() : 0; }
+  double GetSampleRate() const { return mSampleRate; }
+
+  // Complete processing state (parameters, filters, envelopes, noise seeds,
+  // LFO phases and the wow/flutter delay line) as an opaque blob. Restoring it
+  // and continuing with the same block size reproduces the output sample for
+  // sample. The layout is native-endian and only meant to be read back by the
+  // same build on the same machine.
+  void SaveState(std::vector<uint8_t>& out) const
+  {
+    StateWriter writer {out};
+    writer(kStateMagic);
+    writer(kStateVersion);
+    VisitState(*this, writer);
+  }
+
+  bool LoadState(const uint8_t* data, size_t size)
+  {
+    StateReader reader {data, size};
+    uint32_t magic = 0, version = 0;
+    reader(magic);
+    reader(version);
+    if (!reader.ok || magic != kStateMagic || version != kStateVersion)
+      return false;
+
+    // Read into a copy so a truncated blob leaves this instance untouched
+    TapeSaturatorDSP restored(*this);
+    VisitState(restored, reader);
+    if (!reader.ok || reader.pos != size)
+      return false;
+
+    // The kernel indexes the delay line with a mask
+    const size_t wowFrames = restored.mWowBuffer.size() / kMaxChannels;
+    if (wowFrames < 64 || (wowFrames & (wowFrames - 1)) != 0 || wowFrames * kMaxChannels != restored.mWowBuffer.size())
+      return false;
+
+    restored.mPrepared = true;
+    // Everything but the ramps in flight is recomputed by the next block
+    restored.mDerivedDirty.Set(kDirtyAll);
+    *this = restored;
+    // Coefficients are restored verbatim; forget memoised designs for the old rate
+    mToneCoeffCache.Clear();
+    return true;
+  }
+
+private:
+  static constexpr uint32_t kStateMagic = 0x4C545344; // 'LTSD'
+  static constexpr uint32_t kStateVersion = 15;
+
+  struct StateWriter
+  {
+    std::vector<uint8_t>& out;
+
+    template <typename T>
+    void operator()(const T& value)
+    {
+      static_assert(std::is_trivially_copyable<T>::value, "state fields must be trivially copyable");
+      const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+      out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    // Heap buffers: element count, then the raw contents
+    void operator()(const std::vector<double>& values)
+    {
+      (*this)(static_cast<uint32_t>(values.size()));
+      const auto* bytes = reinterpret_cast<const uint8_t*>(values.data());
+      out.insert(out.end(), bytes, bytes + values.size() * sizeof(double));
+    }
+
+    // Dirty masks are stored as their plain value
+    void operator()(const DirtyMask& mask) { (*this)(mask.Peek()); }
+  };
+
+  struct StateReader
+  {
+    const uint8_t* data;
+    size_t size;
+    size_t pos = 0;
+    bool ok = true;
+
+    template <typename T>
+    void operator()(T& value)
+    {
+      static_assert(std::is_trivially_copyable<T>::value, "state fields must be trivially copyable");
+      if (!ok || size - pos < sizeof(T))
+      {
+        ok = false;
+        return;
+      }
+      std::memcpy(&value, data + pos, sizeof(T));
+      pos += sizeof(T);
+    }
+
+    void operator()(std::vector<double>& values)
+    {
+      uint32_t length = 0;
+      (*this)(length);
+      const size_t bytes = static_cast<size_t>(length) * sizeof(double);
+      if (!ok || size - pos < bytes)
+      {
+        ok = false;
+        return;
+      }
+      values.resize(length);
+      std::memcpy(values.data(), data + pos, bytes);
+      pos += bytes;
+    }
+
+    void operator()(DirtyMask& mask)
+    {
+      unsigned bits = 0;
+      (*this)(bits);
+      mask.Store(bits);
+    }
+  };
+
+  // Every field that influences future output, in a fixed order.
+  // Bump kStateVersion whenever this list changes.
+  template <typename Self, typename Archive>
+  static void VisitState(Self& self, Archive& ar)
+  {
+    ar(self.mSampleRate);
+    ar(self.mLastPeak);
+    ar(self.mDriveSmoother);
+
+    ar(self.mHot.transformerSaturation);
+    ar(self.mHot.transformerBias);
+    ar(self.mHot.transformerLowpass);
+    ar(self.mHot.toneEnvelope);
+    ar(self.mHot.bandSaturation);
+    ar(self.mHot.bandBias);
+    ar(self.mBandSplitter);
+    ar(self.mHot.resamplePhase);
+    ar(self.mHot.resampleHold);
+    ar(self.mHot.mpcPrevSample);
+    ar(self.mHot.noiseSeeds);
+    ar(self.mDeterministic);
+    ar(self.mSeed);
+    ar(self.mHot.noiseFilter);
+    ar(self.mHot.crackleEnvelope);
+    ar(self.mHot.crackleCooldown);
+
+    ar(self.mTone);
+    ar(self.mLowPassFilter);
+    ar(self.mNoiseLowPassFilter);
+    ar(self.mLimiter);
+
+    ar(self.mWowBuffer);
+    ar(self.mHot.wowWriteIndex);
+    ar(self.mHot.wowPhase);
+    ar(self.mHot.flutterPhase);
+    ar(self.mHot.wowPhaseInc);
+    ar(self.mHot.flutterPhaseInc);
+
+    ar(self.mDriveGain);
+    ar(self.mToneLowGain);
+    ar(self.mToneHighGain);
+    ar(self.mToneMidQ);
+    ar(self.mMpcBits);
+    ar(self.mResampleRatio);
+    ar(self.mWowAmount);
+    ar(self.mWowRate);
+    ar(self.mFlutterAmount);
+    ar(self.mFlutterRate);
+    ar(self.mNoiseLevel);
+    ar(self.mLowPassCutoff);
+    ar(self.mLowPassResonance);
+    ar(self.mOutputGainDB);
+    ar(self.mOutputGainLinear);
+    ar(self.mClipThreshold);
+    ar(self.mClipMode);
+    ar(self.mClipSlope);
+    ar(self.mPowerOn);
+    ar(self.mTruePeakOn);
+    ar(self.mTruePeakLookaheadMs);
+    ar(self.mQualityTier);
+    ar(self.mMachine);
+    ar(self.mBands);
+    ar(self.mCrossover);
+    ar(self.mBandDrive);
+    ar(self.mBandSag);
+    ar(self.mSplitBands);
+    ar(self.mHot.interpBlend);
+    ar(self.mHot.bypassRamp);
+    ar(self.mHot.toneAttackCoeff);
+    ar(self.mHot.toneReleaseCoeff);
+    ar(self.mHot.toneSaturationMix);
+    ar(self.mRampTarget);
+    ar(self.mBandTarget);
+    ar(self.mBlock.rampStart);
+    ar(self.mBlock.rampStep);
+    ar(self.mBlock.rampFrames);
+    ar(self.mBlock.rampEnded);
+    ar(self.mBlock.bandStart);
+    ar(self.mBlock.bandStep);
+    ar(self.mBlock.bandRampFrames);
+    ar(self.mDerivedDirty);
+    ar(self.mRecoveryGain);
+    ar(self.mAutoGainOn);
+    ar(self.mLoudness);
+    ar(self.mCompensationDb);
+    ar(self.mCompensationGain);
+  }
+
+  // Stages that can change the signal in the current block, set by
+  // PrepareBlock. The specialised kernels skip the others; the generic kernel
+  // runs every stage.
+  enum EKernelStage : unsigned
+  {
+    kStageNoise = 1u << 0,
+    kStageResampler = 1u << 1,
+    kStageWow = 1u << 2,
+    kStageReduced = 1u << 3  // any tier below High
+  };
+
+  // Per-block values that follow automation. When one of them changes, the
+  // kernel interpolates it per sample from where the previous block ended
+  // instead of stepping at the block boundary.
+  struct RampedParams
+  {
+    double driveLinear = 0.0;
+    double driveGain = 0.0;
+    double sagCoeff = 0.0;
+    double asymmetryBase = 0.0;
+    double evenEnhancer = 0.0;
+    double triodeAmount = 0.0;
+    double oddBlend = 0.0;
+    double finalSaturation = 0.0;
+    double lpAlpha = 0.0;
+    double lpComp = 0.0;
+    double wowDepthSamples = 0.0;
+    double flutterDepthSamples = 0.0;
+    double wowAmount = 0.0;
+    double flutterAmount = 0.0;
+    double outputGain = 1.0;
+
+    // The step of a ramp that is not moving
+    static RampedParams Still()
+    {
+      RampedParams still;
+      still.outputGain = 0.0;
+      return still;
+    }
+
+    inline void Advance(const RampedParams& step)
+    {
+      driveLinear += step.driveLinear;
+      driveGain += step.driveGain;
+      sagCoeff += step.sagCoeff;
+      asymmetryBase += step.asymmetryBase;
+      evenEnhancer += step.evenEnhancer;
+      triodeAmount += step.triodeAmount;
+      oddBlend += step.oddBlend;
+      finalSaturation += step.finalSaturation;
+      lpAlpha += step.lpAlpha;
+      lpComp += step.lpComp;
+      wowDepthSamples += step.wowDepthSamples;
+      flutterDepthSamples += step.flutterDepthSamples;
+      wowAmount += step.wowAmount;
+      flutterAmount += step.flutterAmount;
+      outputGain += step.outputGain;
+    }
+
+    // Per-sample increments that reach target after numSamples; false if
+    // nothing moves
+    bool StepTowards(const RampedParams& target, int numSamples, RampedParams& step) const
+    {
+      const double scale = 1.0 / std::max(numSamples, 1);
+      bool moving = false;
+      auto delta = [&](double from, double to) {
+        moving |= from != to;
+        return (to - from) * scale;
+      };
+      step.driveLinear = delta(driveLinear, target.driveLinear);
+      step.driveGain = delta(driveGain, target.driveGain);
+      step.sagCoeff = delta(sagCoeff, target.sagCoeff);
+      step.asymmetryBase = delta(asymmetryBase, target.asymmetryBase);
+      step.evenEnhancer = delta(evenEnhancer, target.evenEnhancer);
+      step.triodeAmount = delta(triodeAmount, target.triodeAmount);
+      step.oddBlend = delta(oddBlend, target.oddBlend);
+      step.finalSaturation = delta(finalSaturation, target.finalSaturation);
+      step.lpAlpha = delta(lpAlpha, target.lpAlpha);
+      step.lpComp = delta(lpComp, target.lpComp);
+      step.wowDepthSamples = delta(wowDepthSamples, target.wowDepthSamples);
+      step.flutterDepthSamples = delta(flutterDepthSamples, target.flutterDepthSamples);
+      step.wowAmount = delta(wowAmount, target.wowAmount);
+      step.flutterAmount = delta(flutterAmount, target.flutterAmount);
+      step.outputGain = delta(outputGain, target.outputGain);
+      return moving;
+    }
+  };
+
+  // Input transformer coefficients for one sample. V is double for the full
+  // band and tapedsp::Double4 for the multiband lanes, where they are ramped
+  // per block like RampedParams.
+  template <typename V>
+  struct TransformerTerms
+  {
+    V driveGain = 0.0;
+    V sagCoeff = 0.0;
+    V sagDepth = 0.0;
+    V asymmetry = 0.0;
+    V biasMix = 0.0;
+    V evenEnhancer = 0.0;
+    V triodeAmount = 0.0;
+    V oddBoost = 0.0;
+    V oddCubic = 0.0;
+    V oddBlend = 0.0;
+    V finalSaturation = 0.0;
+
+    inline void Advance(const TransformerTerms& step)
+    {
+      driveGain = driveGain + step.driveGain;
+      sagCoeff = sagCoeff + step.sagCoeff;
+      sagDepth = sagDepth + step.sagDepth;
+      asymmetry = asymmetry + step.asymmetry;
+      biasMix = biasMix + step.biasMix;
+      evenEnhancer = evenEnhancer + step.evenEnhancer;
+      triodeAmount = triodeAmount + step.triodeAmount;
+      oddBoost = oddBoost + step.oddBoost;
+      oddCubic = oddCubic + step.oddCubic;
+      oddBlend = oddBlend + step.oddBlend;
+      finalSaturation = finalSaturation + step.finalSaturation;
+    }
+
+    bool StepTowards(const TransformerTerms& target, int numSamples, TransformerTerms& step) const
+    {
+      const double scale = 1.0 / std::max(numSamples, 1);
+      bool moving = false;
+      auto delta = [&](const V& from, const V& to) {
+        moving |= from != to;
+        return (to - from) * scale;
+      };
+      step.driveGain = delta(driveGain, target.driveGain);
+      step.sagCoeff = delta(sagCoeff, target.sagCoeff);
+      step.sagDepth = delta(sagDepth, target.sagDepth);
+      step.asymmetry = delta(asymmetry, target.asymmetry);
+      step.biasMix = delta(biasMix, target.biasMix);
+      step.evenEnhancer = delta(evenEnhancer, target.evenEnhancer);
+      step.triodeAmount = delta(triodeAmount, target.triodeAmount);
+      step.oddBoost = delta(oddBoost, target.oddBoost);
+      step.oddCubic = delta(oddCubic, target.oddCubic);
+      step.oddBlend = delta(oddBlend, target.oddBlend);
+      step.finalSaturation = delta(finalSaturation, target.finalSaturation);
+      return moving;
+    }
+  };
+
+  // Which groups of derived values need recomputing, set by SetParam,
+  // SetQualityTier, Reset and LoadState
+  enum EDerivedDirty : unsigned
+  {
+    kDirtyDrive = 1u << 0,      // DriveGain, Machine, BandDrive, BandSag: preamp, transformer and coil terms
+    kDirtyCrusher = 1u << 1,    // MPCBits
+    kDirtyResampler = 1u << 2,  // ResampleRatio
+    kDirtyWow = 1u << 3,        // WowAmount, FlutterAmount
+    kDirtyNoise = 1u << 4,      // NoiseLevel
+    kDirtyClip = 1u << 5,       // ClipThreshold, ClipSlope
+    kDirtyOutput = 1u << 6,     // Output
+    kDirtyStages = 1u << 7,     // quality tier
+    kDirtySampleRate = 1u << 8,
+    kDirtyBands = 1u << 9,      // Bands, crossover frequencies
+    kDirtyAll = (1u << 10) - 1,
+    kSnapRamps = 1u << 10,      // jump to the targets instead of ramping (Reset)
+    kDirtyLimiter = 1u << 11,   // TruePeakLookahead, TruePeak switched on; taken by ProcessChannels, not PrepareBlock
+    kDirtyLoudness = 1u << 12   // AutoGain switched on: restart the loudness measurement
+  };
+
+  // Per-block constants shared by all kernels. Kept between blocks; only the
+  // groups marked dirty are recomputed. The ramps carry on from wherever the
+  // previous segment left them. A ramp that is not moving has a zero step, so
+  // the ramping kernels can advance both ramps unconditionally.
+  struct BlockParams
+  {
+    RampedParams rampStart;
+    RampedParams rampStep = RampedParams::Still();
+    TransformerTerms<tapedsp::Double4> bandStart;  // multiband only
+    TransformerTerms<tapedsp::Double4> bandStep;
+    int rampFrames = 0;      // left of the current ramp, which can span host blocks
+    int bandRampFrames = 0;
+    bool rampEnded = false;  // a ramp finished since the last PrepareBlock
+    int bands = 1;
+    double biasFollowCoeff = 0.0;
+    double sampleRate = kDefaultSampleRate;
+    int bits = 16;
+    double bitTransientGain = 0.0;
+    double bitTransientMix = 0.0;
+    double resampleRatio = 1.0;
+    double aliasBase = 0.0;
+    double baseDelaySamples = 0.0;
+    double noiseAmount = 0.0;
+    bool truePeak = false;
+    double threshold = 1.0;
+    double clipSlope = 0.0;
+    double interpStep = 0.0;
+    double interpLow = 0.0;
+    double interpHigh = 0.0;
+    unsigned stages = 0;
+  };
+
+  // Ramps started here reach their targets after rampLength frames
+  BlockParams& PrepareBlock(int rampLength)
+  {
+    using namespace tapedsp;
+
+    BlockParams& b = mBlock;
+    RampedParams& target = mRampTarget;
+    const MachineModel& model = kMachineModels[mMachine];
+
+    // Cache drive gain smoothing (convert 0..1 → dB up to +24dB headroom)
+    const double driveLinear = std::clamp(mDriveSmoother.GetValue(), 0.0, 1.0);
+    unsigned dirty = mDerivedDirty.Take(kDirtyAll | kSnapRamps | kDirtyLoudness);
+    if (driveLinear != target.driveLinear)
+      dirty |= kDirtyDrive;
+
+    const bool wasRamping = b.rampFrames > 0 || b.rampEnded;
+    b.rampEnded = false;
+    b.truePeak = mTruePeakOn;
+
+    // A ramp in flight keeps its pace unless its target moves; LoadState
+    // recomputes every target without moving any
+    const RampedParams previousTarget = target;
+    const TransformerTerms<Double4> previousBandTarget = mBandTarget;
+
+    if (dirty & kDirtySampleRate)
+    {
+      b.sampleRate = std::max(mSampleRate, 1.0);
+      b.baseDelaySamples = std::max(12.0, b.sampleRate * 0.0012);
+    }
+
+    if (dirty & (kDirtyDrive | kDirtySampleRate))
+    {
+      target.driveLinear = driveLinear;
+      const double preampDb = driveLinear * model.preampRangeDb + model.preampOffsetDb; // gently biased boost emulating transformer input
+      target.driveGain = std::pow(10.0, preampDb / 20.0);
+
+      // Transformer-inspired dynamic coefficients
+      target.sagCoeff = std::clamp(model.sagBase + driveLinear * model.sagDrive, 0.9, 0.999);
+      b.biasFollowCoeff = model.biasFollow;
+      target.asymmetryBase = model.asymmetryBase + driveLinear * model.asymmetryDrive;
+      target.evenEnhancer = model.evenBase + driveLinear * model.evenDrive;
+      target.triodeAmount = model.triodeBase + driveLinear * model.triodeDrive;
+      target.oddBlend = model.oddBlendBase + driveLinear * model.oddBlendDrive;
+      target.finalSaturation = model.finalSatBase + driveLinear * model.finalSatDrive;
+
+      // Gentle HF roll-off for transformer-like sheen
+      const double lowpassHz = std::clamp(model.coilLowpassHz + driveLinear * model.coilLowpassDriveHz, model.coilLowpassMinHz, model.coilLowpassMaxHz);
+      target.lpAlpha = std::exp(-kTwoPi * lowpassHz / b.sampleRate);
+      target.lpComp = 1.0 - target.lpAlpha;
+    }
+
+    bool newBandLayout = false;
+    if (dirty & (kDirtyBands | kDirtySampleRate))
+    {
+      b.bands = std::clamp(mBands, 1, tapedsp::BandSplitter::kMaxBands);
+      if (b.bands > 1)
+      {
+        // Crossovers stay in order, at least half an octave apart
+        double crossover[tapedsp::BandSplitter::kMaxBands - 1];
+        crossover[0] = mCrossover[0];
+        for (int i = 1; i < tapedsp::BandSplitter::kMaxBands - 1; ++i)
+          crossover[i] = std::max(mCrossover[i], crossover[i - 1] * 1.4142135623730951);
+        mBandSplitter.Design(b.bands, crossover, b.sampleRate);
+      }
+      if (b.bands != mSplitBands)
+      {
+        // The lanes carry other bands now; their state would only click
+        mBandSplitter.Reset();
+        mHot.bandSaturation.fill(0.0);
+        mHot.bandBias.fill(0.0);
+        mSplitBands = b.bands;
+        newBandLayout = true;
+      }
+    }
+
+    if (b.bands > 1 && (dirty & (kDirtyDrive | kDirtyBands | kDirtySampleRate)))
+      UpdateBandTerms(model, driveLinear);
+
+    if (dirty & kDirtyCrusher)
+    {
+      b.bits = std::clamp(mMpcBits, 1, 16);
+      b.bitTransientGain = 3.0 + (16 - b.bits) * 0.45;
+      b.bitTransientMix = 0.015 + (16 - b.bits) * 0.02;
+    }
+
+    if (dirty & kDirtyResampler)
+    {
+      b.resampleRatio = std::clamp(mResampleRatio, 0.25, 4.0);
+      b.aliasBase = std::clamp(0.05 + (1.0 - std::min(b.resampleRatio, 1.0)) * 0.6, 0.0, 0.8);
+    }
+
+    if (dirty & (kDirtyWow | kDirtySampleRate))
+    {
+      target.wowDepthSamples = std::max(0.0, mWowAmount) * (0.0032 * b.sampleRate);
+      // INCREASED FLUTTER DEPTH for more noticeable effect (was 0.0009, now 0.0025)
+      target.flutterDepthSamples = std::max(0.0, mFlutterAmount) * (0.0025 * b.sampleRate);
+      target.wowAmount = mWowAmount;
+      target.flutterAmount = mFlutterAmount;
+    }
+
+    if (dirty & kDirtyLoudness)
+      mLoudness.Reset(b.sampleRate);
+
+    if (dirty & kDirtyNoise)
+      b.noiseAmount = std::clamp(mNoiseLevel, 0.0, 1.0);
+
+    if (dirty & kDirtyOutput)
+      target.outputGain = mOutputGainLinear;
+
+    if (dirty & kDirtyClip)
+    {
+      b.threshold = std::max(0.0001, mClipThreshold);
+      b.clipSlope = std::clamp(mClipSlope, 0.0, 1.0);
+    }
+
+    if (dirty & kSnapRamps)
+    {
+      b.rampStart = target;
+      b.rampStep = RampedParams::Still();
+      b.rampFrames = 0;
+    }
+    else if ((dirty & (kDirtyDrive | kDirtyWow | kDirtyOutput | kDirtySampleRate))
+             && (b.rampFrames == 0 || std::memcmp(&previousTarget, &target, sizeof(target)) != 0))
+    {
+      b.rampFrames = b.rampStart.StepTowards(target, rampLength, b.rampStep) ? rampLength : 0;
+    }
+
+    if ((dirty & kSnapRamps) || newBandLayout || b.bands == 1)
+    {
+      b.bandStart = mBandTarget;
+      b.bandStep = {};
+      b.bandRampFrames = 0;
+    }
+    else if ((dirty & (kDirtyDrive | kDirtySampleRate))
+             && (b.bandRampFrames == 0 || std::memcmp(&previousBandTarget, &mBandTarget, sizeof(mBandTarget)) != 0))
+    {
+      b.bandRampFrames = b.bandStart.StepTowards(mBandTarget, rampLength, b.bandStep) ? rampLength : 0;
+    }
+
+    // Stages that cannot change the signal in this block are skipped.
+    // With no wow/flutter the LFOs only advance and the pitch influence is
+    // exactly zero. The resampler is transparent whenever its step is >= 1 on
+    // every sample: it then latches the current sample each time. The bit
+    // crusher still quantises and shapes transients at 16 bits, so it stays.
+    // While wow/flutter ramps, both ends of the ramp count.
+    if ((dirty & (kDirtyResampler | kDirtyWow | kDirtyNoise | kDirtyStages)) || b.rampFrames > 0 || wasRamping)
+    {
+      const RampedParams& from = b.rampStart;
+      const bool wowActive = target.wowAmount != 0.0 || target.flutterAmount != 0.0 || from.wowAmount != 0.0 || from.flutterAmount != 0.0;
+      const double maxPitchInfluence = std::max(std::fabs(target.wowAmount), std::fabs(from.wowAmount)) * 0.12
+                                     + std::max(std::fabs(target.flutterAmount), std::fabs(from.flutterAmount)) * 0.18;
+      const bool resamplerActive = wowActive ? b.resampleRatio - maxPitchInfluence < 1.0 + 1e-9 : b.resampleRatio < 1.0;
+      b.stages = (b.noiseAmount > 0.0 ? kStageNoise : 0u) | (resamplerActive ? kStageResampler : 0u) | (wowActive ? kStageWow : 0u)
+               | (mQualityTier != kQualityTierHigh ? kStageReduced : 0u);
+    }
+
+    // Delay-line interpolation weight: 1 = linear, 0 = nearest sample
+    const double interpTarget = mQualityTier == kQualityTierDraft ? 0.0 : 1.0;
+    const double interpRate = 1.0 / (0.02 * b.sampleRate);
+    b.interpStep = interpTarget > mHot.interpBlend ? interpRate : (interpTarget < mHot.interpBlend ? -interpRate : 0.0);
+    b.interpLow = std::min(interpTarget, mHot.interpBlend);
+    b.interpHigh = std::max(interpTarget, mHot.interpBlend);
+    return b;
+  }
+
+  template <typename T>
+  using KernelFn = float (TapeSaturatorDSP::*)(const T* const*, T**, int, int, int, BlockParams&);
+
+  // Index = ((machine * kNumClipModes + clip mode) * 2 + multiband) * 2 + ramping
+  template <typename T, size_t... Index>
+  static constexpr std::array<KernelFn<T>, sizeof...(Index)> MakeKernelTable(std::index_sequence<Index...>)
+  {
+    return {{&TapeSaturatorDSP::RenderKernel<T, static_cast<int>(Index / (kNumClipModes * 4)),
+                                             static_cast<int>(Index / 4 % kNumClipModes),
+                                             (Index / 2 % 2) != 0,
+                                             (Index % 2) != 0>...}};
+  }
+
+  template <typename T>
+  KernelFn<T> SelectKernel(const BlockParams& block, bool ramping) const
+  {
+    static constexpr auto kKernels = MakeKernelTable<T>(std::make_index_sequence<kNumMachines * kNumClipModes * 4>());
+
+    if (!mSpecialisedKernels || mClipMode < 0 || mClipMode >= kNumClipModes)
+    {
+      return ramping ? &TapeSaturatorDSP::RenderKernel<T, kNumMachines, kNumClipModes, false, true>
+                     : &TapeSaturatorDSP::RenderKernel<T, kNumMachines, kNumClipModes, false, false>;
+    }
+    const size_t index = (static_cast<size_t>(mMachine) * kNumClipModes + static_cast<size_t>(mClipMode)) * 2 + (block.bands > 1 ? 1 : 0);
+    return kKernels[index * 2 + (ramping ? 1 : 0)];
+  }
+
+  // Constants of the machine a specialised kernel is built for
+  template <int Machine>
+  static constexpr MachineModel KernelMachineModel()
+  {
+    if constexpr (Machine < kNumMachines)
+      return MachinePolicy<Machine>::Model();
+    else
+      return MachineModel {};
+  }
+
+  // The input transformer, shared by the full-band path (V = double) and the
+  // multiband lanes (V = Double4)
+  template <typename V, typename Saturate>
+  static inline V DriveTransformer(V processed, V& sagState, V& biasState, const TransformerTerms<V>& t, double biasFollowCoeff,
+                                   double biasRemoval, Saturate saturate)
+  {
+    using tapedsp::Abs;
+    using tapedsp::Polarity;
+
+    // === PREAMP / DRIVE ===
+    processed = processed * t.driveGain;
+
+    const V rectified = Abs(processed);
+    sagState = t.sagCoeff * sagState + (1.0 - t.sagCoeff) * rectified;
+
+    const V sagCompression = 1.0 / (1.0 + sagState * t.sagDepth);
+    processed = processed * sagCompression;
+
+    const V polarity = Polarity(processed);
+    const V biasTarget = t.asymmetry * sagState * polarity;
+    biasState = biasFollowCoeff * biasState + (1.0 - biasFollowCoeff) * biasTarget;
+
+    const V transformerInput = processed + biasState * t.biasMix;
+
+    // Transformer-style asymmetric saturation encourages even harmonics
+    const V evenStage = transformerInput + t.evenEnhancer * transformerInput * Abs(transformerInput);
+    const V triodeStage = saturate(evenStage * t.triodeAmount);
+
+    const V oddStageInput = transformerInput * t.oddBoost;
+    const V oddStage = oddStageInput - (oddStageInput * oddStageInput * oddStageInput) * t.oddCubic;
+
+    processed = t.oddBlend * triodeStage + (1.0 - t.oddBlend) * oddStage;
+    processed = saturate(processed * t.finalSaturation);
+    return processed - biasState * biasRemoval; // remove DC introduced by transformer bias
+  }
+
+  // Multiband drive: split, saturate every band in its lane, sum. The lanes
+  // always use the rational tanh, which vectorises.
+  inline double DriveBands(double input, int c, const TransformerTerms<tapedsp::Double4>& terms, double biasFollowCoeff, double biasRemoval)
+  {
+    const tapedsp::Double4 bands = mBandSplitter.Process(input, c);
+    return DriveTransformer(bands, mHot.bandSaturation[c], mHot.bandBias[c], terms, biasFollowCoeff, biasRemoval,
+                            [](const tapedsp::Double4& x) { return tapedsp::FastTanh(x); }).Sum();
+  }
+
+  // The per-sample loop, up to the dry/wet mix; ApplyOutputStage adds the
+  // true-peak limiter and the output gain. Machine == kNumMachines with
+  // ClipMode == kNumClipModes is the generic variant, which reads machine,
+  // clip mode and bands at runtime and runs every stage. Every other
+  // instantiation has the machine's constants, its clip mode and its drive
+  // path resolved at compile time, and skips the stages block.stages leaves
+  // out. Ramping kernels render spans where a ramp moves and advance the
+  // ramped values once per frame; the others hold them. Returns the drive
+  // stage peak of the span.
+  template <typename T, int Machine, int ClipMode, bool Multiband, bool Ramping>
+  float RenderKernel(const T* const* inputs, T** outputs, int nFrames, int firstChan, int lastChan, BlockParams& block)
+  {
+    using namespace tapedsp;
+
+    constexpr bool kRuntime = Machine == kNumMachines;
+    static constexpr MachineModel kModel = KernelMachineModel<Machine>();
+    const bool resamplerOn = kRuntime || (block.stages & kStageResampler) != 0;
+    const bool wowOn = kRuntime || (block.stages & kStageWow) != 0;
+    const bool noiseOn = kRuntime ? block.noiseAmount > 0.0 : (block.stages & kStageNoise) != 0;
+    const bool reduced = kRuntime ? mQualityTier != kQualityTierHigh : (block.stages & kStageReduced) != 0;
+    const bool multiband = kRuntime ? block.bands > 1 : Multiband;
+    const auto saturate = [reduced](double x) { return reduced ? FastTanh(x) : std::tanh(x); };
+    const int clipMode = kRuntime ? mClipMode : ClipMode;
+    const MachineModel& model = kRuntime ? kMachineModels[mMachine] : kModel;
+    const double sagDepthBase = model.sagDepthBase;
+    const double sagDepthDrive = model.sagDepthDrive;
+    const double biasMixBase = model.biasMixBase;
+    const double biasMixDrive = model.biasMixDrive;
+    const double oddDriveBoost = model.oddDriveBoost;
+    const double oddCubicBase = model.oddCubicBase;
+    const double oddCubicDrive = model.oddCubicDrive;
+    const double biasRemoval = model.biasRemoval;
+    const double tapeCompressionBase = model.tapeCompressionBase;
+    const double tapeCompressionDrive = model.tapeCompressionDrive;
+    const double tapeDriveBase = model.tapeDriveBase;
+    const double tapeDriveDrive = model.tapeDriveDrive;
+
+    float drivePeak = 0.0f;
+
+    RampedParams ramp = block.rampStart;
+    TransformerTerms<Double4> bandRamp = block.bandStart;
+    const double& driveLinear = ramp.driveLinear;
+    const double& driveGain = ramp.driveGain;
+    const double& sagCoeff = ramp.sagCoeff;
+    const double biasFollowCoeff = block.biasFollowCoeff;
+    const double& asymmetryBase = ramp.asymmetryBase;
+    const double& evenEnhancer = ramp.evenEnhancer;
+    const double& triodeAmount = ramp.triodeAmount;
+    const double& oddBlend = ramp.oddBlend;
+    const double& finalSaturation = ramp.finalSaturation;
+    const double sampleRate = block.sampleRate;
+    const double& lpAlpha = ramp.lpAlpha;
+    const double& lpComp = ramp.lpComp;
+    const int bits = block.bits;
+    const double bitTransientGain = block.bitTransientGain;
+    const double bitTransientMix = block.bitTransientMix;
+    const double maxLevel = static_cast<double>((1 << bits) - 1);
+    const double resampleRatio = block.resampleRatio;
+    const double aliasBase = block.aliasBase;
+    const double& wowDepthSamples = ramp.wowDepthSamples;
+    const double& flutterDepthSamples = ramp.flutterDepthSamples;
+    const double baseDelaySamples = block.baseDelaySamples;
+    const double noiseAmount = block.noiseAmount;
+    const double threshold = block.threshold;
+    const double slope = block.clipSlope;
+    const double softLimit = threshold * (1.0 + slope);
+    double* const wowBuffer = mWowBuffer.data();
+    const int wowSize = static_cast<int>(mWowBuffer.size() / kMaxChannels);
+    const int wowMask = wowSize - 1;
+    const bool stereo = firstChan == 0 && lastChan == kMaxChannels;
+
+    for (int s = 0; s < nFrames; ++s)
+    {
+      if (Ramping)
+      {
+        ramp.Advance(block.rampStep);
+        if (multiband)
+          bandRamp.Advance(block.bandStep);
+      }
+
+      double modDelay = baseDelaySamples;
+      double pitchInfluence = 0.0;
+      if (wowOn)
+      {
+        const double wowValue = std::sin(mHot.wowPhase);
+        const double flutterValue = std::sin(mHot.flutterPhase);
+        modDelay = baseDelaySamples + wowValue * wowDepthSamples + flutterValue * flutterDepthSamples;
+        // INCREASED FLUTTER PITCH INFLUENCE for more noticeable tape-like effect (was 0.05, now 0.18)
+        pitchInfluence = wowValue * ramp.wowAmount * 0.12 + flutterValue * ramp.flutterAmount * 0.18;
+      }
+      mHot.wowPhase += mHot.wowPhaseInc;
+      if (mHot.wowPhase > kTwoPi)
+        mHot.wowPhase -= kTwoPi;
+      mHot.flutterPhase += mHot.flutterPhaseInc;
+      if (mHot.flutterPhase > kTwoPi)
+        mHot.flutterPhase -= kTwoPi;
+
+      const double clampedDelay = std::clamp(modDelay, 1.0, static_cast<double>(wowSize - 3));
+      mHot.interpBlend = std::clamp(mHot.interpBlend + block.interpStep, block.interpLow, block.interpHigh);
+
+      // Drive and coil roll-off per channel, then the tone cascade on both
+      // channels together when the kernel has the pair
+      std::array<double, kMaxChannels> toneInput;
+      for (int c = firstChan; c < lastChan; ++c)
+      {
+        const double inputSample = inputs[c][s];
+        double processed;
+
+        // === PREAMP / DRIVE / TRANSFORMER ===
+        if (multiband)
+        {
+          processed = DriveBands(inputSample, c, bandRamp, biasFollowCoeff, biasRemoval);
+        }
+        else
+        {
+          const TransformerTerms<double> terms {driveGain, sagCoeff, sagDepthBase + driveLinear * sagDepthDrive, asymmetryBase,
+                                                biasMixBase + driveLinear * biasMixDrive, evenEnhancer, triodeAmount,
+                                                1.0 + driveLinear * oddDriveBoost, oddCubicBase + driveLinear * oddCubicDrive, oddBlend,
+                                                finalSaturation};
+          processed = DriveTransformer(inputSample, mHot.transformerSaturation[c], mHot.transformerBias[c], terms, biasFollowCoeff,
+                                       biasRemoval, saturate);
+        }
+
+        // Single-pole low-pass for transformer coil roll-off
+        double& lpState = mHot.transformerLowpass[c];
+        lpState = lpAlpha * lpState + lpComp * processed;
+        processed = lpState;
+
+        drivePeak = std::max(drivePeak, static_cast<float>(std::fabs(processed)));
+        toneInput[c] = processed;
+      }
+
+      // === TONE: machine curve (Studio: Studer A800-inspired) ===
+      std::array<double, kMaxChannels> toneOutput;
+      if (stereo)
+      {
+        mTone.ProcessStereo(toneInput.data(), toneOutput.data());
+      }
+      else
+      {
+        for (int c = firstChan; c < lastChan; ++c)
+          toneOutput[c] = mTone.Process(toneInput[c], c);
+      }
+
+      for (int c = firstChan; c < lastChan; ++c)
+      {
+        const double inputSample = inputs[c][s];
+        const double toneProcessed = toneOutput[c];
+        double processed;
+
+        double detector = std::fabs(toneProcessed);
+        double& env = mHot.toneEnvelope[c];
+        if (detector > env)
+          env = mHot.toneAttackCoeff * env + (1.0 - mHot.toneAttackCoeff) * detector;
+        else
+          env = mHot.toneReleaseCoeff * env + (1.0 - mHot.toneReleaseCoeff) * detector;
+
+        const double compression = 1.0 / (1.0 + env * (tapeCompressionBase + driveLinear * tapeCompressionDrive));
+        const double compressed = toneProcessed * compression;
+        const double tapeSaturation = saturate(compressed * (tapeDriveBase + driveLinear * tapeDriveDrive));
+        processed = (1.0 - mHot.toneSaturationMix) * compressed + mHot.toneSaturationMix * tapeSaturation;
+
+        // === MPC BIT REDUCTION ===
+        // Apply bit reduction for all bit depths (including 16-bit)
+        // Use proper bit depth calculation: for N bits, we have 2^N levels
+        const double scaled = (processed + 1.0) * 0.5 * maxLevel; // Map -1..1 to 0..maxLevel
+        const double quantized = (std::floor(scaled + 0.5) / maxLevel) * 2.0 - 1.0; // Quantize and map back to -1..1
+
+        double transient = processed - mHot.mpcPrevSample[c];
+        double transientShape = saturate(transient * bitTransientGain);
+        mHot.mpcPrevSample[c] = quantized;
+        processed = quantized + transientShape * bitTransientMix;
+
+        // === RESAMPLER (aliasing sample & hold) ===
+        double& phase = mHot.resamplePhase[c];
+        double& hold = mHot.resampleHold[c];
+        double step = std::max(0.05, resampleRatio + pitchInfluence);
+        if (resamplerOn)
+        {
+          if (phase <= 0.0)
+            hold = processed;
+
+          phase += step;
+          if (phase >= 1.0)
+          {
+            phase -= std::floor(phase);
+            hold = processed;
+          }
+
+          const double aliasBlend = std::clamp(aliasBase + std::fabs(pitchInfluence) * 0.25, 0.0, 0.85);
+          processed = hold + (processed - hold) * aliasBlend;
+        }
+        else
+        {
+          // step >= 1: latches every sample, only the phase moves
+          phase += step;
+          phase -= std::floor(phase);
+          hold = processed;
+        }
+
+        // === WOW & FLUTTER DELAYED PLAYBACK ===
+        int& writeIdx = mHot.wowWriteIndex[c];
+        wowBuffer[writeIdx * kMaxChannels + c] = processed;
+
+        double readPos = static_cast<double>(writeIdx) - clampedDelay;
+        while (readPos < 0.0)
+          readPos += static_cast<double>(wowSize);
+
+        const int idxA = static_cast<int>(readPos) & wowMask;
+        const int idxB = (idxA + 1) & wowMask;
+        const double frac = (readPos - static_cast<double>(idxA)) * mHot.interpBlend;
+        const double sampleA = wowBuffer[idxA * kMaxChannels + c];
+        const double delayed = sampleA + (wowBuffer[idxB * kMaxChannels + c] - sampleA) * frac;
+
+        writeIdx = (writeIdx + 1) & wowMask;
+        processed = delayed;
+
+        // === LOW-PASS SMOOTHER ===
+        processed = mLowPassFilter.Process(processed, c);
+
+        // === VINYL NOISE GENERATOR (IMPROVED) ===
+        if (noiseOn)
+        {
+          uint32_t& seed = mHot.noiseSeeds[c];
+          const double white = NextRandom(seed) - 0.5;
+
+          // Hiss component - more gentle high-frequency roll-off
+          double& hissState = mHot.noiseFilter[c];
+          hissState = 0.96 * hissState + 0.04 * white; // Softer filtering
+          const double hissGain = noiseAmount * 0.25; // Reduced gain
+          const double hiss = (0.8 * hissState + 0.2 * white) * hissGain;
+
+          // Apply dedicated LPF to reduce harshness (around 6kHz)
+          const double filteredHiss = reduced ? 0.0 : mNoiseLowPassFilter.Process(hiss, c);
+
+          // Crackle/Pop component - more realistic vinyl behavior
+          double crackle = 0.0;
+          double& crackleEnv = mHot.crackleEnvelope[c];
+          int& cooldown = mHot.crackleCooldown[c];
+          if (cooldown <= 0)
+          {
+            // Much lower trigger probability for subtle vinyl effect
+            const double triggerProbability = 0.000008 + noiseAmount * 0.00015;
+            if (NextRandom(seed) < triggerProbability)
+            {
+              // REDUCED: Much lower intensity for crackle peaks (was 0.6-1.2, now 0.15-0.35)
+              crackleEnv = 0.15 + NextRandom(seed) * 0.2;
+              // Longer cooldown for more spaced-out pops
+              cooldown = std::max(1, static_cast<int>(sampleRate * (0.04 + NextRandom(seed) * 0.12)));
+            }
+          }
+          else
+          {
+            --cooldown;
+          }
+
+          if (crackleEnv > 0.0001)
+          {
+            const double pop = NextRandom(seed) * 2.0 - 1.0;
+            // REDUCED: Much lower crackle gain (was 0.3-1.0, now 0.08-0.25)
+            crackle = pop * crackleEnv * (0.08 + noiseAmount * 0.17);
+            // Slower decay for more natural sound
+            crackleEnv *= 0.65 + noiseAmount * 0.15;
+            if (crackleEnv < 0.00005)
+              crackleEnv = 0.0;
+          }
+
+          // Apply LPF to crackle as well to reduce harshness (reduced tiers
+          // filter hiss and crackle together in a single pass)
+          if (reduced)
+          {
+            processed += mNoiseLowPassFilter.Process(hiss + crackle, c);
+          }
+          else
+          {
+            const double filteredCrackle = mNoiseLowPassFilter.Process(crackle, c);
+            processed += filteredHiss + filteredCrackle;
+          }
+        }
+
+        // === CLIPPER ===
+        double clipped = processed;
+        if (clipMode == kClipModeHard)
+        {
+          clipped = std::max(-threshold, std::min(processed, threshold));
+        }
+        else if (clipMode == kClipModeSoft)
+        {
+          // Symmetric form of the two-sided knee, written as selects
+          const double magnitude = std::fabs(processed);
+          const double over = magnitude - threshold;
+          const double knee = std::min(threshold + over / (1.0 + slope * over), softLimit);
+          clipped = over > 0.0 ? std::copysign(knee, processed) : processed;
+        }
+        else // tanh
+        {
+          clipped = threshold * saturate(processed / threshold);
+        }
+
+        // Smooth bypass crossfade
+        const double wetSignal = clipped;
+        const double drySignal = inputSample;
+        const double mixedOutput = drySignal * (1.0 - mHot.bypassRamp) + wetSignal * mHot.bypassRamp;
+
+        outputs[c][s] = static_cast<T>(mixedOutput);
+      }
+    }
+
+    // The next span continues where this one stopped
+    if (Ramping)
+    {
+      block.rampStart = ramp;
+      block.bandStart = bandRamp;
+    }
+    return drivePeak;
+  }
+
+  // True-peak ceiling at the clip threshold, then the output gain, which
+  // starts at gain and moves by gainStep per frame. One channel at a time:
+  // the limiter keeps its state per channel.
+  template <typename T>
+  void ApplyOutputStage(T** outputs, int nFrames, int firstChan, int lastChan, bool truePeak, double ceiling, double gain, double gainStep)
+  {
+    if (truePeak)
+    {
+      for (int c = firstChan; c < lastChan; ++c)
+      {
+        double g = gain;
+        for (int s = 0; s < nFrames; ++s)
+        {
+          g += gainStep;
+          outputs[c][s] = static_cast<T>(mLimiter.Process(outputs[c][s], ceiling, c) * g);
+        }
+      }
+    }
+    else if (gain != 1.0 || gainStep != 0.0)
+    {
+      for (int c = firstChan; c < lastChan; ++c)
+      {
+        double g = gain;
+        for (int s = 0; s < nFrames; ++s)
+        {
+          g += gainStep;
+          outputs[c][s] = static_cast<T>(outputs[c][s] * g);
+        }
+      }
+    }
+  }
+
+  // Counts a rendered span off the ramps. A finished ramp lands exactly on
+  // its target and stops.
+  void AdvanceRamps(int nFrames)
+  {
+    BlockParams& b = mBlock;
+    if (b.rampFrames > 0 && (b.rampFrames -= nFrames) <= 0)
+    {
+      b.rampStart = mRampTarget;
+      b.rampStep = RampedParams::Still();
+      b.rampFrames = 0;
+      b.rampEnded = true;
+    }
+    if (b.bandRampFrames > 0 && (b.bandRampFrames -= nFrames) <= 0)
+    {
+      b.bandStart = mBandTarget;
+      b.bandStep = {};
+      b.bandRampFrames = 0;
+    }
+  }
+
+  void ApplyEvents(const TapeParamEvent* events, int numEvents)
+  {
+    for (int i = 0; i < numEvents; ++i)
+      SetParam(events[i].paramIdx, events[i].value);
+  }
+
+  // Lookahead changes resize the limiter here rather than in SetParam, so the
+  // audio thread never sees a half-configured limiter. While true-peak mode
+  // is off the request waits.
+  void UpdateLimiter()
+  {
+    if (mTruePeakOn && mDerivedDirty.Take(kDirtyLimiter))
+      mLimiter.Configure(mSampleRate, mTruePeakLookaheadMs);
+  }
+
+  // Fully bypassed: input to output, through the limiter's delay line while
+  // true-peak mode reports latency
+  template <typename T>
+  void RenderBypassed(const T* const* inputs, T** outputs, int nFrames, int firstChan, int lastChan)
+  {
+    for (int c = firstChan; c < lastChan; ++c)
+    {
+      if (mTruePeakOn)
+      {
+        for (int s = 0; s < nFrames; ++s)
+          outputs[c][s] = static_cast<T>(mLimiter.Delay(inputs[c][s], c));
+      }
+      else
+      {
+        std::copy(inputs[c], inputs[c] + nFrames, outputs[c]);
+      }
+    }
+    // NaN or Inf in the delay line would keep coming out in later blocks
+    if (mTruePeakOn && !OutputIsFinite(outputs, nFrames, firstChan, lastChan))
+      RecoverFromNonFinite(outputs, nFrames, firstChan, lastChan);
+  }
+
+  // Renders the frames up to the next event. Ramps started here last
+  // rampLength frames (the host block); the segment is cut into spans where
+  // a ramp ends, so a ramping prefix goes through a ramping kernel and the
+  // steady remainder through one that holds every value. Returns the drive
+  // stage peak.
+  template <typename T>
+  float RenderSegment(const T* const* inputs, T** outputs, int nFrames, int firstChan, int lastChan, int rampLength)
+  {
+    UpdateLimiter();
+
+    // Signal flow: Input → Drive/Transformer → Tone → Bit Reduction → Resampler → Wow/Flutter → Low-pass → Dry/Wet → Clipper → True-peak limiter (optional) → Auto gain (optional) → Output
+    BlockParams& block = PrepareBlock(rampLength);
+
+    // The input is metered before the kernel, which may render in place
+    const bool autoGain = mAutoGainOn || CompensationActive(firstChan, lastChan);
+    if (autoGain)
+      mLoudness.Process(LoudnessMeter::kSideInput, inputs, nFrames, firstChan, lastChan);
+
+    const T* spanInputs[kMaxChannels] = {};
+    T* spanOutputs[kMaxChannels] = {};
+    float drivePeak = 0.0f;
+    for (int start = 0; start < nFrames;)
+    {
+      int length = nFrames - start;
+      if (block.rampFrames > 0)
+        length = std::min(length, block.rampFrames);
+      if (block.bandRampFrames > 0)
+        length = std::min(length, block.bandRampFrames);
+      const bool ramping = block.rampFrames > 0 || block.bandRampFrames > 0;
+      for (int c = firstChan; c < lastChan; ++c)
+      {
+        spanInputs[c] = inputs[c] + start;
+        spanOutputs[c] = outputs[c] + start;
+      }
+      const double gain = block.rampStart.outputGain;
+      const KernelFn<T> kernel = SelectKernel<T>(block, ramping);
+      drivePeak = std::max(drivePeak, (this->*kernel)(spanInputs, spanOutputs, length, firstChan, lastChan, block));
+      ApplyOutputStage(spanOutputs, length, firstChan, lastChan, block.truePeak, block.threshold, gain, block.rampStep.outputGain);
+      AdvanceRamps(length);
+      start += length;
+    }
+
+    // === NON-FINITE SENTINEL ===
+    // NaN or Inf in the recursive state would otherwise latch until the next
+    // Reset. The state is checked as well as the output because the hard
+    // clipper turns NaN into a finite value.
+    if (!OutputIsFinite(outputs, nFrames, firstChan, lastChan) || !StateIsFinite())
+    {
+      RecoverFromNonFinite(outputs, nFrames, firstChan, lastChan);
+      if (autoGain) // keeps the output side in step with the input side
+        mLoudness.Process(LoudnessMeter::kSideOutput, outputs, nFrames, firstChan, lastChan);
+      return 0.0f;
+    }
+
+    // === AUTO GAIN ===
+    if (autoGain)
+      ApplyAutoGain(outputs, nFrames, firstChan, lastChan);
+    ApplyRecoveryFade(outputs, nFrames, firstChan, lastChan);
+    return drivePeak;
+  }
+
+  template <typename T>
+  static bool OutputIsFinite(T** outputs, int nFrames, int firstChan, int lastChan)
+  {
+    for (int c = firstChan; c < lastChan; ++c)
+    {
+      if (!tapedsp::AllFinite(outputs[c], nFrames))
+        return false;
+    }
+    return true;
+  }
+
+  // Recursive state only: the delay line and the limiter are fed from it and reach the output within the block
+  bool StateIsFinite() const
+  {
+    using tapedsp::Double4;
+
+    Double4 probe = 0.0;
+    for (int c = 0; c < kMaxChannels; ++c)
+    {
+      probe = probe + Double4(mHot.transformerSaturation[c], mHot.transformerBias[c], mHot.transformerLowpass[c], mHot.toneEnvelope[c]) * 0.0
+            + Double4(mHot.mpcPrevSample[c], mHot.noiseFilter[c], mHot.crackleEnvelope[c], mHot.resampleHold[c]) * 0.0
+            + mHot.bandSaturation[c] * 0.0 + mHot.bandBias[c] * 0.0;
+    }
+    return probe.Sum() == 0.0 && mTone.IsFinite() && mLowPassFilter.IsFinite() && mNoiseLowPassFilter.IsFinite() && mBandSplitter.IsFinite();
+  }
+
+  // Signal-carrying state: filters, envelopes, followers, the delay line and
+  // the limiter. Parameters, derived values, LFO phases and noise seeds stay.
+  void ClearSignalState()
+  {
+    mHot.transformerSaturation.fill(0.0);
+    mHot.transformerBias.fill(0.0);
+    mHot.transformerLowpass.fill(0.0);
+    mHot.toneEnvelope.fill(0.0);
+    mHot.bandSaturation.fill(0.0);
+    mHot.bandBias.fill(0.0);
+    mBandSplitter.Reset();
+    mTone.Reset();
+    mLowPassFilter.Reset();
+    mNoiseLowPassFilter.Reset();
+    mLimiter.Reset();
+    mHot.resamplePhase.fill(0.0);
+    mHot.resampleHold.fill(0.0);
+    mHot.mpcPrevSample.fill(0.0);
+    mHot.noiseFilter.fill(0.0);
+    mHot.crackleEnvelope.fill(0.0);
+    mHot.crackleCooldown.fill(0);
+    std::fill(mWowBuffer.begin(), mWowBuffer.end(), 0.0);
+  }
+
+  // Silences the block, starts again from clean state and fades back in
+  template <typename T>
+  void RecoverFromNonFinite(T** outputs, int nFrames, int firstChan, int lastChan)
+  {
+    for (int c = firstChan; c < lastChan; ++c)
+      std::fill(outputs[c], outputs[c] + nFrames, static_cast<T>(0));
+
+    ClearSignalState();
+    mDriveSmoother.SetValue(mDriveGain);
+    mDerivedDirty.Set(kDirtyAll | kSnapRamps);
+    mRecoveryGain.fill(0.0);
+    mLastPeak = 0.0f;
+    ++mNonFiniteEvents;
+  }
+
+  bool CompensationActive(int firstChan, int lastChan) const
+  {
+    for (int c = firstChan; c < lastChan; ++c)
+    {
+      if (mCompensationDb[c] != 0.0)
+        return true;
+    }
+    return false;
+  }
+
+  // Matches each channel's short-term output loudness to its input. The
+  // output is metered here, ahead of the compensation and with the Output
+  // gain taken back out, so Output still trims on top. The gain follows in
+  // dB with a slow one-pole and ramps linearly across the block; switching
+  // AutoGain off returns to unity over kAutoGainReleaseSec. Channels are
+  // compensated independently, which keeps the input's balance and lets
+  // per-channel instances agree with one stereo instance.
+  // The compensation comes after the clipper and the true-peak limiter, so
+  // while TruePeak is on it only attenuates (at most 0 dB) and the ceiling
+  // holds; the Output gain still applies on top, as it does without
+  // AutoGain.
+  template <typename T>
+  void ApplyAutoGain(T** outputs, int nFrames, int firstChan, int lastChan)
+  {
+    mLoudness.Process(LoudnessMeter::kSideOutput, outputs, nFrames, firstChan, lastChan);
+
+    const double sampleRate = std::max(mSampleRate, 1.0);
+    const double smoothSec = mAutoGainOn ? kAutoGainSmoothSec : kAutoGainReleaseSec;
+    const double alpha = 1.0 - std::exp(-nFrames / (smoothSec * sampleRate));
+    const double maxDb = mTruePeakOn ? 0.0 : kAutoGainMaxDb;
+    for (int c = firstChan; c < lastChan; ++c)
+    {
+      double& compensationDb = mCompensationDb[c];
+      double targetDb = 0.0;
+      if (mAutoGainOn)
+      {
+        const double inputLufs = mLoudness.GetShortTermChannel(LoudnessMeter::kSideInput, c);
+        const double processedLufs = mLoudness.GetShortTermChannel(LoudnessMeter::kSideOutput, c) - mOutputGainDB;
+        // Silence and noise floors hold the gain instead of chasing it
+        targetDb = inputLufs > kAutoGainGateLUFS && processedLufs > kAutoGainGateLUFS
+                 ? std::clamp(inputLufs - processedLufs, kAutoGainMinDb, maxDb)
+                 : compensationDb;
+      }
+      // Switching TruePeak on drops any boost within the block
+      compensationDb = std::min(compensationDb + (targetDb - compensationDb) * alpha, maxDb);
+      if (!mAutoGainOn && std::fabs(compensationDb) < 0.001)
+        compensationDb = 0.0;
+
+      double& gain = mCompensationGain[c];
+      const double targetGain = std::pow(10.0, compensationDb / 20.0);
+      const double step = (targetGain - gain) / nFrames;
+      for (int s = 0; s < nFrames; ++s)
+      {
+        gain += step;
+        outputs[c][s] = static_cast<T>(outputs[c][s] * gain);
+      }
+      gain = targetGain;
+    }
+  }
+
+  template <typename T>
+  void ApplyRecoveryFade(T** outputs, int nFrames, int firstChan, int lastChan)
+  {
+    const double step = 1.0 / (kRecoveryFadeSec * std::max(mSampleRate, 1.0));
+    for (int c = firstChan; c < lastChan; ++c)
+    {
+      double& gain = mRecoveryGain[c];
+      if (gain >= 1.0)
+        continue;
+      for (int s = 0; s < nFrames; ++s)
+      {
+        outputs[c][s] = static_cast<T>(outputs[c][s] * gain);
+        gain = std::min(gain + step, 1.0);
+      }
+    }
+  }
+
+  static uint32_t DeriveNoiseSeed(uint32_t seed, uint32_t channel)
+  {
+    // splitmix32-style scramble so neighbouring seeds give unrelated noise
+    uint32_t z = seed + 0x9E3779B9u * (channel + 1u);
+    z = (z ^ (z >> 16)) * 0x85EBCA6Bu;
+    z = (z ^ (z >> 13)) * 0xC2B2AE35u;
+    return z ^ (z >> 16);
+  }
+
+  void UpdateToneFilters()
+  {
+    if (!mPrepared)
+      return; // done by the first Reset
+    const double sampleRate = std::max(mSampleRate, 1.0);
+    const MachineModel& model = kMachineModels[mMachine];
+    const double lowShelfGain = model.lowShelfDb + mToneLowGain;
+    const double highShelfGain = model.highShelfDb + mToneHighGain;
+    const double midGainDb = model.midDb + (mToneMidQ - 1.0) * 2.0;
+    const double midQ = std::clamp(model.midQ + (mToneMidQ - 1.0) * 0.7, 0.4, 3.0);
+
+    // Only the section whose inputs moved is redesigned (or fetched from the memo)
+    mToneCoeffCache.Update(ToneCascade::kLowShelf, kBiquadLowShelf, sampleRate, model.lowShelfHz, lowShelfGain, model.lowShelfQ, mTone.coeffs[ToneCascade::kLowShelf]);
+    mToneCoeffCache.Update(ToneCascade::kMidBell, kBiquadPeaking, sampleRate, model.midHz, midGainDb, midQ, mTone.coeffs[ToneCascade::kMidBell]);
+    mToneCoeffCache.Update(ToneCascade::kHighShelf, kBiquadHighShelf, sampleRate, model.highShelfHz, highShelfGain, model.highShelfQ, mTone.coeffs[ToneCascade::kHighShelf]);
+  }
+
+  // Smallest power of two holding the longest modulated delay (base delay
+  // plus full wow and flutter depth) with room for the interpolation taps:
+  // 128 frames at 48 kHz instead of a fixed 8192
+  static int WowBufferFrames(double sampleRate)
+  {
+    const double maxWow = GetTapeParamSpec(kParamWowAmount).maxValue * 0.0032;
+    const double maxFlutter = GetTapeParamSpec(kParamFlutterAmount).maxValue * 0.0025;
+    const double maxDelay = std::max(12.0, sampleRate * 0.0012) + sampleRate * (maxWow + maxFlutter);
+    int frames = 64;
+    while (frames < maxDelay + 4.0)
+      frames *= 2;
+    return frames;
+  }
+
+  // Transformer terms of every band: DriveGain plus the band's BandDrive
+  // through the machine's drive curves, sag depth scaled by BandSag.
+  // Unused lanes are silent and their terms do not matter.
+  void UpdateBandTerms(const MachineModel& model, double driveLinear)
+  {
+    using tapedsp::Double4;
+
+    double drive[tapedsp::BandSplitter::kMaxBands];
+    for (int i = 0; i < tapedsp::BandSplitter::kMaxBands; ++i)
+      drive[i] = std::clamp(driveLinear + mBandDrive[i], 0.0, 1.0);
+    auto lanes = [&](auto term) { return Double4(term(drive[0], 0), term(drive[1], 1), term(drive[2], 2), term(drive[3], 3)); };
+
+    TransformerTerms<Double4>& t = mBandTarget;
+    t.driveGain = lanes([&](double d, int) { return std::pow(10.0, (d * model.preampRangeDb + model.preampOffsetDb) / 20.0); });
+    t.sagCoeff = lanes([&](double d, int) { return std::clamp(model.sagBase + d * model.sagDrive, 0.9, 0.999); });
+    t.sagDepth = lanes([&](double d, int i) { return (model.sagDepthBase + d * model.sagDepthDrive) * std::max(mBandSag[i], 0.0); });
+    t.asymmetry = lanes([&](double d, int) { return model.asymmetryBase + d * model.asymmetryDrive; });
+    t.biasMix = lanes([&](double d, int) { return model.biasMixBase + d * model.biasMixDrive; });
+    t.evenEnhancer = lanes([&](double d, int) { return model.evenBase + d * model.evenDrive; });
+    t.triodeAmount = lanes([&](double d, int) { return model.triodeBase + d * model.triodeDrive; });
+    t.oddBoost = lanes([&](double d, int) { return 1.0 + d * model.oddDriveBoost; });
+    t.oddCubic = lanes([&](double d, int) { return model.oddCubicBase + d * model.oddCubicDrive; });
+    t.oddBlend = lanes([&](double d, int) { return model.oddBlendBase + d * model.oddBlendDrive; });
+    t.finalSaturation = lanes([&](double d, int) { return model.finalSatBase + d * model.finalSatDrive; });
+  }
+
+  void UpdateTapeEnvelope()
+  {
+    if (!mPrepared)
+      return; // done by the first Reset
+    const double sampleRate = std::max(mSampleRate, 1.0);
+    const MachineModel& model = kMachineModels[mMachine];
+    mHot.toneAttackCoeff = std::exp(-1.0 / (model.attackSec * sampleRate));
+    mHot.toneReleaseCoeff = std::exp(-1.0 / (model.releaseSec * sampleRate));
+    mHot.toneSaturationMix = model.saturationMix;
+  }
+
+  void UpdateLowPassFilter()
+  {
+    if (!mPrepared)
+      return; // done by the first Reset
+    const double sampleRate = std::max(mSampleRate, 1.0);
+    const double nyquist = sampleRate * 0.5;
+    const double cutoff = std::clamp(mLowPassCutoff, 20.0, nyquist * 0.98);
+    const double resonance = std::clamp(mLowPassResonance, 0.3, 8.0);
+    mLowPassFilter.SetLowPass(sampleRate, cutoff, resonance);
+  }
+
+  void RefreshWowFlutterIncrements()
+  {
+    if (!mPrepared)
+      return; // done by the first Reset
+    const double sampleRate = std::max(mSampleRate, 1.0);
+    const double wowRate = std::clamp(mWowRate, 0.05, 5.0);
+    const double flutterRate = std::clamp(mFlutterRate, 1.0, 40.0);
+    mHot.wowPhaseInc = (2.0 * tapedsp::kPi * wowRate) / sampleRate;
+    mHot.flutterPhaseInc = (2.0 * tapedsp::kPi * flutterRate) / sampleRate;
+  }
+
+  // Per-sample state, packed into a few contiguous cache lines. Per-channel
+  // fields are [channel] arrays, so a stereo frame reads both channels from
+  // the same line.
+  struct alignas(tapedsp::kCacheLineSize) HotState
+  {
+    std::array<double, kMaxChannels> transformerSaturation {};
+    std::array<double, kMaxChannels> transformerBias {};
+    std::array<double, kMaxChannels> transformerLowpass {};
+    std::array<double, kMaxChannels> toneEnvelope {};
+    std::array<tapedsp::Double4, kMaxChannels> bandSaturation {};  // multiband sag and bias, one lane per band
+    std::array<tapedsp::Double4, kMaxChannels> bandBias {};
+    std::array<double, kMaxChannels> resamplePhase {};
+    std::array<double, kMaxChannels> resampleHold {};
+    std::array<double, kMaxChannels> mpcPrevSample {};
+    std::array<double, kMaxChannels> noiseFilter {};
+    std::array<double, kMaxChannels> crackleEnvelope {};
+    std::array<uint32_t, kMaxChannels> noiseSeeds {{0x243F6A88u, 0x13198A2Eu}};
+    std::array<int, kMaxChannels> crackleCooldown {};
+    std::array<int, kMaxChannels> wowWriteIndex {};
+    double wowPhase = 0.0;
+    double flutterPhase = 0.0;
+    double wowPhaseInc = 0.0;
+    double flutterPhaseInc = 0.0;
+    double interpBlend = 1.0;  // delay-line interpolation weight, ramps with the tier
+    double bypassRamp = 1.0;   // smooth bypass ramp (0.0 = bypassed, 1.0 = active)
+    double toneAttackCoeff = 0.0;
+    double toneReleaseCoeff = 0.0;
+    double toneSaturationMix = 0.3;
+  };
+
+  // Hot: touched by every sample
+  HotState mHot;
+  ToneCascade mTone;
+  BiquadFilter mLowPassFilter;
+  BiquadFilter mNoiseLowPassFilter;  // Dedicated LPF for vinyl noise
+  tapedsp::BandSplitter mBandSplitter; // multiband drive crossovers
+  TruePeakLimiter mLimiter;
+
+  // Wow/flutter delay line, frame-interleaved ([index * kMaxChannels + c]),
+  // a power of two of frames sized by Reset for the sample rate
+  std::vector<double> mWowBuffer;
+
+  // Warm: touched once per block
+  BlockParams mBlock;
+  RampedParams mRampTarget;  // where the ramps in flight end
+  TransformerTerms<tapedsp::Double4> mBandTarget;
+  int mSplitBands = 1;       // band layout the splitter state belongs to
+  DirtyMask mDerivedDirty {kDirtyAll | kSnapRamps | kDirtyLimiter};  // EDerivedDirty, set by SetParam on any thread
+  OnePoleSmoother mDriveSmoother;
+  float mLastPeak = 0.f;
+  double mSampleRate = kDefaultSampleRate;
+  bool mSpecialisedKernels = true;
+  // Fade-in after a non-finite block, per channel (1 = none)
+  static constexpr double kRecoveryFadeSec = 0.01;
+  std::array<double, kMaxChannels> mRecoveryGain {{1.0, 1.0}};
+  uint32_t mNonFiniteEvents = 0;
+  // AutoGain: compensation per channel in dB and the linear gain the last
+  // block ended on
+  static constexpr double kAutoGainSmoothSec = 2.0;
+  static constexpr double kAutoGainReleaseSec = 0.05;
+  static constexpr double kAutoGainGateLUFS = -60.0;
+  static constexpr double kAutoGainMinDb = -30.0;
+  static constexpr double kAutoGainMaxDb = 12.0;
+  LoudnessMeter mLoudness;
+  std::array<double, kMaxChannels> mCompensationDb {};
+  std::array<double, kMaxChannels> mCompensationGain {{1.0, 1.0}};
+  int mQualityTier = kQualityTierHigh;
+
+  // Cached parameter state (synchronised through SetParam)
+  double mDriveGain = 0.2;
+  double mToneLowGain = 0.0;
+  double mToneHighGain = 0.0;
+  double mToneMidQ = 1.0;
+  int mMpcBits = 16;
+  double mResampleRatio = 1.0;
+  double mWowAmount = 0.02;
+  double mWowRate = 0.2;
+  double mFlutterAmount = 0.01;
+  double mFlutterRate = 8.0;
+  double mNoiseLevel = 0.0;
+  double mLowPassCutoff = 18000.0;
+  double mLowPassResonance = 0.7;
+  double mOutputGainDB = 0.0;      // -12 to +12 dB
+  double mOutputGainLinear = 1.0;  // Linear conversion
+  double mClipThreshold = 1.0;
+  int mClipMode = kClipModeTanh;
+  double mClipSlope = 0.5;
+  bool mPowerOn = true;
+  bool mTruePeakOn = false;
+  double mTruePeakLookaheadMs = 1.5;
+  bool mAutoGainOn = false;
+  int mMachine = kMachineStudio;
+  int mBands = 1;
+  std::array<double, tapedsp::BandSplitter::kMaxBands - 1> mCrossover {{250.0, 1800.0, 7000.0}};
+  std::array<double, tapedsp::BandSplitter::kMaxBands> mBandDrive {};
+  std::array<double, tapedsp::BandSplitter::kMaxBands> mBandSag {{1.0, 1.0, 1.0, 1.0}};
+
+  // Cold: only touched when parameters change
+  bool mPrepared = false;  // set by the first Reset (or LoadState)
+  bool mDeterministic = false;
+  uint32_t mSeed = 0;
+  ToneCoeffCache mToneCoeffCache;
+};
@@ -0,0 +1,239 @@
+#pragma once
+
+// True-peak limiter used by the CLIPPER stage when TruePeak is enabled.
+// Inter-sample peaks are estimated ITU-R BS.1770 style with a 4x polyphase
+// interpolator, and a lookahead gain computer keeps the reconstructed signal
+// under the ceiling. Channels are limited independently so the per-channel
+// rendering of the offline tools stays identical to stereo processing.
+// Everything is plain data: the limiter can be copied and serialised as is.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define TAPEDSP_TRUEPEAK_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  #include <arm_neon.h>
+  #define TAPEDSP_TRUEPEAK_NEON 1
+#endif
+
+class TruePeakLimiter
+{
+public:
+  static constexpr int kMaxChannels = 2;
+  static constexpr int kOversampling = 4;
+  static constexpr int kTapsPerPhase = 12;
+  // The interpolated points of sample n lie between n - 6 and n - 5
+  static constexpr int kDetectorDelay = 5;
+  static constexpr int kMaxLookahead = 384; // samples, 2 ms at 192 kHz
+  static constexpr double kReleaseMs = 60.0;
+
+  // Resizes the lookahead window and clears all state
+  void Configure(double sampleRate, double lookaheadMs)
+  {
+    const double sr = std::max(sampleRate, 1.0);
+    mLookahead = std::clamp(static_cast<int>(std::lround(lookaheadMs * 0.001 * sr)), 1, kMaxLookahead);
+    mInvLookahead = 1.0 / mLookahead;
+    mReleaseCoeff = 1.0 - std::exp(-1.0 / (kReleaseMs * 0.001 * sr));
+    Reset();
+  }
+
+  void Reset()
+  {
+    for (Channel& ch : mChannels)
+    {
+      ch = Channel();
+      std::fill(ch.box.begin(), ch.box.begin() + mLookahead, 1.0);
+      ch.boxSum = mLookahead;
+    }
+  }
+
+  // Full rate estimates four interpolated points per sample. Otherwise only
+  // the two odd phases are used (2x), which reads inter-sample peaks a little
+  // lower but halves the detector cost.
+  void SetFullRateDetector(bool enabled) { mFullRateDetector = enabled; }
+
+  // Delay of the limited output relative to the input
+  int GetLatencySamples() const { return mLookahead + kDetectorDelay; }
+
+  // Returns the delayed input with the gain that keeps its true peak at or
+  // below ceiling
+  inline double Process(double input, double ceiling, int channel)
+  {
+    Channel& ch = mChannels[channel > 0 ? 1 : 0];
+    PushHistory(ch, input);
+
+    const double* window = ch.history.data() + ch.historyPos;
+    const double interpolated = mFullRateDetector ? InterpolatedPeak(window) : InterpolatedPeakHalfRate(window);
+    const double peak = std::max(interpolated, std::fabs(window[kTapsPerPhase - 1 - kDetectorDelay]));
+    const double required = peak > ceiling ? ceiling / peak : 1.0;
+    return Advance(ch, input, required, true);
+  }
+
+  // Keeps the delay line running without limiting (bypass), so latency stays
+  // constant and switching back in does not jump in time
+  inline double Delay(double input, int channel)
+  {
+    Channel& ch = mChannels[channel > 0 ? 1 : 0];
+    PushHistory(ch, input);
+    return Advance(ch, input, 1.0, false);
+  }
+
+private:
+  static constexpr int kRingSize = 512; // > kMaxLookahead + kDetectorDelay
+  static constexpr uint32_t kRingMask = kRingSize - 1;
+
+  // 48-tap Kaiser-windowed sinc (beta 5, cutoff at the input Nyquist), each
+  // phase normalised to unity DC gain. Row j multiplies history[j] (oldest
+  // first); the four columns produce the four interpolated phases.
+  alignas(16) static constexpr double kPhaseCoeffs[kTapsPerPhase * kOversampling] = {
+    -0.0027529453901380739, -0.0046420470343188011, -0.0030588041979620084, -0.00076151030650537714,
+    0.008419018884226, 0.015900181403453225, 0.012201176421800916, 0.0037862661693323085,
+    -0.019823250916814649, -0.039202206724785131, -0.031843792565544655, -0.010602154273751338,
+    0.042441470235499719, 0.084832048695972981, 0.070275041805625965, 0.024064295635225202,
+    -0.099742535074561336, -0.18912250273923115, -0.15222488109985111, -0.051498533256368148,
+    0.97395649251604732, 0.77774945274052631, 0.45913633329431336, 0.13251338577780852,
+    0.13251338577780852, 0.45913633329431336, 0.77774945274052631, 0.97395649251604732,
+    -0.051498533256368148, -0.15222488109985111, -0.18912250273923115, -0.099742535074561336,
+    0.024064295635225202, 0.070275041805625965, 0.084832048695972981, 0.042441470235499719,
+    -0.010602154273751338, -0.031843792565544655, -0.039202206724785131, -0.019823250916814649,
+    0.0037862661693323085, 0.012201176421800916, 0.015900181403453225, 0.008419018884226,
+    -0.00076151030650537714, -0.0030588041979620084, -0.0046420470343188011, -0.0027529453901380739,
+  };
+
+  struct Channel
+  {
+    std::array<double, 2 * kTapsPerPhase> history {}; // mirrored: a window never wraps
+    std::array<double, kRingSize> delay {};
+    std::array<double, kRingSize> box {};
+    std::array<double, kRingSize> minValue {};        // monotonic queue for the sliding minimum
+    std::array<uint32_t, kRingSize> minIndex {};
+    uint32_t minHead = 0;
+    uint32_t minTail = 0;
+    uint32_t count = 0;
+    int historyPos = 0;
+    int boxPos = 0;
+    double boxSum = 0.0;
+    double release = 1.0;
+  };
+
+  static inline void PushHistory(Channel& ch, double input)
+  {
+    ch.history[ch.historyPos] = input;
+    ch.history[ch.historyPos + kTapsPerPhase] = input;
+    if (++ch.historyPos == kTapsPerPhase)
+      ch.historyPos = 0;
+  }
+
+  // Largest magnitude of the four interpolated phases; x holds the last
+  // kTapsPerPhase samples, oldest first
+  static inline double InterpolatedPeak(const double* x)
+  {
+#if defined(TAPEDSP_TRUEPEAK_SSE2)
+    __m128d acc01a = _mm_setzero_pd(), acc23a = _mm_setzero_pd();
+    __m128d acc01b = _mm_setzero_pd(), acc23b = _mm_setzero_pd();
+    for (int j = 0; j < kTapsPerPhase; j += 2)
+    {
+      const __m128d xa = _mm_set1_pd(x[j]);
+      const __m128d xb = _mm_set1_pd(x[j + 1]);
+      acc01a = _mm_add_pd(acc01a, _mm_mul_pd(xa, _mm_load_pd(kPhaseCoeffs + 4 * j)));
+      acc23a = _mm_add_pd(acc23a, _mm_mul_pd(xa, _mm_load_pd(kPhaseCoeffs + 4 * j + 2)));
+      acc01b = _mm_add_pd(acc01b, _mm_mul_pd(xb, _mm_load_pd(kPhaseCoeffs + 4 * j + 4)));
+      acc23b = _mm_add_pd(acc23b, _mm_mul_pd(xb, _mm_load_pd(kPhaseCoeffs + 4 * j + 6)));
+    }
+    const __m128d signMask = _mm_set1_pd(-0.0);
+    const __m128d abs01 = _mm_andnot_pd(signMask, _mm_add_pd(acc01a, acc01b));
+    const __m128d abs23 = _mm_andnot_pd(signMask, _mm_add_pd(acc23a, acc23b));
+    const __m128d m = _mm_max_pd(abs01, abs23);
+    return _mm_cvtsd_f64(_mm_max_sd(m, _mm_unpackhi_pd(m, m)));
+#elif defined(TAPEDSP_TRUEPEAK_NEON)
+    float64x2_t acc01a = vdupq_n_f64(0.0), acc23a = vdupq_n_f64(0.0);
+    float64x2_t acc01b = vdupq_n_f64(0.0), acc23b = vdupq_n_f64(0.0);
+    for (int j = 0; j < kTapsPerPhase; j += 2)
+    {
+      acc01a = vfmaq_n_f64(acc01a, vld1q_f64(kPhaseCoeffs + 4 * j), x[j]);
+      acc23a = vfmaq_n_f64(acc23a, vld1q_f64(kPhaseCoeffs + 4 * j + 2), x[j]);
+      acc01b = vfmaq_n_f64(acc01b, vld1q_f64(kPhaseCoeffs + 4 * j + 4), x[j + 1]);
+      acc23b = vfmaq_n_f64(acc23b, vld1q_f64(kPhaseCoeffs + 4 * j + 6), x[j + 1]);
+    }
+    const float64x2_t m = vmaxq_f64(vabsq_f64(vaddq_f64(acc01a, acc01b)), vabsq_f64(vaddq_f64(acc23a, acc23b)));
+    return vmaxvq_f64(m);
+#else
+    double acc[kOversampling] = {};
+    for (int j = 0; j < kTapsPerPhase; ++j)
+    {
+      for (int p = 0; p < kOversampling; ++p)
+        acc[p] += x[j] * kPhaseCoeffs[kOversampling * j + p];
+    }
+    return std::max(std::max(std::fabs(acc[0]), std::fabs(acc[1])), std::max(std::fabs(acc[2]), std::fabs(acc[3])));
+#endif
+  }
+
+  // Phases 1 and 3 only
+  static inline double InterpolatedPeakHalfRate(const double* x)
+  {
+#if defined(TAPEDSP_TRUEPEAK_SSE2)
+    __m128d acc = _mm_setzero_pd();
+    for (int j = 0; j < kTapsPerPhase; ++j)
+      acc = _mm_add_pd(acc, _mm_mul_pd(_mm_set1_pd(x[j]), _mm_set_pd(kPhaseCoeffs[4 * j + 3], kPhaseCoeffs[4 * j + 1])));
+    const __m128d m = _mm_andnot_pd(_mm_set1_pd(-0.0), acc);
+    return _mm_cvtsd_f64(_mm_max_sd(m, _mm_unpackhi_pd(m, m)));
+#else
+    double acc1 = 0.0, acc3 = 0.0;
+    for (int j = 0; j < kTapsPerPhase; ++j)
+    {
+      acc1 += x[j] * kPhaseCoeffs[4 * j + 1];
+      acc3 += x[j] * kPhaseCoeffs[4 * j + 3];
+    }
+    return std::max(std::fabs(acc1), std::fabs(acc3));
+#endif
+  }
+
+  // Gain computer and delay line. The required gain goes through a sliding
+  // minimum over lookahead + 1 samples, a release follower and a moving
+  // average over lookahead samples. Every term of the average already holds
+  // the minimum for the samples on both sides of the interpolated peak, so
+  // the smoothed gain never exceeds what the peak requires.
+  inline double Advance(Channel& ch, double input, double required, bool applyGain)
+  {
+    const uint32_t n = ch.count++;
+
+    while (ch.minTail != ch.minHead && ch.minValue[(ch.minTail - 1) & kRingMask] >= required)
+      --ch.minTail;
+    ch.minValue[ch.minTail & kRingMask] = required;
+    ch.minIndex[ch.minTail & kRingMask] = n;
+    ++ch.minTail;
+    while (n - ch.minIndex[ch.minHead & kRingMask] > static_cast<uint32_t>(mLookahead))
+      ++ch.minHead;
+    const double windowMin = ch.minValue[ch.minHead & kRingMask];
+
+    ch.release = std::min(windowMin, ch.release + (1.0 - ch.release) * mReleaseCoeff);
+
+    ch.boxSum += ch.release - ch.box[ch.boxPos];
+    ch.box[ch.boxPos] = ch.release;
+    if (++ch.boxPos == mLookahead)
+    {
+      // Re-sum once per window so rounding errors cannot accumulate
+      ch.boxPos = 0;
+      ch.boxSum = 0.0;
+      for (int i = 0; i < mLookahead; ++i)
+        ch.boxSum += ch.box[i];
+    }
+
+    const uint32_t latency = static_cast<uint32_t>(mLookahead + kDetectorDelay);
+    const double delayed = ch.delay[(n - latency) & kRingMask];
+    ch.delay[n & kRingMask] = input;
+    if (!applyGain || ch.boxSum >= mLookahead)
+      return delayed; // exact pass-through while nothing is being limited
+    return delayed * (ch.boxSum * mInvLookahead);
+  }
+
+  std::array<Channel, kMaxChannels> mChannels {};
+  int mLookahead = 1;
+  double mInvLookahead = 1.0;
+  double mReleaseCoeff = 0.0;
+  bool mFullRateDetector = true;
+};
@@ -23,7 +23,12 @@
 #define PLUG_DOES_MIDI_OUT 1
 #define PLUG_DOES_MPE 0
 #define PLUG_DOES_STATE_CHUNKS 0
+// Linux builds are headless (no WebView editor)
+#if defined WEBVIEW_EDITOR_DELEGATE
 #define PLUG_HAS_UI 1
+#else
+#define PLUG_HAS_UI 0
+#endif
 #define PLUG_WIDTH 250
 #define PLUG_HEIGHT 350
 #define PLUG_FPS 60
@@ -56,6 +61,11 @@
 
 #define VST3_SUBCATEGORY "Fx|Distortion"
 
+#define CLAP_MANUAL_URL "https://www.itbblog.com"
+#define CLAP_SUPPORT_URL "https://www.itbblog.com"
+#define CLAP_DESCRIPTION "Lo-fi tape saturation with wow, flutter and bit reduction"
+#define CLAP_FEATURES "audio-effect", "distortion"
+
 #define APP_NUM_CHANNELS 2
 #define APP_N_VECTOR_WAIT 0
 #define APP_MULT 1
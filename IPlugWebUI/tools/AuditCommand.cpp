@@ -0,0 +1,342 @@
+// lofi-audit: realtime-safety audit of the DSP core. A separate program from
+// lofi-render, because RealtimeAudit.cpp interposes on libc for the whole
+// process.
+//
+//   lofi-audit [--rate hz] [--block frames] [--max-stacks n]
+//
+// Runs every combination of machine model, clip mode, quality tier and the
+// optional stages (noise, resampler, wow/flutter, true-peak, 4-band drive,
+// auto gain) and, for each, does what the audio thread of the plug-in does
+// inside a rtaudit::Scope (see RealtimeAudit.h): block-rate parameter changes, sample-accurate
+// events sweeping every parameter to its minimum, maximum and default,
+// per-channel rendering as in the CLAP thread-pool path, a power-off to the
+// bypass path and back, a true-peak lookahead change, quality tier switches,
+// and Resets at the same and at another sample rate. Construction and the
+// first Reset happen outside the scope, as in a host. The capture ring of the
+// editor's spectrum analyser is audited the same way, with the analyser's
+// worker draining it on its own thread.
+//
+// Any allocation, free, lock or blocking/logging call reached from there is
+// a violation. They are grouped by call site and printed with the first
+// configuration that hit them and a stack trace (link with -rdynamic for
+// symbol names, otherwise resolve the offsets with addr2line). The exit code
+// is 1 on any violation and 2 if interposition is unavailable on this
+// platform.
+
+#include "SpectrumAnalyser.h"
+#include "RealtimeAudit.h"
+#include "TapeJob.h"
+
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct AuditSettings
+{
+  double sampleRate = 48000.0;
+  int blockSize = 256;
+  int maxStacks = 20;
+};
+
+enum EAuditPhase
+{
+  kPhaseAutomation = 0,
+  kPhaseEvents,
+  kPhaseChannels,
+  kPhasePower,
+  kPhaseLookahead,
+  kPhaseTiers,
+  kPhaseReset,
+  kNumAuditPhases
+};
+
+const char* kPhaseNames[kNumAuditPhases] = {"automation", "param events", "per-channel", "power off/on", "lookahead", "tier switch", "reset"};
+const char* kClipModeNames[kNumClipModes] = {"Hard", "Soft", "Tanh"};
+const char* kTierNames[kNumQualityTiers] = {"high", "eco", "draft"};
+const char* kMachineNames[kNumMachines] = {"Studio", "Cassette", "Cart", "Sampler"};
+
+// Optional stages, one bit each
+enum EAuditStage
+{
+  kStageNoise = 1 << 0,
+  kStageResampler = 1 << 1,
+  kStageWow = 1 << 2,
+  kStageTruePeak = 1 << 3,
+  kStageMultiband = 1 << 4,
+  kStageAutoGain = 1 << 5,
+  kNumStageCombinations = 1 << 6
+};
+
+struct AuditConfig
+{
+  int machine;
+  int clipMode;
+  int tier;
+  int stages;
+};
+
+std::string ConfigLabel(const AuditConfig& config)
+{
+  std::string label = std::string(kMachineNames[config.machine]) + "/" + kClipModeNames[config.clipMode] + "/" + kTierNames[config.tier];
+  if (config.stages & kStageNoise)
+    label += " noise";
+  if (config.stages & kStageResampler)
+    label += " resampler";
+  if (config.stages & kStageWow)
+    label += " wow";
+  if (config.stages & kStageTruePeak)
+    label += " truepeak";
+  if (config.stages & kStageMultiband)
+    label += " multiband";
+  if (config.stages & kStageAutoGain)
+    label += " autogain";
+  return label;
+}
+
+// Parameter values of a configuration, applied from inside the scope
+std::vector<std::pair<int, double>> ConfigParams(const AuditConfig& config)
+{
+  return {
+    {kParamMachine, static_cast<double>(config.machine)},
+    {kParamClipMode, static_cast<double>(config.clipMode)},
+    {kParamDriveGain, 0.7},
+    {kParamNoiseLevel, config.stages & kStageNoise ? 30.0 : 0.0},
+    {kParamResampleRatio, config.stages & kStageResampler ? 0.5 : 1.0},
+    {kParamWowAmount, config.stages & kStageWow ? 0.08 : 0.0},
+    {kParamFlutterAmount, config.stages & kStageWow ? 0.03 : 0.0},
+    {kParamTruePeak, config.stages & kStageTruePeak ? 1.0 : 0.0},
+    {kParamBands, config.stages & kStageMultiband ? 4.0 : 1.0},
+    {kParamAutoGain, config.stages & kStageAutoGain ? 1.0 : 0.0},
+    {kParamClipThreshold, 0.8},
+  };
+}
+
+// Every parameter to its minimum, maximum and default at evenly spread
+// frames, sorted by offset as the plug-in delivers them
+std::vector<TapeParamEvent> MakeSweepEvents(int blockSize)
+{
+  std::vector<TapeParamEvent> events;
+  const int numEvents = 3 * kNumParams;
+  for (int i = 0; i < numEvents; ++i)
+  {
+    const int paramIdx = i % kNumParams;
+    const TapeParamSpec& spec = GetTapeParamSpec(paramIdx);
+    const int pass = i / kNumParams;
+    const double value = pass == 0 ? spec.minValue : pass == 1 ? spec.maxValue : spec.defaultValue;
+    events.push_back({static_cast<int>(static_cast<int64_t>(i) * blockSize / numEvents), paramIdx, value});
+  }
+  return events;
+}
+
+struct AuditBuffers
+{
+  std::vector<std::vector<double>> in;
+  std::vector<std::vector<double>> out;
+  const double* inPtrs[2];
+  double* outPtrs[2];
+};
+
+// Hot enough to reach the clipper and the true-peak limiter
+void MakeBuffers(AuditBuffers& buffers, int blockSize)
+{
+  buffers.in.assign(2, std::vector<double>(static_cast<size_t>(blockSize)));
+  buffers.out.assign(2, std::vector<double>(static_cast<size_t>(blockSize)));
+  for (int c = 0; c < 2; ++c)
+  {
+    for (int s = 0; s < blockSize; ++s)
+      buffers.in[c][s] = 0.9 * std::sin(tapedsp::kTwoPi * (220.0 + 110.0 * c) * s / 48000.0);
+    buffers.inPtrs[c] = buffers.in[c].data();
+    buffers.outPtrs[c] = buffers.out[c].data();
+  }
+}
+
+void RenderBlocks(TapeSaturatorDSP& dsp, AuditBuffers& buffers, int blockSize, int numBlocks)
+{
+  for (int b = 0; b < numBlocks; ++b)
+    dsp.ProcessBlock(buffers.inPtrs, buffers.outPtrs, blockSize, 2);
+}
+
+// The audio-thread work for one configuration. Everything it touches was
+// built by the caller, outside the scope.
+void AuditConfigOnce(TapeSaturatorDSP& dsp, const AuditConfig& config, const std::vector<std::pair<int, double>>& params,
+                     const std::vector<TapeParamEvent>& sweep, AuditBuffers& buffers, const AuditSettings& settings,
+                     const std::string* labels)
+{
+  const int block = settings.blockSize;
+  rtaudit::Scope scope;
+
+  rtaudit::SetContext(labels[kPhaseAutomation].c_str());
+  dsp.SetQualityTier(config.tier);
+  for (const auto& p : params)
+    dsp.SetParam(p.first, p.second);
+  RenderBlocks(dsp, buffers, block, 8);
+
+  rtaudit::SetContext(labels[kPhaseEvents].c_str());
+  dsp.ProcessChannels(buffers.inPtrs, buffers.outPtrs, block, 0, 2, sweep.data(), static_cast<int>(sweep.size()));
+  for (const auto& p : params)
+    dsp.SetParam(p.first, p.second);
+  RenderBlocks(dsp, buffers, block, 4);
+
+  rtaudit::SetContext(labels[kPhaseChannels].c_str());
+  for (int b = 0; b < 4; ++b)
+  {
+    dsp.ProcessChannels(buffers.inPtrs, buffers.outPtrs, block, 0, 1);
+    dsp.ProcessChannels(buffers.inPtrs, buffers.outPtrs, block, 1, 2);
+  }
+
+  // The bypass ramp moves once per call, so one-frame calls reach the
+  // fully bypassed copy path quickly
+  rtaudit::SetContext(labels[kPhasePower].c_str());
+  dsp.SetParam(kParamPower, 0.0);
+  for (int call = 0; call < 600; ++call)
+    dsp.ProcessBlock(buffers.inPtrs, buffers.outPtrs, 1, 2);
+  RenderBlocks(dsp, buffers, block, 2);
+  dsp.SetParam(kParamPower, 1.0);
+  RenderBlocks(dsp, buffers, block, 4);
+
+  rtaudit::SetContext(labels[kPhaseLookahead].c_str());
+  dsp.SetParam(kParamTruePeakLookahead, 5.0);
+  RenderBlocks(dsp, buffers, block, 2);
+  dsp.SetParam(kParamTruePeakLookahead, 0.0);
+  RenderBlocks(dsp, buffers, block, 2);
+
+  rtaudit::SetContext(labels[kPhaseTiers].c_str());
+  for (int t = 0; t < kNumQualityTiers; ++t)
+  {
+    dsp.SetQualityTier((config.tier + 1 + t) % kNumQualityTiers);
+    RenderBlocks(dsp, buffers, block, 2);
+  }
+
+  rtaudit::SetContext(labels[kPhaseReset].c_str());
+  dsp.Reset(settings.sampleRate);
+  RenderBlocks(dsp, buffers, block, 2);
+  dsp.Reset(settings.sampleRate == 96000.0 ? 44100.0 : 96000.0);
+  RenderBlocks(dsp, buffers, block, 2);
+}
+
+// What the plug-in's audio thread adds while the editor is open. The ring
+// fills faster than the worker drains it, so the dropping path runs too.
+void AuditCapture(AuditBuffers& buffers, const AuditSettings& settings)
+{
+  auto ring = std::make_unique<CaptureRing>();
+  ring->Reset(settings.sampleRate);
+  SpectrumAnalyser analyser;
+  analyser.Start(*ring);
+  {
+    rtaudit::Scope scope;
+    rtaudit::SetContext("capture ring");
+    for (int b = 0; b < 2000; ++b)
+    {
+      ring->WriteInput(buffers.inPtrs, settings.blockSize, 2);
+      ring->WriteOutput(buffers.outPtrs, settings.blockSize, 2);
+      if (b == 1000)
+        ring->Reset(settings.sampleRate == 96000.0 ? 44100.0 : 96000.0);
+    }
+  }
+  analyser.Stop();
+}
+
+void PrintAuditUsage()
+{
+  std::fprintf(stderr, "usage: lofi-audit [--rate hz] [--block frames] [--max-stacks n]\n");
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+  AuditSettings settings;
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    if (arg == "--rate" && i + 1 < argc)
+      settings.sampleRate = std::clamp(std::atof(argv[++i]), 8000.0, 192000.0);
+    else if (arg == "--block" && i + 1 < argc)
+      settings.blockSize = std::clamp(std::atoi(argv[++i]), 1, 8192);
+    else if (arg == "--max-stacks" && i + 1 < argc)
+      settings.maxStacks = std::max(std::atoi(argv[++i]), 0);
+    else
+    {
+      PrintAuditUsage();
+      return 1;
+    }
+  }
+
+  if (!rtaudit::Available())
+  {
+    std::fprintf(stderr, "error: the realtime audit needs glibc on Linux\n");
+    return 2;
+  }
+  if (!rtaudit::Arm())
+  {
+    std::fprintf(stderr, "error: realtime audit self-check failed, interposed calls are not being seen\n");
+    return 2;
+  }
+
+  std::vector<AuditConfig> configs;
+  for (int machine = 0; machine < kNumMachines; ++machine)
+    for (int clipMode = 0; clipMode < kNumClipModes; ++clipMode)
+      for (int tier = 0; tier < kNumQualityTiers; ++tier)
+        for (int stages = 0; stages < kNumStageCombinations; ++stages)
+          configs.push_back({machine, clipMode, tier, stages});
+
+  // Site contexts point into labels, so it lives until the report is printed
+  std::vector<std::string> labels;
+  labels.reserve(configs.size() * kNumAuditPhases);
+  for (const AuditConfig& config : configs)
+  {
+    const std::string label = ConfigLabel(config);
+    for (const char* phase : kPhaseNames)
+      labels.push_back(label + ": " + phase);
+  }
+
+  const std::vector<TapeParamEvent> sweep = MakeSweepEvents(settings.blockSize);
+  AuditBuffers buffers;
+  MakeBuffers(buffers, settings.blockSize);
+
+  std::printf("auditing %zu configurations at %.0f Hz, block %d\n", configs.size(), settings.sampleRate, settings.blockSize);
+  for (size_t i = 0; i < configs.size(); ++i)
+  {
+    const std::vector<std::pair<int, double>> params = ConfigParams(configs[i]);
+    auto dsp = std::make_unique<TapeSaturatorDSP>();
+    dsp->ApplyDefaults();
+    dsp->SetDeterministic(true, static_cast<uint32_t>(i));
+    dsp->Reset(settings.sampleRate);
+    AuditConfigOnce(*dsp, configs[i], params, sweep, buffers, settings, labels.data() + i * kNumAuditPhases);
+  }
+  AuditCapture(buffers, settings);
+
+  const uint64_t total = rtaudit::GetTotalViolations();
+  std::printf("\n%-12s %12s\n", "violation", "count");
+  for (int k = 0; k < rtaudit::kNumViolationKinds; ++k)
+  {
+    const auto kind = static_cast<rtaudit::EViolation>(k);
+    std::printf("%-12s %12llu\n", rtaudit::GetKindName(kind), static_cast<unsigned long long>(rtaudit::GetViolationCount(kind)));
+  }
+
+  if (total == 0)
+  {
+    std::printf("\nno allocations, locks or blocking calls on the audio path\n");
+    return 0;
+  }
+
+  const size_t numSites = rtaudit::GetNumSites();
+  std::printf("\n%zu call sites", numSites);
+  if (rtaudit::GetDroppedSites() > 0)
+    std::printf(" (%llu more violations from sites not recorded)", static_cast<unsigned long long>(rtaudit::GetDroppedSites()));
+  std::printf("\n");
+  for (size_t i = 0; i < numSites && static_cast<int>(i) < settings.maxStacks; ++i)
+  {
+    const rtaudit::Site& site = rtaudit::GetSite(i);
+    std::printf("\n%s in %s, %llu times, first in %s\n%s", rtaudit::GetKindName(site.kind), site.function,
+                static_cast<unsigned long long>(site.count), site.context, rtaudit::FormatStack(site).c_str());
+  }
+  if (numSites > static_cast<size_t>(settings.maxStacks))
+    std::printf("\n%zu more sites not shown (--max-stacks)\n", numSites - static_cast<size_t>(settings.maxStacks));
+  return 1;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+// Sub-commands of lofi-render, each implemented in its own translation unit.
+// argv holds the arguments after the command name.
+
+int RunStreamCommand(int argc, char** argv);
+int RunBenchCommand(int argc, char** argv);
+int RunVerifyCommand(int argc, char** argv);
+int RunFuzzCommand(int argc, char** argv);
+int RunIdleSimCommand(int argc, char** argv);
@@ -0,0 +1,157 @@
+#pragma once
+
+// Streaming XXH64 for content-addressing renders. Feed it bytes in any
+// chunking; the digest only depends on the concatenated input.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+class ContentHash
+{
+public:
+  explicit ContentHash(uint64_t seed = 0)
+  {
+    mAcc[0] = seed + kPrime1 + kPrime2;
+    mAcc[1] = seed + kPrime2;
+    mAcc[2] = seed;
+    mAcc[3] = seed - kPrime1;
+    mSeed = seed;
+  }
+
+  void Update(const void* data, size_t size)
+  {
+    const auto* p = static_cast<const uint8_t*>(data);
+    mTotal += size;
+
+    if (mBufferUsed > 0)
+    {
+      const size_t fill = std::min(size, sizeof(mBuffer) - mBufferUsed);
+      std::memcpy(mBuffer + mBufferUsed, p, fill);
+      mBufferUsed += fill;
+      p += fill;
+      size -= fill;
+      if (mBufferUsed < sizeof(mBuffer))
+        return;
+      ConsumeStripe(mBuffer);
+      mBufferUsed = 0;
+    }
+
+    while (size >= sizeof(mBuffer))
+    {
+      ConsumeStripe(p);
+      p += sizeof(mBuffer);
+      size -= sizeof(mBuffer);
+    }
+
+    std::memcpy(mBuffer, p, size);
+    mBufferUsed = size;
+  }
+
+  template <typename T>
+  void UpdateValue(const T& value) { Update(&value, sizeof(T)); }
+
+  void UpdateString(const std::string& s)
+  {
+    UpdateValue(static_cast<uint64_t>(s.size()));
+    Update(s.data(), s.size());
+  }
+
+  uint64_t Digest() const
+  {
+    uint64_t h;
+    if (mTotal >= sizeof(mBuffer))
+    {
+      h = Rotl(mAcc[0], 1) + Rotl(mAcc[1], 7) + Rotl(mAcc[2], 12) + Rotl(mAcc[3], 18);
+      for (uint64_t acc : mAcc)
+        h = (h ^ Round(0, acc)) * kPrime1 + kPrime4;
+    }
+    else
+    {
+      h = mSeed + kPrime5;
+    }
+    h += mTotal;
+
+    const uint8_t* p = mBuffer;
+    size_t left = mBufferUsed;
+    while (left >= 8)
+    {
+      h ^= Round(0, Read64(p));
+      h = Rotl(h, 27) * kPrime1 + kPrime4;
+      p += 8;
+      left -= 8;
+    }
+    if (left >= 4)
+    {
+      h ^= static_cast<uint64_t>(Read32(p)) * kPrime1;
+      h = Rotl(h, 23) * kPrime2 + kPrime3;
+      p += 4;
+      left -= 4;
+    }
+    while (left > 0)
+    {
+      h ^= (*p) * kPrime5;
+      h = Rotl(h, 11) * kPrime1;
+      ++p;
+      --left;
+    }
+
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+  }
+
+  std::string HexDigest() const
+  {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(Digest()));
+    return text;
+  }
+
+private:
+  static constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+  static constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+  static constexpr uint64_t kPrime3 = 0x165667B19E3779F9ull;
+  static constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ull;
+  static constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ull;
+
+  static uint64_t Rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+  static uint64_t Round(uint64_t acc, uint64_t input)
+  {
+    acc += input * kPrime2;
+    acc = Rotl(acc, 31);
+    return acc * kPrime1;
+  }
+
+  static uint64_t Read64(const uint8_t* p)
+  {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+  }
+
+  static uint32_t Read32(const uint8_t* p)
+  {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+  }
+
+  void ConsumeStripe(const uint8_t* p)
+  {
+    for (int i = 0; i < 4; ++i)
+      mAcc[i] = Round(mAcc[i], Read64(p + 8 * i));
+  }
+
+  uint64_t mAcc[4];
+  uint64_t mSeed = 0;
+  uint64_t mTotal = 0;
+  uint8_t mBuffer[32];
+  size_t mBufferUsed = 0;
+};
@@ -0,0 +1,377 @@
+// lofi-render fuzz: robustness fuzzing of the DSP core.
+//
+//   lofi-render fuzz [--iterations n] [--seed n] [--block frames] [--verbose]
+//
+// Every iteration builds an instance with each parameter at its minimum,
+// maximum, default or a random value in range, at a random sample rate and
+// quality tier, and renders hostile input: full-scale squares, DC, white
+// noise, denormals, values up to 1e300 and blocks with NaN and Inf samples.
+// Blocks have random sizes and carry sample-accurate events, some of them NaN
+// or Inf (SetParam ignores those); channels are rendered together or one at
+// a time, with power toggles, tier switches and Resets at other rates mixed
+// in. A clean sine follows for half a second.
+//
+// An iteration fails if a block with finite input produces a NaN or Inf
+// sample (the bypass path may pass non-finite input straight through), or if
+// the NaN/Inf sentinel still fires during the second half of the clean tail,
+// i.e. the instance did not recover. The run is deterministic for a given
+// --seed; a failing iteration prints the seed that repeats it alone with
+// --iterations 1.
+//
+// Before the iterations a fixed check renders the same sine through two
+// instances, one of them with an Output change on the last frame of a block:
+// the gain between them has to ramp over a block length into the next
+// block, not jump on that frame. Exits 1 on any failure.
+
+#include "Commands.h"
+#include "TapeJob.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct FuzzSettings
+{
+  int iterations = 500;
+  uint32_t seed = 1;
+  int blockSize = 512;
+  bool verbose = false;
+};
+
+constexpr int kHostileBlocks = 48;
+constexpr double kCleanTailSec = 0.5;
+constexpr double kSampleRates[] = {22050.0, 44100.0, 48000.0, 96000.0, 192000.0};
+
+enum EFuzzInput
+{
+  kInputSilence = 0,
+  kInputSquare,
+  kInputDC,
+  kInputNoise,
+  kInputDenormal,
+  kInputHuge,
+  kInputNaN,
+  kInputInf,
+  kNumFuzzInputs
+};
+
+const char* kInputNames[kNumFuzzInputs] = {"silence", "square", "dc", "noise", "denormal", "huge", "nan", "inf"};
+
+using Rng = std::mt19937;
+
+double Uniform(Rng& rng, double lo, double hi)
+{
+  return std::uniform_real_distribution<double>(lo, hi)(rng);
+}
+
+bool Chance(Rng& rng, double p)
+{
+  return Uniform(rng, 0.0, 1.0) < p;
+}
+
+// Extremes and the default dominate; non-finite values only when allowed
+double FuzzParamValue(Rng& rng, int paramIdx, bool allowNonFinite)
+{
+  const TapeParamSpec& spec = GetTapeParamSpec(paramIdx);
+  const double pick = Uniform(rng, 0.0, 1.0);
+  if (allowNonFinite && pick < 0.1)
+  {
+    const double kNonFinite[] = {std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::infinity(),
+                                 -std::numeric_limits<double>::infinity()};
+    return kNonFinite[std::uniform_int_distribution<int>(0, 2)(rng)];
+  }
+  if (pick < 0.4)
+    return spec.minValue;
+  if (pick < 0.7)
+    return spec.maxValue;
+  if (pick < 0.8)
+    return spec.defaultValue;
+  return Uniform(rng, spec.minValue, spec.maxValue);
+}
+
+void FillInput(Rng& rng, EFuzzInput kind, double* data, int nFrames, int& phase)
+{
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const double inf = std::numeric_limits<double>::infinity();
+  const double level = Chance(rng, 0.5) ? 1.0 : -1.0;
+  for (int s = 0; s < nFrames; ++s, ++phase)
+  {
+    switch (kind)
+    {
+      case kInputSilence: data[s] = 0.0; break;
+      case kInputSquare: data[s] = (phase / 37) % 2 ? 1.0 : -1.0; break;
+      case kInputDC: data[s] = level; break;
+      case kInputNoise: data[s] = Uniform(rng, -1.0, 1.0); break;
+      case kInputDenormal: data[s] = (phase % 2 ? 1.0 : -1.0) * 1e-310; break;
+      case kInputHuge: data[s] = (phase % 2 ? 1.0 : -1.0) * std::pow(10.0, Uniform(rng, 3.0, 300.0)); break;
+      case kInputNaN: data[s] = Chance(rng, 0.05) ? nan : Uniform(rng, -1.0, 1.0); break;
+      case kInputInf: data[s] = Chance(rng, 0.05) ? (phase % 2 ? inf : -inf) : Uniform(rng, -1.0, 1.0); break;
+      default: data[s] = 0.0; break;
+    }
+  }
+}
+
+bool AllFinite(const std::vector<double>& data, int nFrames)
+{
+  return tapedsp::AllFinite(data.data(), nFrames);
+}
+
+struct FuzzBuffers
+{
+  std::vector<double> in[2];
+  std::vector<double> out[2];
+  const double* inPtrs[2];
+  double* outPtrs[2];
+};
+
+struct FuzzResult
+{
+  std::string failure;  // empty if the iteration passed
+  uint32_t sentinelEvents = 0;
+  int blocks = 0;
+};
+
+FuzzResult FuzzIteration(uint32_t seed, const FuzzSettings& settings, FuzzBuffers& buffers)
+{
+  Rng rng(seed);
+  FuzzResult result;
+  char message[256];
+
+  auto dsp = std::make_unique<TapeSaturatorDSP>();
+  dsp->ApplyDefaults();
+  dsp->SetDeterministic(true, seed);
+  for (int i = 0; i < kNumParams; ++i)
+    dsp->SetParam(i, FuzzParamValue(rng, i, true));
+  dsp->SetQualityTier(std::uniform_int_distribution<int>(0, kNumQualityTiers - 1)(rng));
+  double sampleRate = kSampleRates[std::uniform_int_distribution<size_t>(0, std::size(kSampleRates) - 1)(rng)];
+  dsp->Reset(sampleRate);
+
+  std::vector<TapeParamEvent> events;
+  int phase = 0;
+
+  auto check = [&](int nFrames, bool finiteInput, const char* what) {
+    ++result.blocks;
+    if (!finiteInput || !result.failure.empty())
+      return;
+    for (int c = 0; c < 2; ++c)
+    {
+      if (!AllFinite(buffers.out[c], nFrames))
+      {
+        std::snprintf(message, sizeof(message), "non-finite output on channel %d in block %d (%s, %.0f Hz)", c, result.blocks, what, sampleRate);
+        result.failure = message;
+        return;
+      }
+    }
+  };
+
+  // Hostile phase
+  for (int b = 0; b < kHostileBlocks; ++b)
+  {
+    const int nFrames = std::uniform_int_distribution<int>(1, settings.blockSize)(rng);
+    const auto kind = static_cast<EFuzzInput>(std::uniform_int_distribution<int>(0, kNumFuzzInputs - 1)(rng));
+    for (int c = 0; c < 2; ++c)
+      FillInput(rng, kind, buffers.in[c].data(), nFrames, phase);
+    const bool finiteInput = AllFinite(buffers.in[0], nFrames) && AllFinite(buffers.in[1], nFrames);
+
+    events.clear();
+    if (Chance(rng, 0.4))
+    {
+      const int numEvents = std::uniform_int_distribution<int>(1, 8)(rng);
+      for (int e = 0; e < numEvents; ++e)
+      {
+        const int paramIdx = std::uniform_int_distribution<int>(0, kNumParams - 1)(rng);
+        events.push_back({std::uniform_int_distribution<int>(0, nFrames)(rng), paramIdx, FuzzParamValue(rng, paramIdx, true)});
+      }
+      std::sort(events.begin(), events.end(), [](const TapeParamEvent& a, const TapeParamEvent& x) { return a.offset < x.offset; });
+    }
+
+    if (Chance(rng, 0.05))
+      dsp->SetParam(kParamPower, Chance(rng, 0.5) ? 0.0 : 1.0);
+    if (Chance(rng, 0.05))
+      dsp->SetQualityTier(std::uniform_int_distribution<int>(0, kNumQualityTiers - 1)(rng));
+    if (Chance(rng, 0.03))
+    {
+      sampleRate = kSampleRates[std::uniform_int_distribution<size_t>(0, std::size(kSampleRates) - 1)(rng)];
+      dsp->Reset(sampleRate);
+    }
+
+    const int numEvents = static_cast<int>(events.size());
+    if (Chance(rng, 0.2))
+    {
+      // One channel at a time, as the CLAP thread-pool path does
+      dsp->ProcessChannels(buffers.inPtrs, buffers.outPtrs, nFrames, 0, 1, events.data(), numEvents);
+      dsp->ProcessChannels(buffers.inPtrs, buffers.outPtrs, nFrames, 1, 2);
+    }
+    else
+    {
+      dsp->ProcessChannels(buffers.inPtrs, buffers.outPtrs, nFrames, 0, 2, events.data(), numEvents);
+    }
+    check(nFrames, finiteInput, kInputNames[kind]);
+    if (settings.verbose)
+      std::printf("  block %2d: %-8s %4d frames, %d events, sentinel %u\n", b, kInputNames[kind], nFrames, numEvents, dsp->GetNonFiniteEvents());
+  }
+
+  // Clean tail: the instance has to settle and stay settled
+  dsp->SetParam(kParamPower, 1.0);
+  const int tailBlocks = static_cast<int>(std::ceil(kCleanTailSec * sampleRate / settings.blockSize));
+  uint32_t eventsAtHalf = 0;
+  for (int b = 0; b < tailBlocks; ++b)
+  {
+    for (int c = 0; c < 2; ++c)
+    {
+      for (int s = 0; s < settings.blockSize; ++s, ++phase)
+        buffers.in[c][s] = 0.5 * std::sin(tapedsp::kTwoPi * 440.0 * phase / sampleRate);
+    }
+    dsp->ProcessBlock(buffers.inPtrs, buffers.outPtrs, settings.blockSize, 2);
+    check(settings.blockSize, true, "clean tail");
+    if (b == tailBlocks / 2)
+      eventsAtHalf = dsp->GetNonFiniteEvents();
+  }
+
+  result.sentinelEvents = dsp->GetNonFiniteEvents();
+  if (result.failure.empty() && result.sentinelEvents != eventsAtHalf)
+  {
+    std::snprintf(message, sizeof(message), "sentinel fired %u times on clean input after %.2f s (%.0f Hz)", result.sentinelEvents - eventsAtHalf,
+                  kCleanTailSec * 0.5, sampleRate);
+    result.failure = message;
+  }
+  return result;
+}
+
+// An event on the last frame of a block starts a ramp that carries on into
+// the following blocks at the block-rate pace. Output is applied last, so
+// with TruePeak and AutoGain off the two instances differ by exactly the
+// ramped gain. Returns an empty string if the check passed.
+std::string CheckLateEventRamp(int blockSize)
+{
+  constexpr double kSampleRate = 48000.0;
+  constexpr double kToDb = 12.0;
+  std::unique_ptr<TapeSaturatorDSP> dsp[2] = {std::make_unique<TapeSaturatorDSP>(), std::make_unique<TapeSaturatorDSP>()};
+  for (auto& d : dsp)
+  {
+    d->ApplyDefaults();
+    d->SetDeterministic(true, 1);
+    d->SetParam(kParamTruePeak, 0.0);
+    d->SetParam(kParamAutoGain, 0.0);
+    d->SetParam(kParamOutputGain, 0.0);
+    d->Reset(kSampleRate);
+  }
+
+  std::vector<double> in(static_cast<size_t>(blockSize));
+  std::vector<double> out[2] = {std::vector<double>(in.size()), std::vector<double>(in.size())};
+  const double* inPtrs[1] = {in.data()};
+  const TapeParamEvent late {blockSize - 1, kParamOutputGain, kToDb};
+  const double maxStep = 1.5 * (std::pow(10.0, kToDb / 20.0) - 1.0) / blockSize;
+  double lastRatio = 1.0;
+  int lastFrame = 0;
+  int phase = 0;
+  char message[256];
+  for (int b = 0; b < 4; ++b)
+  {
+    for (int s = 0; s < blockSize; ++s, ++phase)
+      in[s] = 0.5 * std::sin(tapedsp::kTwoPi * 440.0 * phase / kSampleRate);
+    for (int i = 0; i < 2; ++i)
+    {
+      double* outPtrs[1] = {out[i].data()};
+      dsp[i]->ProcessChannels(inPtrs, outPtrs, blockSize, 0, 1, &late, i == 1 && b == 1 ? 1 : 0);
+    }
+    for (int s = 0; s < blockSize; ++s)
+    {
+      // Frames near the zero crossings are skipped, the ramp moves on meanwhile
+      if (std::fabs(out[0][s]) < 0.01)
+        continue;
+      const int frame = b * blockSize + s;
+      const double ratio = out[1][s] / out[0][s];
+      if (std::fabs(ratio - lastRatio) > maxStep * (frame - lastFrame))
+      {
+        std::snprintf(message, sizeof(message), "Output event on the last frame jumps %.3f at frame %d of block %d (ramp step at most %.4f)",
+                      ratio - lastRatio, s, b, maxStep);
+        return message;
+      }
+      lastRatio = ratio;
+      lastFrame = frame;
+    }
+  }
+  if (std::fabs(lastRatio - std::pow(10.0, kToDb / 20.0)) > 1e-9)
+  {
+    std::snprintf(message, sizeof(message), "Output event on the last frame ends at gain %.6f", lastRatio);
+    return message;
+  }
+  return {};
+}
+
+void PrintFuzzUsage()
+{
+  std::fprintf(stderr, "usage: lofi-render fuzz [--iterations n] [--seed n] [--block frames] [--verbose]\n");
+}
+} // namespace
+
+int RunFuzzCommand(int argc, char** argv)
+{
+  FuzzSettings settings;
+  for (int i = 0; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    if (arg == "--iterations" && i + 1 < argc)
+      settings.iterations = std::max(std::atoi(argv[++i]), 1);
+    else if (arg == "--seed" && i + 1 < argc)
+      settings.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 0));
+    else if (arg == "--block" && i + 1 < argc)
+      settings.blockSize = std::clamp(std::atoi(argv[++i]), 1, 8192);
+    else if (arg == "--verbose")
+      settings.verbose = true;
+    else
+    {
+      PrintFuzzUsage();
+      return 1;
+    }
+  }
+
+  FuzzBuffers buffers;
+  for (int c = 0; c < 2; ++c)
+  {
+    buffers.in[c].assign(static_cast<size_t>(settings.blockSize), 0.0);
+    buffers.out[c].assign(static_cast<size_t>(settings.blockSize), 0.0);
+    buffers.inPtrs[c] = buffers.in[c].data();
+    buffers.outPtrs[c] = buffers.out[c].data();
+  }
+
+  std::printf("fuzzing %d iterations from seed %u, blocks up to %d frames\n", settings.iterations, settings.seed, settings.blockSize);
+  int failures = 0;
+  const std::string rampFailure = CheckLateEventRamp(std::max(settings.blockSize, 2));
+  if (!rampFailure.empty())
+  {
+    ++failures;
+    std::printf("FAIL late event ramp: %s\n", rampFailure.c_str());
+  }
+  int recovered = 0;
+  uint64_t blocks = 0, sentinelEvents = 0;
+  for (int i = 0; i < settings.iterations; ++i)
+  {
+    const uint32_t seed = settings.seed + static_cast<uint32_t>(i);
+    if (settings.verbose)
+      std::printf("iteration %d (seed %u)\n", i, seed);
+    const FuzzResult result = FuzzIteration(seed, settings, buffers);
+    blocks += static_cast<uint64_t>(result.blocks);
+    sentinelEvents += result.sentinelEvents;
+    recovered += result.sentinelEvents > 0 ? 1 : 0;
+    if (!result.failure.empty())
+    {
+      ++failures;
+      std::printf("FAIL iteration %d (--seed %u): %s\n", i, seed, result.failure.c_str());
+    }
+  }
+
+  std::printf("%llu blocks, %llu sentinel recoveries in %d iterations\n", static_cast<unsigned long long>(blocks),
+              static_cast<unsigned long long>(sentinelEvents), recovered);
+  std::printf("%d of %d iterations failed\n", failures, settings.iterations);
+  return failures > 0 ? 1 : 0;
+}
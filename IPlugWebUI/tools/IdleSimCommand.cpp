@@ -0,0 +1,495 @@
+// lofi-render idle-sim: UI-thread work of many plug-in instances in OnIdle.
+//
+//   lofi-render idle-sim [--instances n] [--ticks n] [--seed n]
+//
+// Opens the editor of n instances and ticks their OnIdle against a mock
+// editor that stands in for the web view: it counts every script and Resize,
+// answers size queries on the next tick, and posts the page's resize
+// message when its window changes size. One instance in four comes up at
+// 25% and ignores its first Resize, as FL Studio does, so the size
+// verification has something to correct. Halfway through, the host resizes
+// the window of one instance in five behind the plug-in's back. Each tick
+// the simulated audio thread queues the drive VU and the loudness readings,
+// and the analyser delivers a spectrum every third tick (20 a second at 60
+// ticks a second); with the transport stopped the values stay the same.
+//
+// Two versions of OnIdle run the same scenario:
+//  - static: the one before IdleScheduler, with the applyScale and size
+//    verification counters in function-local statics shared by every
+//    instance, and one script per reading whenever it was queued
+//  - scheduled: the plug-in's OnIdle, running the same EditorIdleJobs
+//    (EditorIdleJobs.h) the plug-in runs
+//
+// Reported per tick over all instances: scripts, script kilobytes, wall
+// time of the ticks (script formatting included, the mock only copies), the
+// most scripts in one tick, the spread of applyScale calls and size queries
+// per instance, and how many drifted windows were laid out again. Exits 1
+// if a scheduled instance runs a job more often than its interval allows,
+// queries the size more than kMaxSizeVerifyAttempts times while verifying,
+// or leaves a drifted window unscaled.
+
+#include "Commands.h"
+
+#include "EditorIdleJobs.h"
+#include "SpectrumAnalyser.h"
+#include "TapeSaturatorDSP.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+// PLUG_WIDTH and PLUG_HEIGHT in config.h
+constexpr int kEditorWidth = 250;
+constexpr int kEditorHeight = 350;
+
+struct SimSettings
+{
+  int instances = 100;
+  int ticks = 3600;  // a minute at 60 ticks a second
+  uint32_t seed = 1;
+};
+
+class MockEditor
+{
+public:
+  using Reply = std::function<void(const char*)>;
+
+  explicit MockEditor(bool flStudio)
+  : mWidth(flStudio ? kEditorWidth / 4 : kEditorWidth)
+  , mHeight(flStudio ? kEditorHeight / 4 : kEditorHeight)
+  , mIgnoredResizes(flStudio ? 1 : 0)
+  {
+  }
+
+  void EvaluateJavaScript(const char* script, Reply reply = nullptr)
+  {
+    mScript = script;  // marshalling to the web view
+    ++mScripts;
+    mBytes += mScript.size();
+    if (std::strcmp(script, kApplyScaleScript) == 0)
+    {
+      ++mApplyScales;
+      mScaledSize = {mWidth, mHeight};
+    }
+    else if (std::strcmp(script, kSizeQueryScript) == 0)
+    {
+      ++mSizeQueries;
+    }
+    if (reply)
+      mReplies.push_back(std::move(reply));
+  }
+
+  // The host changes the window without telling the plug-in
+  void Drift(int width, int height)
+  {
+    SetSize(width, height);
+    mDrifted = true;
+  }
+
+  void Resize(int width, int height)
+  {
+    ++mResizes;
+    if (mIgnoredResizes > 0)
+    {
+      --mIgnoredResizes;
+      return;
+    }
+    SetSize(width, height);
+  }
+
+  // The plug-in sets its DriveVU display parameter here
+  void OnMetersSent(unsigned) {}
+
+  // The page's resize message since the last call
+  bool TakePageResized() { return std::exchange(mPageResized, false); }
+
+  // Answers last tick's size queries
+  void DeliverReplies()
+  {
+    std::vector<Reply> replies;
+    replies.swap(mReplies);
+    char json[64];
+    std::snprintf(json, sizeof(json), "{\"w\":%d,\"h\":%d}", mWidth, mHeight);
+    for (Reply& reply : replies)
+      reply(json);
+  }
+
+  uint64_t GetScripts() const { return mScripts; }
+  uint64_t GetBytes() const { return mBytes; }
+  uint64_t GetResizes() const { return mResizes; }
+  uint64_t GetApplyScales() const { return mApplyScales; }
+  uint64_t GetSizeQueries() const { return mSizeQueries; }
+  bool Drifted() const { return mDrifted; }
+  // The page is laid out for the window it is in
+  bool Scaled() const { return mScaledSize == std::array<int, 2> {mWidth, mHeight}; }
+
+private:
+  void SetSize(int width, int height)
+  {
+    mPageResized = mPageResized || width != mWidth || height != mHeight;
+    mWidth = width;
+    mHeight = height;
+  }
+
+  int mWidth;
+  int mHeight;
+  int mIgnoredResizes;
+  bool mDrifted = false;
+  bool mPageResized = false;
+  std::array<int, 2> mScaledSize {};
+  std::string mScript;
+  std::vector<Reply> mReplies;
+  uint64_t mScripts = 0;
+  uint64_t mBytes = 0;
+  uint64_t mResizes = 0;
+  uint64_t mApplyScales = 0;
+  uint64_t mSizeQueries = 0;
+};
+
+bool SizeMatches(const char* json)
+{
+  double w = 0.0, h = 0.0;
+  return ParseEditorSize(json, w, h) && SameEditorSize(w, h, kEditorWidth, kEditorHeight);
+}
+
+// What the audio thread and the analyser leave for OnIdle
+struct AudioReadings
+{
+  bool driveVUQueued = false;
+  float driveVU = 0.0f;
+  bool loudnessQueued = false;
+  std::array<float, kNumLoudnessReadings> loudness {};
+  bool spectrumReady = false;
+  SpectrumAnalyser::Snapshot spectrum;
+};
+
+void AdvanceAudio(AudioReadings& audio, std::mt19937& rng, int64_t tick, bool playing)
+{
+  std::uniform_real_distribution<float> jitter(-3.0f, 3.0f);
+  audio.driveVUQueued = true;
+  audio.driveVU = playing ? 0.5f + 0.1f * jitter(rng) : 0.0f;
+  audio.loudnessQueued = true;
+  for (float& value : audio.loudness)
+    value = playing ? -14.0f + jitter(rng) : static_cast<float>(LoudnessMeter::kFloorLUFS);
+  if (tick % 3 != 0)
+    return;
+  audio.spectrumReady = true;
+  for (int band = 0; band < SpectrumAnalyser::kNumBands; ++band)
+  {
+    audio.spectrum.input[band] = playing ? -40.0f + 10.0f * jitter(rng) : static_cast<float>(SpectrumAnalyser::kFloorDb);
+    audio.spectrum.output[band] = playing ? -36.0f + 10.0f * jitter(rng) : static_cast<float>(SpectrumAnalyser::kFloorDb);
+  }
+}
+
+// The function-local statics of the old OnIdle, shared by every instance
+struct StaticCounters
+{
+  int scale = 0;
+  int verify = 0;
+};
+
+// OnIdle before IdleScheduler
+class StaticInstance
+{
+public:
+  void Open(MockEditor& editor, AudioReadings& audio)
+  {
+    audio.driveVUQueued = true;
+    mQualityTierUIPending = true;
+    mNonFiniteUIPending = true;
+    editor.Resize(kEditorWidth, kEditorHeight);
+    mVerifySizePending = true;
+    mVerifyAttempts = 0;
+  }
+
+  void Idle(MockEditor& editor, AudioReadings& audio, StaticCounters& counters)
+  {
+    if ((++counters.scale % 60) == 0)
+      editor.EvaluateJavaScript(kApplyScaleScript);
+
+    if (mVerifySizePending)
+    {
+      if ((++counters.verify % 30) == 0 && mVerifyAttempts < kMaxSizeVerifyAttempts)
+      {
+        ++mVerifyAttempts;
+        editor.EvaluateJavaScript(kSizeQueryScript, [this, &editor](const char* json) {
+          if (SizeMatches(json))
+            mVerifySizePending = false;
+          else
+            editor.Resize(kEditorWidth, kEditorHeight);
+        });
+        if (mVerifyAttempts >= kMaxSizeVerifyAttempts)
+          mVerifySizePending = false;
+      }
+    }
+
+    // One script per reading, formatted like the plug-in's
+    auto send = [&](EMeterReadings reading) {
+      mReadings.Format(reading, mScript);
+      editor.EvaluateJavaScript(mScript.c_str());
+    };
+    if (mQualityTierUIPending)
+    {
+      mQualityTierUIPending = false;
+      send(kMeterQualityTier);
+    }
+    if (mNonFiniteUIPending)
+    {
+      mNonFiniteUIPending = false;
+      send(kMeterNonFinite);
+    }
+    if (audio.loudnessQueued)
+    {
+      audio.loudnessQueued = false;
+      mReadings.SetLoudness(audio.loudness);
+      send(kMeterLoudness);
+    }
+    if (audio.spectrumReady)
+    {
+      audio.spectrumReady = false;
+      mReadings.SetSpectrum(audio.spectrum);
+      send(kMeterSpectrum);
+    }
+    if (audio.driveVUQueued)
+    {
+      audio.driveVUQueued = false;
+      mReadings.SetDriveVU(audio.driveVU);
+      send(kMeterDriveVU);
+    }
+  }
+
+private:
+  EditorMeters mReadings;  // formatting only
+  std::string mScript;
+  bool mVerifySizePending = false;
+  int mVerifyAttempts = 0;
+  bool mQualityTierUIPending = false;
+  bool mNonFiniteUIPending = false;
+};
+
+// OnUIOpen and OnIdle of the plug-in: the same EditorIdleJobs, fed the
+// readings and the page's resize message as the plug-in feeds them
+class ScheduledInstance
+{
+public:
+  void Open(MockEditor& editor, AudioReadings& audio)
+  {
+    mEditorJobs.Open(editor);
+    mEditorJobs.GetMeters().SetQualityTier(0);
+    mEditorJobs.GetMeters().SetNonFiniteEvents(0);
+    audio.driveVUQueued = true;
+    audio.loudnessQueued = true;
+  }
+
+  void Idle(MockEditor& editor, AudioReadings& audio)
+  {
+    // OnMessage, between two OnIdle calls
+    if (editor.TakePageResized())
+      mEditorJobs.OnPageResized();
+
+    EditorMeters& meters = mEditorJobs.GetMeters();
+    if (audio.spectrumReady)
+    {
+      audio.spectrumReady = false;
+      meters.SetSpectrum(audio.spectrum);
+    }
+    if (audio.loudnessQueued)
+    {
+      audio.loudnessQueued = false;
+      meters.SetLoudness(audio.loudness);
+    }
+    if (audio.driveVUQueued)
+    {
+      audio.driveVUQueued = false;
+      meters.SetDriveVU(audio.driveVU);
+    }
+
+    mEditorJobs.Tick(editor);
+  }
+
+  const IdleScheduler& GetScheduler() const { return mEditorJobs.GetScheduler(); }
+
+private:
+  EditorIdleJobs<MockEditor> mEditorJobs {kEditorWidth, kEditorHeight};
+};
+
+struct SimResult
+{
+  uint64_t scripts = 0;
+  uint64_t bytes = 0;
+  uint64_t resizes = 0;
+  uint64_t maxScriptsPerTick = 0;
+  uint64_t minApplyScales = UINT64_MAX;
+  uint64_t maxApplyScales = 0;
+  uint64_t minSizeQueries = UINT64_MAX;
+  uint64_t maxSizeQueries = 0;
+  int drifted = 0;
+  int rescaled = 0;  // drifted windows laid out again by the end
+  double seconds = 0.0;
+  int failures = 0;
+};
+
+template <typename Instance, typename IdleFn, typename CheckFn>
+SimResult RunScenario(const SimSettings& settings, bool playing, IdleFn idle, CheckFn check)
+{
+  std::vector<MockEditor> editors;
+  std::vector<Instance> instances(static_cast<size_t>(settings.instances));
+  std::vector<AudioReadings> audio(instances.size());
+  editors.reserve(instances.size());
+  for (int i = 0; i < settings.instances; ++i)
+    editors.emplace_back(i % 4 == 3);
+
+  std::mt19937 rng(settings.seed);
+  SimResult result;
+  for (size_t i = 0; i < instances.size(); ++i)
+    instances[i].Open(editors[i], audio[i]);
+
+  for (int64_t tick = 1; tick <= settings.ticks; ++tick)
+  {
+    for (size_t i = 0; i < instances.size(); ++i)
+      AdvanceAudio(audio[i], rng, tick, playing);
+
+    if (tick == settings.ticks / 2)
+    {
+      for (size_t i = 2; i < editors.size(); i += 5)
+        editors[i].Drift(kEditorWidth * 3 / 2, kEditorHeight * 3 / 2);
+    }
+
+    uint64_t scriptsBefore = 0;
+    for (const MockEditor& editor : editors)
+      scriptsBefore += editor.GetScripts();
+
+    // The host calls OnIdle of every instance on its UI thread
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < instances.size(); ++i)
+    {
+      editors[i].DeliverReplies();
+      idle(instances[i], editors[i], audio[i]);
+    }
+    result.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t scriptsAfter = 0;
+    for (const MockEditor& editor : editors)
+      scriptsAfter += editor.GetScripts();
+    result.maxScriptsPerTick = std::max(result.maxScriptsPerTick, scriptsAfter - scriptsBefore);
+  }
+
+  for (const MockEditor& editor : editors)
+  {
+    result.scripts += editor.GetScripts();
+    result.bytes += editor.GetBytes();
+    result.resizes += editor.GetResizes();
+    result.minApplyScales = std::min(result.minApplyScales, editor.GetApplyScales());
+    result.maxApplyScales = std::max(result.maxApplyScales, editor.GetApplyScales());
+    result.minSizeQueries = std::min(result.minSizeQueries, editor.GetSizeQueries());
+    result.maxSizeQueries = std::max(result.maxSizeQueries, editor.GetSizeQueries());
+    result.drifted += editor.Drifted() ? 1 : 0;
+    result.rescaled += editor.Drifted() && editor.Scaled() ? 1 : 0;
+  }
+  result.failures = check(instances, editors);
+  return result;
+}
+
+// A scheduled instance may run each job at most once per interval and query
+// the size at most kMaxSizeVerifyAttempts times while verifying it. A
+// drifted window has to be laid out again when the size watch had time to
+// see it: two of its intervals.
+int CheckScheduled(const std::vector<ScheduledInstance>& instances, const std::vector<MockEditor>& editors, const SimSettings& settings)
+{
+  const bool watched = settings.ticks - settings.ticks / 2 >= 2 * kIdleJobIntervals[kIdleJobWatchSize];
+  int failures = 0;
+  for (size_t i = 0; i < instances.size(); ++i)
+  {
+    for (int job = 0; job < kNumIdleJobs; ++job)
+    {
+      const uint64_t allowed = static_cast<uint64_t>(settings.ticks / kIdleJobIntervals[job] + 1);
+      const uint64_t runs = instances[i].GetScheduler().GetRuns(job);
+      if (runs > allowed || (job == kIdleJobVerifySize && runs > kMaxSizeVerifyAttempts))
+      {
+        std::printf("FAIL instance %zu ran job %d %llu times\n", i, job, static_cast<unsigned long long>(runs));
+        ++failures;
+      }
+    }
+    if (watched && editors[i].Drifted() && !editors[i].Scaled())
+    {
+      std::printf("FAIL instance %zu did not lay out its drifted window again\n", i);
+      ++failures;
+    }
+  }
+  return failures;
+}
+
+void PrintResult(const char* model, const char* transport, const SimResult& r, const SimSettings& settings)
+{
+  const double ticks = static_cast<double>(settings.ticks);
+  std::printf("%-10s %-9s %12.2f %10.2f %10llu %8.1f %12.2f   %4llu..%-4llu %5llu..%-5llu %5d/%-5d\n", model, transport, r.scripts / ticks,
+              r.bytes / ticks / 1024.0, static_cast<unsigned long long>(r.maxScriptsPerTick), r.seconds / ticks * 1e6,
+              static_cast<double>(r.resizes) / settings.instances, static_cast<unsigned long long>(r.minApplyScales),
+              static_cast<unsigned long long>(r.maxApplyScales), static_cast<unsigned long long>(r.minSizeQueries),
+              static_cast<unsigned long long>(r.maxSizeQueries), r.rescaled, r.drifted);
+}
+
+void PrintIdleSimUsage()
+{
+  std::fprintf(stderr, "usage: lofi-render idle-sim [--instances n] [--ticks n] [--seed n]\n");
+}
+} // namespace
+
+int RunIdleSimCommand(int argc, char** argv)
+{
+  SimSettings settings;
+  for (int i = 0; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    if (arg == "--instances" && i + 1 < argc)
+      settings.instances = std::clamp(std::atoi(argv[++i]), 1, 10000);
+    else if (arg == "--ticks" && i + 1 < argc)
+      settings.ticks = std::clamp(std::atoi(argv[++i]), 1, 10000000);
+    else if (arg == "--seed" && i + 1 < argc)
+      settings.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 0));
+    else
+    {
+      PrintIdleSimUsage();
+      return 1;
+    }
+  }
+
+  std::printf("%d instances with the editor open, %d idle ticks\n\n", settings.instances, settings.ticks);
+  std::printf("%-10s %-9s %12s %10s %10s %8s %12s   %10s %12s %11s\n", "model", "transport", "scripts/tick", "KB/tick", "max/tick",
+              "us/tick", "resizes/inst", "applyScale", "size queries", "re-scaled");
+
+  int failures = 0;
+  for (const bool playing : {true, false})
+  {
+    const char* transport = playing ? "playing" : "stopped";
+
+    StaticCounters counters;
+    const SimResult legacy = RunScenario<StaticInstance>(
+      settings, playing, [&](StaticInstance& instance, MockEditor& editor, AudioReadings& audio) { instance.Idle(editor, audio, counters); },
+      [](const std::vector<StaticInstance>&, const std::vector<MockEditor>&) { return 0; });
+    PrintResult("static", transport, legacy, settings);
+
+    const SimResult current = RunScenario<ScheduledInstance>(
+      settings, playing, [](ScheduledInstance& instance, MockEditor& editor, AudioReadings& audio) { instance.Idle(editor, audio); },
+      [&](const std::vector<ScheduledInstance>& instances, const std::vector<MockEditor>& editors) {
+        return CheckScheduled(instances, editors, settings);
+      });
+    PrintResult("scheduled", transport, current, settings);
+    failures += current.failures;
+  }
+
+  std::printf("\napplyScale and size queries are per instance, min..max over the instances;\n"
+              "re-scaled counts the windows the host resized halfway that were laid out again\n");
+  return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,351 @@
+// lofi-render: offline batch renderer built on the TapeSaturatorDSP core.
+//
+//   lofi-render [options] <jobs.txt>
+//   lofi-render [options] <in.wav> <out.wav> [Param=value ...]
+//   lofi-render stream ...   (see StreamRender.cpp)
+//   lofi-render bench ...    (see BenchCommand.cpp)
+//   lofi-render verify ...   (see VerifyCommand.cpp)
+//   lofi-render fuzz ...     (see FuzzCommand.cpp)
+//   lofi-render idle-sim ... (see IdleSimCommand.cpp)
+//
+// The realtime audit is the separate lofi-audit program (AuditCommand.cpp),
+// since it interposes on libc for the whole process.
+// A job file holds one job per line: input path, output path, then any number
+// of Param=value assignments using the plug-in parameter names (DriveGain,
+// ClipMode=Soft, NoiseLevel=20, ...). Lines starting with '#' are ignored and
+// paths containing spaces can be double-quoted. Both paths must be WAV files
+// (see WavFile.h); FLAC is not supported.
+//
+// Options:
+//   -j, --threads N   worker threads (default: all cores)
+//   --block N         processing block size in frames (default 512)
+//   --seed N          noise seed for jobs without a Seed=N token (default 0)
+//   --cache DIR       serve unchanged renders from a content-addressed cache
+//   --cache-max-mb N  evict least recently used cache entries above N MB
+//
+// Renders are deterministic: the same input, parameters, seed, block size and
+// plug-in version always give the same output, which is what the cache keys on.
+//
+// Build (no iPlug2 needed; builds lofi-audit as well):
+//   cmake -S IPlugWebUI -B build-linux -DCMAKE_BUILD_TYPE=Release
+//   cmake --build build-linux -j
+
+#include "Commands.h"
+#include "ContentHash.h"
+#include "RenderCache.h"
+#include "TapeJob.h"
+#include "WavFile.h"
+#include "WorkStealingPool.h"
+#include "config.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+struct RenderSettings
+{
+  int numThreads = 0;
+  int blockSize = 512;
+  uint32_t seed = 0;
+  std::string cacheDir;
+  uint64_t cacheMaxBytes = 0;
+};
+
+// Per-file state shared by that file's channel tasks only
+struct JobState
+{
+  JobSpec spec;
+  WavAudio input;
+  WavAudio output;
+  std::atomic<int> channelsLeft {0};
+  std::string cacheKey;
+  double renderSeconds = 0.0;
+  std::mutex timingMutex;
+};
+
+struct BatchStats
+{
+  std::atomic<int> filesDone {0};
+  std::atomic<int> filesFailed {0};
+  std::mutex logMutex;
+  double audioSeconds = 0.0; // guarded by logMutex
+  RenderCache cache;
+};
+
+// Everything that determines the rendered bytes
+std::string MakeRenderKey(const JobState& job, const RenderSettings& settings)
+{
+  ContentHash hash;
+  hash.UpdateString(PLUG_VERSION_STR);
+  hash.UpdateValue(TapeSaturatorDSP::kRenderVersion);
+  hash.UpdateValue(settings.blockSize);
+  hash.UpdateValue(job.spec.seed);
+  const auto params = ResolveParams(job.spec);
+  hash.Update(params.data(), params.size() * sizeof(double));
+
+  const WavFormat& fmt = job.input.format;
+  hash.UpdateValue(fmt.numChannels);
+  hash.UpdateValue(fmt.sampleRate);
+  hash.UpdateValue(fmt.bitsPerSample);
+  hash.UpdateValue(fmt.isFloat);
+  for (const auto& channel : job.input.channels)
+    hash.Update(channel.data(), channel.size() * sizeof(double));
+  return hash.HexDigest();
+}
+
+// Renders one channel of a job with its own DSP instance
+void RenderChannel(JobState& job, int channel, const RenderSettings& settings)
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  auto dsp = std::make_unique<TapeSaturatorDSP>();
+  PrepareDSP(*dsp, job.spec, job.input.format.sampleRate);
+
+  // The core is stereo: files with more channels are processed in pairs
+  const int slot = channel % TapeSaturatorDSP::kMaxChannels;
+  const double* in[TapeSaturatorDSP::kMaxChannels] = {};
+  double* out[TapeSaturatorDSP::kMaxChannels] = {};
+
+  // Output is shifted back by the DSP latency (true-peak lookahead): the first
+  // `latency` rendered frames are dropped and the tail is flushed with silence
+  const int64_t latency = dsp->GetLatencySamples();
+  const int64_t numFrames = job.input.NumFrames();
+  std::vector<double> scratch(latency > 0 ? settings.blockSize : 0);
+  const double* source = job.input.channels[channel].data();
+  double* dest = job.output.channels[channel].data();
+
+  for (int64_t pos = 0; pos < numFrames + latency; pos += settings.blockSize)
+  {
+    const int n = static_cast<int>(std::min<int64_t>(settings.blockSize, numFrames + latency - pos));
+    if (latency == 0)
+    {
+      in[slot] = source + pos;
+      out[slot] = dest + pos;
+      dsp->ProcessChannels(in, out, n, slot, slot + 1);
+      continue;
+    }
+
+    const int available = static_cast<int>(std::clamp<int64_t>(numFrames - pos, 0, n));
+    std::copy(source + pos, source + pos + available, scratch.begin());
+    std::fill(scratch.begin() + available, scratch.begin() + n, 0.0);
+    in[slot] = scratch.data();
+    out[slot] = scratch.data();
+    dsp->ProcessChannels(in, out, n, slot, slot + 1);
+
+    const int64_t skip = std::clamp<int64_t>(latency - pos, 0, n);
+    std::copy(scratch.begin() + skip, scratch.begin() + n, dest + (pos + skip - latency));
+  }
+
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::lock_guard<std::mutex> lock(job.timingMutex);
+  job.renderSeconds += seconds;
+}
+
+void FinishJob(JobState& job, BatchStats& stats)
+{
+  std::string error;
+  const bool ok = WriteWav(job.spec.outputPath, job.output, error);
+
+  std::lock_guard<std::mutex> lock(stats.logMutex);
+  if (!ok)
+  {
+    stats.filesFailed.fetch_add(1);
+    std::fprintf(stderr, "error: %s\n", error.c_str());
+    return;
+  }
+
+  if (stats.cache.IsOpen())
+    stats.cache.Store(job.cacheKey, job.spec.outputPath);
+
+  const double duration = static_cast<double>(job.input.NumFrames()) / job.input.format.sampleRate;
+  stats.filesDone.fetch_add(1);
+  stats.audioSeconds += duration;
+  std::printf("done  %s (%d ch, %.1f s audio, %.3f s cpu)\n", job.spec.outputPath.c_str(), job.input.format.numChannels, duration, job.renderSeconds);
+}
+
+// Decode, then fan out one task per channel; the last channel to finish encodes
+void StartJob(WorkStealingPool& pool, std::shared_ptr<JobState> job, BatchStats& stats, const RenderSettings& settings)
+{
+  std::string error;
+  if (ReadWav(job->spec.inputPath, job->input, error))
+  {
+    job->output.format = job->input.format;
+    job->output.channels.assign(job->input.format.numChannels, std::vector<double>(static_cast<size_t>(job->input.NumFrames())));
+    error.clear();
+  }
+
+  if (!error.empty())
+  {
+    std::lock_guard<std::mutex> lock(stats.logMutex);
+    stats.filesFailed.fetch_add(1);
+    std::fprintf(stderr, "error: %s\n", error.c_str());
+    return;
+  }
+
+  if (stats.cache.IsOpen())
+  {
+    job->cacheKey = MakeRenderKey(*job, settings);
+    if (stats.cache.Fetch(job->cacheKey, job->spec.outputPath))
+    {
+      std::lock_guard<std::mutex> lock(stats.logMutex);
+      stats.filesDone.fetch_add(1);
+      std::printf("cache %s\n", job->spec.outputPath.c_str());
+      return;
+    }
+  }
+
+  const int numChannels = job->input.format.numChannels;
+  job->channelsLeft.store(numChannels);
+  for (int c = 0; c < numChannels; ++c)
+  {
+    pool.Submit([job, c, &stats, &settings]() {
+      RenderChannel(*job, c, settings);
+      if (job->channelsLeft.fetch_sub(1) == 1)
+        FinishJob(*job, stats);
+    });
+  }
+}
+
+void PrintUsage()
+{
+  std::fprintf(stderr,
+    "usage: lofi-render [-j threads] [--block frames] [--seed n] [--cache dir [--cache-max-mb n]] <jobs.txt>\n"
+    "       lofi-render [options] <in.wav> <out.wav> [Param=value ... Seed=n]\n"
+    "       lofi-render stream [options] <in.wav> <out.wav> [Param=value ...]\n"
+    "       lofi-render bench [--seconds s] [--block frames] [--rate hz] [--runs n] [--tier t] [--machine m]\n"
+    "       lofi-render bench --instances n [--rate hz] [--runs n] [--machine m]\n"
+    "       lofi-render verify [--record] <dir> [options]\n"
+    "       lofi-render fuzz [--iterations n] [--seed n] [--block frames] [--verbose]\n"
+    "       lofi-render idle-sim [--instances n] [--ticks n] [--seed n]\n"
+    "parameters:");
+  for (int i = 0; i < kNumParams; ++i)
+  {
+    if (IsJobParam(i))
+      std::fprintf(stderr, " %s", GetTapeParamSpec(i).name);
+  }
+  std::fprintf(stderr, "\n");
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+  if (argc > 1 && std::string(argv[1]) == "stream")
+    return RunStreamCommand(argc - 2, argv + 2);
+  if (argc > 1 && std::string(argv[1]) == "bench")
+    return RunBenchCommand(argc - 2, argv + 2);
+  if (argc > 1 && std::string(argv[1]) == "verify")
+    return RunVerifyCommand(argc - 2, argv + 2);
+  if (argc > 1 && std::string(argv[1]) == "audit")
+  {
+    std::fprintf(stderr, "error: the realtime audit is a separate program, run lofi-audit\n");
+    return 1;
+  }
+  if (argc > 1 && std::string(argv[1]) == "fuzz")
+    return RunFuzzCommand(argc - 2, argv + 2);
+  if (argc > 1 && std::string(argv[1]) == "idle-sim")
+    return RunIdleSimCommand(argc - 2, argv + 2);
+
+  RenderSettings settings;
+  std::vector<std::string> positional;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    if ((arg == "-j" || arg == "--threads") && i + 1 < argc)
+      settings.numThreads = std::atoi(argv[++i]);
+    else if (arg == "--block" && i + 1 < argc)
+      settings.blockSize = std::clamp(std::atoi(argv[++i]), 1, 65536);
+    else if (arg == "--seed" && i + 1 < argc)
+      settings.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 0));
+    else if (arg == "--cache" && i + 1 < argc)
+      settings.cacheDir = argv[++i];
+    else if (arg == "--cache-max-mb" && i + 1 < argc)
+      settings.cacheMaxBytes = static_cast<uint64_t>(std::max(0.0, std::atof(argv[++i])) * 1024.0 * 1024.0);
+    else if (arg == "-h" || arg == "--help")
+    {
+      PrintUsage();
+      return 0;
+    }
+    else
+      positional.push_back(arg);
+  }
+
+  std::vector<JobSpec> jobs;
+  if (positional.size() == 1)
+  {
+    if (!LoadJobFile(positional[0], jobs))
+      return 1;
+  }
+  else if (positional.size() >= 2)
+  {
+    JobSpec job;
+    std::string error;
+    if (!ParseJob(positional, job, error))
+    {
+      std::fprintf(stderr, "error: %s\n", error.c_str());
+      return 1;
+    }
+    jobs.push_back(std::move(job));
+  }
+  else
+  {
+    PrintUsage();
+    return 1;
+  }
+
+  for (auto& job : jobs)
+  {
+    if (!job.hasSeed)
+      job.seed = settings.seed;
+  }
+
+  if (settings.numThreads <= 0)
+    settings.numThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+  BatchStats stats;
+  if (!settings.cacheDir.empty() && !stats.cache.Open(settings.cacheDir, settings.cacheMaxBytes))
+  {
+    std::fprintf(stderr, "error: cannot use cache directory %s\n", settings.cacheDir.c_str());
+    return 1;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  {
+    WorkStealingPool pool(settings.numThreads);
+    for (auto& spec : jobs)
+    {
+      auto job = std::make_shared<JobState>();
+      job->spec = std::move(spec);
+      pool.Submit([&pool, job, &stats, &settings]() { StartJob(pool, job, stats, settings); });
+    }
+    pool.Wait();
+    std::printf("steals: %llu\n", static_cast<unsigned long long>(pool.GetStealCount()));
+  }
+  const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  const int done = stats.filesDone.load();
+  std::printf("%d file(s) rendered, %d failed, %d thread(s), %.3f s wall\n", done, stats.filesFailed.load(), settings.numThreads, wall);
+  if (wall > 0.0)
+    std::printf("throughput: %.2f files/s, %.1fx realtime\n", done / wall, stats.audioSeconds / wall);
+
+  if (stats.cache.IsOpen())
+  {
+    stats.cache.Evict();
+    const RenderCache::Stats cs = stats.cache.GetStats();
+    const uint64_t lookups = cs.hits + cs.misses;
+    std::printf("cache: %llu hit(s), %llu miss(es), %.0f%% hit rate, %.1f MB served, %llu evicted (%.1f MB)\n",
+                static_cast<unsigned long long>(cs.hits), static_cast<unsigned long long>(cs.misses),
+                lookups ? 100.0 * cs.hits / lookups : 0.0, cs.bytesServed / 1048576.0,
+                static_cast<unsigned long long>(cs.evicted), cs.bytesEvicted / 1048576.0);
+  }
+
+  return stats.filesFailed.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+// Cache-miss counters for lofi-render bench: L1 data read misses and
+// last-level cache misses of the calling thread, user space only. Uses
+// perf_event_open on Linux. Other platforms, and kernels without PMU access
+// (VMs, containers, perf_event_paranoid > 2), report Available() == false.
+
+#include <cstdint>
+
+#if defined(__linux__)
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+class CacheMissCounters
+{
+public:
+  struct Counts
+  {
+    uint64_t l1dReadMisses = 0;
+    uint64_t llcMisses = 0;
+  };
+
+  CacheMissCounters()
+  {
+#if defined(__linux__)
+    mFds[0] = Open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    mFds[1] = Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#endif
+  }
+
+  ~CacheMissCounters()
+  {
+#if defined(__linux__)
+    for (int fd : mFds)
+    {
+      if (fd >= 0)
+        close(fd);
+    }
+#endif
+  }
+
+  CacheMissCounters(const CacheMissCounters&) = delete;
+  CacheMissCounters& operator=(const CacheMissCounters&) = delete;
+
+  bool Available() const { return mFds[0] >= 0 && mFds[1] >= 0; }
+
+  void Start()
+  {
+#if defined(__linux__)
+    for (int fd : mFds)
+    {
+      if (fd >= 0)
+      {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+#endif
+  }
+
+  Counts Stop()
+  {
+    Counts counts;
+#if defined(__linux__)
+    uint64_t values[2] = {};
+    for (int i = 0; i < 2; ++i)
+    {
+      if (mFds[i] < 0)
+        continue;
+      ioctl(mFds[i], PERF_EVENT_IOC_DISABLE, 0);
+      if (read(mFds[i], &values[i], sizeof(values[i])) != static_cast<ssize_t>(sizeof(values[i])))
+        values[i] = 0;
+    }
+    counts.l1dReadMisses = values[0];
+    counts.llcMisses = values[1];
+#endif
+    return counts;
+  }
+
+private:
+#if defined(__linux__)
+  static int Open(uint32_t type, uint64_t config)
+  {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+#endif
+
+  int mFds[2] = {-1, -1};
+};
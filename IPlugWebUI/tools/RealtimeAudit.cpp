@@ -0,0 +1,451 @@
+// Interposers and violation log behind RealtimeAudit.h.
+//
+// The definitions below take precedence over libc for every call that goes
+// through the dynamic linker, from this executable and from libstdc++ alike
+// (operator new, std::mutex, iostreams). Allocator calls forward to glibc's
+// __libc_* entry points, everything else to the next definition found with
+// dlsym(RTLD_NEXT). Calls libc makes internally do not go through the PLT
+// and are not seen, which is fine: what matters is what the DSP code calls.
+//
+// Recording runs on the offending thread, so it must not allocate or block
+// either: sites live in a fixed table behind a spinlock, and backtrace() is
+// warmed up in Arm() (its first call loads the unwinder). A thread-local flag
+// keeps the unwinder's own locking from being recorded.
+
+#include "RealtimeAudit.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if defined(__linux__) && defined(__GLIBC__)
+  #include <cxxabi.h>
+  #include <dlfcn.h>
+  #include <execinfo.h>
+  #include <pthread.h>
+  #include <sched.h>
+  #include <sys/mman.h>
+  #include <time.h>
+  #include <unistd.h>
+  #define LOFI_RTAUDIT_INTERPOSE 1
+#endif
+
+namespace rtaudit
+{
+namespace
+{
+thread_local int tScopeDepth = 0;
+thread_local bool tRecording = false;
+
+Site gSites[kMaxSites];
+std::atomic<size_t> gNumSites {0};
+std::atomic<uint64_t> gCounts[kNumViolationKinds];
+std::atomic<uint64_t> gDroppedSites {0};
+std::atomic_flag gSitesLock = ATOMIC_FLAG_INIT;
+std::atomic<const char*> gContext {""};
+bool gArmed = false;
+
+#if defined(LOFI_RTAUDIT_INTERPOSE)
+// Same kind, function and stack: the function name pointer is a literal per
+// interposer, so comparing pointers is enough
+bool SameSite(const Site& site, EViolation kind, const char* function, void* const* frames, int numFrames)
+{
+  return site.kind == kind && site.function == function && site.numFrames == numFrames &&
+         std::memcmp(site.frames, frames, sizeof(void*) * static_cast<size_t>(numFrames)) == 0;
+}
+
+__attribute__((noinline)) void Record(EViolation kind, const char* function)
+{
+  // Frame 0 is Record, frame 1 the interposer
+  void* raw[kMaxFrames + 2];
+  const int captured = backtrace(raw, kMaxFrames + 2);
+  void* const* frames = raw + 2;
+  const int numFrames = captured > 2 ? captured - 2 : 0;
+
+  gCounts[kind].fetch_add(1, std::memory_order_relaxed);
+
+  while (gSitesLock.test_and_set(std::memory_order_acquire))
+  {
+  }
+  const size_t numSites = gNumSites.load(std::memory_order_relaxed);
+  size_t index = 0;
+  while (index < numSites && !SameSite(gSites[index], kind, function, frames, numFrames))
+    ++index;
+
+  if (index < numSites)
+  {
+    ++gSites[index].count;
+  }
+  else if (numSites < kMaxSites)
+  {
+    Site& site = gSites[numSites];
+    site.kind = kind;
+    site.function = function;
+    site.context = gContext.load(std::memory_order_relaxed);
+    site.count = 1;
+    site.numFrames = numFrames;
+    std::memcpy(site.frames, frames, sizeof(void*) * static_cast<size_t>(numFrames));
+    gNumSites.store(numSites + 1, std::memory_order_relaxed);
+  }
+  else
+  {
+    gDroppedSites.fetch_add(1, std::memory_order_relaxed);
+  }
+  gSitesLock.clear(std::memory_order_release);
+}
+
+inline void Check(EViolation kind, const char* function)
+{
+  if (tScopeDepth > 0 && !tRecording)
+  {
+    tRecording = true;
+    Record(kind, function);
+    tRecording = false;
+  }
+}
+
+// Resolved on first use; dlsym only allocates through the hooks below, which
+// forward to __libc_* and never recurse into it
+template <typename Fn>
+Fn Next(std::atomic<Fn>& slot, const char* name)
+{
+  Fn fn = slot.load(std::memory_order_relaxed);
+  if (!fn)
+  {
+    fn = reinterpret_cast<Fn>(dlsym(RTLD_NEXT, name));
+    slot.store(fn, std::memory_order_relaxed);
+  }
+  return fn;
+}
+#endif
+} // namespace
+
+bool Available()
+{
+#if defined(LOFI_RTAUDIT_INTERPOSE)
+  return true;
+#else
+  return false;
+#endif
+}
+
+void SetContext(const char* label) { gContext.store(label ? label : "", std::memory_order_relaxed); }
+
+Scope::Scope() { ++tScopeDepth; }
+Scope::~Scope() { --tScopeDepth; }
+
+uint64_t GetViolationCount(EViolation kind) { return gCounts[kind].load(std::memory_order_relaxed); }
+
+uint64_t GetTotalViolations()
+{
+  uint64_t total = 0;
+  for (int k = 0; k < kNumViolationKinds; ++k)
+    total += GetViolationCount(static_cast<EViolation>(k));
+  return total;
+}
+
+size_t GetNumSites() { return gNumSites.load(std::memory_order_acquire); }
+const Site& GetSite(size_t index) { return gSites[index]; }
+uint64_t GetDroppedSites() { return gDroppedSites.load(std::memory_order_relaxed); }
+
+void Clear()
+{
+  while (gSitesLock.test_and_set(std::memory_order_acquire))
+  {
+  }
+  gNumSites.store(0, std::memory_order_relaxed);
+  for (auto& count : gCounts)
+    count.store(0, std::memory_order_relaxed);
+  gDroppedSites.store(0, std::memory_order_relaxed);
+  gSitesLock.clear(std::memory_order_release);
+}
+
+const char* GetKindName(EViolation kind)
+{
+  static const char* kNames[kNumViolationKinds] = {"allocation", "free", "lock", "syscall"};
+  return kNames[kind];
+}
+
+bool Arm()
+{
+#if defined(LOFI_RTAUDIT_INTERPOSE)
+  if (!gArmed)
+  {
+    // Loads libgcc_s and resolves the forwarded functions outside any scope
+    void* warmup[4];
+    backtrace(warmup, 4);
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_mutex_trylock(&mutex);
+    pthread_mutex_unlock(&mutex);
+    sched_yield();
+    gArmed = true;
+  }
+
+  // Each kind must be caught, or the audit would pass vacuously. The
+  // volatile pointer keeps the compiler from eliding the malloc/free pair.
+  Clear();
+  {
+    void* (*volatile allocate)(size_t) = &std::malloc;
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    Scope scope;
+    std::free(allocate(64));
+    pthread_mutex_lock(&mutex);
+    pthread_mutex_unlock(&mutex);
+    sched_yield();
+  }
+  const bool caught = GetViolationCount(kViolationAlloc) > 0 && GetViolationCount(kViolationFree) > 0 &&
+                      GetViolationCount(kViolationLock) > 0 && GetViolationCount(kViolationSyscall) > 0;
+  Clear();
+  return caught;
+#else
+  return false;
+#endif
+}
+
+std::string FormatStack(const Site& site)
+{
+  std::string text;
+#if defined(LOFI_RTAUDIT_INTERPOSE)
+  char** symbols = backtrace_symbols(site.frames, site.numFrames);
+  for (int f = 0; f < site.numFrames; ++f)
+  {
+    // "module(mangled+0x1f) [0x...]"; demangle the middle part when present
+    std::string line = symbols ? symbols[f] : "?";
+    const size_t open = line.find('(');
+    const size_t plus = line.find('+', open);
+    if (open != std::string::npos && plus != std::string::npos && plus > open + 1)
+    {
+      const std::string mangled = line.substr(open + 1, plus - open - 1);
+      int status = -1;
+      char* demangled = abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status);
+      if (status == 0 && demangled)
+        line = line.substr(0, open + 1) + demangled + line.substr(plus);
+      std::free(demangled);
+    }
+    text += "    #" + std::to_string(f) + " " + line + "\n";
+  }
+  std::free(symbols);
+#else
+  (void) site;
+#endif
+  return text;
+}
+} // namespace rtaudit
+
+#if defined(LOFI_RTAUDIT_INTERPOSE)
+using rtaudit::Check;
+using rtaudit::Next;
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+
+// Allocator
+
+void* malloc(size_t size) __THROW
+{
+  Check(rtaudit::kViolationAlloc, "malloc");
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) __THROW
+{
+  Check(rtaudit::kViolationAlloc, "calloc");
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) __THROW
+{
+  Check(rtaudit::kViolationAlloc, "realloc");
+  return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) __THROW
+{
+  Check(rtaudit::kViolationAlloc, "memalign");
+  return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) __THROW
+{
+  Check(rtaudit::kViolationAlloc, "aligned_alloc");
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) __THROW
+{
+  Check(rtaudit::kViolationAlloc, "posix_memalign");
+  if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0)
+    return EINVAL;
+  void* ptr = __libc_memalign(alignment, size);
+  if (!ptr)
+    return ENOMEM;
+  *out = ptr;
+  return 0;
+}
+
+void free(void* ptr) __THROW
+{
+  if (ptr)
+    Check(rtaudit::kViolationFree, "free");
+  __libc_free(ptr);
+}
+
+// Locks. Unlocking is not reported: it only follows a reported lock.
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) __THROWNL
+{
+  static std::atomic<int (*)(pthread_mutex_t*)> next;
+  Check(rtaudit::kViolationLock, "pthread_mutex_lock");
+  return Next(next, "pthread_mutex_lock")(mutex);
+}
+
+int pthread_mutex_trylock(pthread_mutex_t* mutex) __THROWNL
+{
+  static std::atomic<int (*)(pthread_mutex_t*)> next;
+  Check(rtaudit::kViolationLock, "pthread_mutex_trylock");
+  return Next(next, "pthread_mutex_trylock")(mutex);
+}
+
+int pthread_rwlock_rdlock(pthread_rwlock_t* lock) __THROWNL
+{
+  static std::atomic<int (*)(pthread_rwlock_t*)> next;
+  Check(rtaudit::kViolationLock, "pthread_rwlock_rdlock");
+  return Next(next, "pthread_rwlock_rdlock")(lock);
+}
+
+int pthread_rwlock_wrlock(pthread_rwlock_t* lock) __THROWNL
+{
+  static std::atomic<int (*)(pthread_rwlock_t*)> next;
+  Check(rtaudit::kViolationLock, "pthread_rwlock_wrlock");
+  return Next(next, "pthread_rwlock_wrlock")(lock);
+}
+
+int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex)
+{
+  static std::atomic<int (*)(pthread_cond_t*, pthread_mutex_t*)> next;
+  Check(rtaudit::kViolationLock, "pthread_cond_wait");
+  return Next(next, "pthread_cond_wait")(cond, mutex);
+}
+
+// Blocking system calls and logging
+
+ssize_t read(int fd, void* buffer, size_t size)
+{
+  static std::atomic<ssize_t (*)(int, void*, size_t)> next;
+  Check(rtaudit::kViolationSyscall, "read");
+  return Next(next, "read")(fd, buffer, size);
+}
+
+ssize_t write(int fd, const void* buffer, size_t size)
+{
+  static std::atomic<ssize_t (*)(int, const void*, size_t)> next;
+  Check(rtaudit::kViolationSyscall, "write");
+  return Next(next, "write")(fd, buffer, size);
+}
+
+int close(int fd)
+{
+  static std::atomic<int (*)(int)> next;
+  Check(rtaudit::kViolationSyscall, "close");
+  return Next(next, "close")(fd);
+}
+
+int nanosleep(const struct timespec* duration, struct timespec* remaining)
+{
+  static std::atomic<int (*)(const struct timespec*, struct timespec*)> next;
+  Check(rtaudit::kViolationSyscall, "nanosleep");
+  return Next(next, "nanosleep")(duration, remaining);
+}
+
+int usleep(useconds_t usec)
+{
+  static std::atomic<int (*)(useconds_t)> next;
+  Check(rtaudit::kViolationSyscall, "usleep");
+  return Next(next, "usleep")(usec);
+}
+
+int sched_yield() __THROW
+{
+  static std::atomic<int (*)()> next;
+  Check(rtaudit::kViolationSyscall, "sched_yield");
+  return Next(next, "sched_yield")();
+}
+
+void* mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset) __THROW
+{
+  static std::atomic<void* (*)(void*, size_t, int, int, int, off_t)> next;
+  Check(rtaudit::kViolationSyscall, "mmap");
+  return Next(next, "mmap")(addr, length, prot, flags, fd, offset);
+}
+
+int munmap(void* addr, size_t length) __THROW
+{
+  static std::atomic<int (*)(void*, size_t)> next;
+  Check(rtaudit::kViolationSyscall, "munmap");
+  return Next(next, "munmap")(addr, length);
+}
+
+FILE* fopen(const char* path, const char* mode)
+{
+  static std::atomic<FILE* (*)(const char*, const char*)> next;
+  Check(rtaudit::kViolationSyscall, "fopen");
+  return Next(next, "fopen")(path, mode);
+}
+
+size_t fwrite(const void* buffer, size_t size, size_t count, FILE* stream)
+{
+  static std::atomic<size_t (*)(const void*, size_t, size_t, FILE*)> next;
+  Check(rtaudit::kViolationSyscall, "fwrite");
+  return Next(next, "fwrite")(buffer, size, count, stream);
+}
+
+int fputs(const char* text, FILE* stream)
+{
+  static std::atomic<int (*)(const char*, FILE*)> next;
+  Check(rtaudit::kViolationSyscall, "fputs");
+  return Next(next, "fputs")(text, stream);
+}
+
+int puts(const char* text)
+{
+  static std::atomic<int (*)(const char*)> next;
+  Check(rtaudit::kViolationSyscall, "puts");
+  return Next(next, "puts")(text);
+}
+
+int fflush(FILE* stream)
+{
+  static std::atomic<int (*)(FILE*)> next;
+  Check(rtaudit::kViolationSyscall, "fflush");
+  return Next(next, "fflush")(stream);
+}
+
+int printf(const char* format, ...)
+{
+  Check(rtaudit::kViolationSyscall, "printf");
+  va_list args;
+  va_start(args, format);
+  const int result = vprintf(format, args);
+  va_end(args);
+  return result;
+}
+
+int fprintf(FILE* stream, const char* format, ...)
+{
+  Check(rtaudit::kViolationSyscall, "fprintf");
+  va_list args;
+  va_start(args, format);
+  const int result = vfprintf(stream, format, args);
+  va_end(args);
+  return result;
+}
+} // extern "C"
+#endif
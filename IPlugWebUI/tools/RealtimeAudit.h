@@ -0,0 +1,75 @@
+#pragma once
+
+// Realtime-safety instrumentation for lofi-audit. RealtimeAudit.cpp
+// interposes the allocator (malloc, calloc, realloc, free, aligned
+// allocation), the pthread lock entry points and a set of blocking or
+// logging calls (read, write, close, sleeps, sched_yield, mmap, stdio). While
+// the calling thread holds a rtaudit::Scope, every call that reaches one of
+// them is recorded as a violation together with a stack trace; outside a
+// scope they forward to libc at the cost of one thread-local check.
+// Interposition needs glibc on Linux; elsewhere Available() returns false and
+// nothing is recorded.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace rtaudit
+{
+enum EViolation
+{
+  kViolationAlloc = 0,
+  kViolationFree,
+  kViolationLock,
+  kViolationSyscall,
+  kNumViolationKinds
+};
+
+constexpr int kMaxFrames = 24;
+constexpr size_t kMaxSites = 256;
+
+// One distinct call site (same kind, function and calling stack)
+struct Site
+{
+  EViolation kind;
+  const char* function;  // the intercepted entry point
+  const char* context;   // SetContext label when first seen
+  uint64_t count;
+  int numFrames;
+  void* frames[kMaxFrames];
+};
+
+bool Available();
+
+// Resolves the forwarded libc functions and warms up the unwinder so the
+// first violation does not allocate while recording, then checks that a
+// scoped allocation, lock and syscall are each caught. Clears all records.
+// Returns false if interposition is unavailable or the self-check failed.
+bool Arm();
+
+// Label stored with newly seen sites; must outlive the audit
+void SetContext(const char* label);
+
+// Marks the calling thread as being on the realtime path while alive. Nests.
+class Scope
+{
+public:
+  Scope();
+  ~Scope();
+  Scope(const Scope&) = delete;
+  Scope& operator=(const Scope&) = delete;
+};
+
+uint64_t GetViolationCount(EViolation kind);
+uint64_t GetTotalViolations();
+size_t GetNumSites();
+const Site& GetSite(size_t index);
+// Violations whose site did not fit into kMaxSites (still counted)
+uint64_t GetDroppedSites();
+void Clear();
+
+const char* GetKindName(EViolation kind);
+// Demangled "function+offset (module)" lines for a recorded stack. Call
+// outside any Scope; symbolising allocates.
+std::string FormatStack(const Site& site);
+} // namespace rtaudit
@@ -0,0 +1,149 @@
+#pragma once
+
+// Content-addressed cache of finished renders.
+// Entries are plain WAV files named after the render key (a hash of the input
+// audio, the full parameter state, seed, block size, plug-in version and DSP
+// render version).
+// A hit refreshes the entry's timestamp, so size-based eviction drops the
+// least recently used renders first.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+class RenderCache
+{
+public:
+  struct Stats
+  {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t bytesServed = 0;
+    uint64_t evicted = 0;
+    uint64_t bytesEvicted = 0;
+  };
+
+  // maxBytes == 0 disables eviction
+  bool Open(const std::string& dir, uint64_t maxBytes)
+  {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    mDir = dir;
+    mMaxBytes = maxBytes;
+    // Tells this writer's temporary files apart from other processes sharing
+    // the directory
+    std::random_device rd;
+    mWriterId = std::to_string(rd()) + std::to_string(rd());
+    return !ec && std::filesystem::is_directory(dir, ec);
+  }
+
+  bool IsOpen() const { return !mDir.empty(); }
+
+  // Copies a cached render to outputPath; false on a miss
+  bool Fetch(const std::string& key, const std::string& outputPath)
+  {
+    std::error_code ec;
+    const std::filesystem::path entry = EntryPath(key);
+    if (!std::filesystem::is_regular_file(entry, ec))
+    {
+      mMisses.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    std::filesystem::copy_file(entry, outputPath, std::filesystem::copy_options::overwrite_existing, ec);
+    if (ec)
+    {
+      mMisses.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    std::filesystem::last_write_time(entry, std::filesystem::file_time_type::clock::now(), ec);
+    mHits.fetch_add(1, std::memory_order_relaxed);
+    mBytesServed.fetch_add(std::filesystem::file_size(entry, ec), std::memory_order_relaxed);
+    return true;
+  }
+
+  // Adds a finished render; written under a temporary name unique to this
+  // writer and call, then renamed, so concurrent readers never see a partial
+  // entry and concurrent writers of the same key never share a file
+  void Store(const std::string& key, const std::string& renderedPath)
+  {
+    std::error_code ec;
+    const std::filesystem::path entry = EntryPath(key);
+    const std::filesystem::path tmp =
+      entry.string() + "." + mWriterId + "-" + std::to_string(mTmpSerial.fetch_add(1, std::memory_order_relaxed)) + ".tmp";
+    std::filesystem::copy_file(renderedPath, tmp, std::filesystem::copy_options::overwrite_existing, ec);
+    if (!ec)
+      std::filesystem::rename(tmp, entry, ec);
+    if (ec)
+      std::filesystem::remove(tmp, ec);
+  }
+
+  // Removes least recently used entries until the cache fits in maxBytes
+  void Evict()
+  {
+    if (mMaxBytes == 0 || mDir.empty())
+      return;
+
+    struct Entry
+    {
+      std::filesystem::path path;
+      std::filesystem::file_time_type time;
+      uint64_t size;
+    };
+
+    std::error_code ec;
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    for (const auto& item : std::filesystem::directory_iterator(mDir, ec))
+    {
+      if (!item.is_regular_file(ec) || item.path().extension() != ".wav")
+        continue;
+      const uint64_t size = item.file_size(ec);
+      entries.push_back({item.path(), item.last_write_time(ec), size});
+      total += size;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.time < b.time; });
+    for (const Entry& e : entries)
+    {
+      if (total <= mMaxBytes)
+        break;
+      if (std::filesystem::remove(e.path, ec))
+      {
+        total -= e.size;
+        mEvicted.fetch_add(1, std::memory_order_relaxed);
+        mBytesEvicted.fetch_add(e.size, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  Stats GetStats() const
+  {
+    Stats s;
+    s.hits = mHits.load();
+    s.misses = mMisses.load();
+    s.bytesServed = mBytesServed.load();
+    s.evicted = mEvicted.load();
+    s.bytesEvicted = mBytesEvicted.load();
+    return s;
+  }
+
+private:
+  std::filesystem::path EntryPath(const std::string& key) const { return std::filesystem::path(mDir) / (key + ".wav"); }
+
+  std::string mDir;
+  uint64_t mMaxBytes = 0;
+  std::atomic<uint64_t> mHits {0};
+  std::atomic<uint64_t> mMisses {0};
+  std::atomic<uint64_t> mBytesServed {0};
+  std::atomic<uint64_t> mEvicted {0};
+  std::atomic<uint64_t> mBytesEvicted {0};
+  std::string mWriterId;
+  std::atomic<uint64_t> mTmpSerial {0};
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+// Spectral measurements used by lofi-render verify: Welch-averaged power
+// spectra, third-octave band powers and the THD of a sine response, on the
+// plug-in's FFT. Accuracy over speed; none of this runs on the audio thread.
+
+#include "FFT.h"
+#include "TapeSaturatorDSP.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace spectrum
+{
+using tapedsp::FFT;
+
+inline int LargestPowerOfTwo(int64_t n, int maxSize)
+{
+  int size = 1;
+  while (size * 2 <= n && size * 2 <= maxSize)
+    size *= 2;
+  return size;
+}
+
+// Power per bin (fftSize / 2 + 1 bins), Hann window, 50% overlap
+inline std::vector<double> WelchPowerSpectrum(const double* x, int64_t numSamples, int fftSize)
+{
+  std::vector<double> power(fftSize / 2 + 1, 0.0);
+  std::vector<double> window(fftSize);
+  for (int i = 0; i < fftSize; ++i)
+    window[i] = 0.5 - 0.5 * std::cos(tapedsp::kTwoPi * i / fftSize);
+
+  std::vector<std::complex<double>> frame(fftSize);
+  int segments = 0;
+  for (int64_t start = 0; start + fftSize <= numSamples; start += fftSize / 2)
+  {
+    for (int i = 0; i < fftSize; ++i)
+      frame[i] = x[start + i] * window[i];
+    FFT(frame);
+    for (size_t k = 0; k < power.size(); ++k)
+      power[k] += std::norm(frame[k]);
+    ++segments;
+  }
+
+  if (segments > 0)
+  {
+    for (double& p : power)
+      p /= segments;
+  }
+  return power;
+}
+
+// Summed bin power of the third-octave bands centred on 1 kHz * 2^(k/3)
+// between 20 Hz and 20 kHz (or Nyquist). Bin 0 (DC) is left out.
+inline std::vector<double> ThirdOctaveBands(const std::vector<double>& power, double sampleRate, int fftSize)
+{
+  std::vector<double> bands;
+  const double binHz = sampleRate / fftSize;
+  for (int k = -17; k <= 13; ++k)
+  {
+    const double centre = 1000.0 * std::pow(2.0, k / 3.0);
+    const double lo = centre * std::pow(2.0, -1.0 / 6.0);
+    const double hi = centre * std::pow(2.0, 1.0 / 6.0);
+    if (hi > 0.5 * sampleRate)
+      break;
+
+    const size_t first = std::max<size_t>(1, static_cast<size_t>(std::ceil(lo / binHz)));
+    const size_t last = std::min(power.size() - 1, static_cast<size_t>(std::floor(hi / binHz)));
+    double sum = 0.0;
+    for (size_t b = first; b <= last; ++b)
+      sum += power[b];
+    bands.push_back(sum);
+  }
+  return bands;
+}
+
+// Total harmonic distortion (harmonics 2..10 below Nyquist) of a steady sine
+// response at f0, in dB relative to the fundamental. Uses one 4-term
+// Blackman-Harris frame and sums +-6 bins around each harmonic so leakage of
+// off-bin frequencies and slight pitch modulation stay inside the window.
+inline double ThdDb(const double* x, int64_t numSamples, double sampleRate, double f0)
+{
+  const int fftSize = LargestPowerOfTwo(numSamples, 1 << 16);
+  std::vector<std::complex<double>> frame(fftSize);
+  for (int i = 0; i < fftSize; ++i)
+  {
+    const double p = tapedsp::kTwoPi * i / fftSize;
+    const double w = 0.35875 - 0.48829 * std::cos(p) + 0.14128 * std::cos(2.0 * p) - 0.01168 * std::cos(3.0 * p);
+    frame[i] = x[i] * w;
+  }
+  FFT(frame);
+
+  const double binHz = sampleRate / fftSize;
+  auto harmonicPower = [&](int h) {
+    const int centre = static_cast<int>(std::lround(h * f0 / binHz));
+    double sum = 0.0;
+    for (int b = std::max(1, centre - 6); b <= std::min(fftSize / 2, centre + 6); ++b)
+      sum += std::norm(frame[b]);
+    return sum;
+  };
+
+  const double fundamental = harmonicPower(1);
+  double harmonics = 0.0;
+  for (int h = 2; h <= 10 && h * f0 < 0.5 * sampleRate - 6.0 * binHz; ++h)
+    harmonics += harmonicPower(h);
+
+  return 10.0 * std::log10((harmonics + 1e-30) / (fundamental + 1e-30));
+}
+} // namespace spectrum
@@ -0,0 +1,377 @@
+// lofi-render stream: bounded-memory render of arbitrarily long WAV files.
+//
+//   lofi-render stream [options] <in.wav> <out.wav> [Param=value ...]
+//
+// Audio is read, processed and written in fixed-size chunks, so memory use does
+// not depend on file length. With --checkpoint the complete DSP state is saved
+// next to the output at regular intervals; --resume picks up from the last
+// checkpoint and produces output identical to an uninterrupted run.
+//
+// Options:
+//   --block N          DSP block size in frames (default 512)
+//   --chunk N          I/O chunk in blocks (default 128)
+//   --checkpoint PATH  checkpoint file (default: <out.wav>.ckpt when resuming)
+//   --interval S       audio seconds between checkpoints (default 60)
+//   --resume           continue from the checkpoint if one exists
+//   --seed N           noise seed unless the job has Seed=N (default 0)
+
+#include "Commands.h"
+#include "TapeJob.h"
+#include "WavFile.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+constexpr uint32_t kCheckpointMagic = 0x4B43544C; // 'LTCK'
+constexpr uint32_t kCheckpointVersion = 1;
+
+struct StreamSettings
+{
+  int blockSize = 512;
+  int chunkBlocks = 128;
+  std::string checkpointPath;
+  double intervalSeconds = 60.0;
+  bool resume = false;
+  uint32_t seed = 0;
+};
+
+// Ties a checkpoint to the job that wrote it
+uint64_t HashJob(const JobSpec& job, const WavFormat& fmt, int blockSize)
+{
+  uint64_t h = 0xCBF29CE484222325ull; // FNV-1a
+  auto mix = [&h](const void* data, size_t size) {
+    const auto* p = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+      h ^= p[i];
+      h *= 0x100000001B3ull;
+    }
+  };
+  mix(job.inputPath.data(), job.inputPath.size());
+  for (const auto& p : job.params)
+  {
+    mix(&p.first, sizeof(p.first));
+    mix(&p.second, sizeof(p.second));
+  }
+  mix(&fmt.numChannels, sizeof(fmt.numChannels));
+  mix(&fmt.sampleRate, sizeof(fmt.sampleRate));
+  mix(&job.seed, sizeof(job.seed));
+  mix(&blockSize, sizeof(blockSize));
+  return h;
+}
+
+struct Checkpoint
+{
+  uint64_t jobHash = 0;
+  int64_t framesDone = 0;
+  std::vector<std::vector<uint8_t>> dspStates;
+};
+
+template <typename T>
+void PutRaw(std::vector<uint8_t>& out, const T& value)
+{
+  const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+  out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+bool GetRaw(const std::vector<uint8_t>& in, size_t& pos, T& value)
+{
+  if (in.size() - pos < sizeof(T))
+    return false;
+  std::memcpy(&value, in.data() + pos, sizeof(T));
+  pos += sizeof(T);
+  return true;
+}
+
+// Written to a temporary file and renamed, so a crash mid-write keeps the old one
+bool SaveCheckpoint(const std::string& path, const Checkpoint& ckpt)
+{
+  std::vector<uint8_t> bytes;
+  PutRaw(bytes, kCheckpointMagic);
+  PutRaw(bytes, kCheckpointVersion);
+  PutRaw(bytes, ckpt.jobHash);
+  PutRaw(bytes, ckpt.framesDone);
+  PutRaw(bytes, static_cast<uint32_t>(ckpt.dspStates.size()));
+  for (const auto& state : ckpt.dspStates)
+  {
+    PutRaw(bytes, static_cast<uint64_t>(state.size()));
+    bytes.insert(bytes.end(), state.begin(), state.end());
+  }
+
+  const std::string tmpPath = path + ".tmp";
+  FILE* file = std::fopen(tmpPath.c_str(), "wb");
+  if (!file)
+    return false;
+  const bool ok = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+  std::fclose(file);
+
+  std::error_code ec;
+  if (ok)
+    std::filesystem::rename(tmpPath, path, ec);
+  return ok && !ec;
+}
+
+bool LoadCheckpoint(const std::string& path, Checkpoint& ckpt)
+{
+  FILE* file = std::fopen(path.c_str(), "rb");
+  if (!file)
+    return false;
+  std::vector<uint8_t> bytes;
+  uint8_t buf[65536];
+  size_t got;
+  while ((got = std::fread(buf, 1, sizeof(buf), file)) > 0)
+    bytes.insert(bytes.end(), buf, buf + got);
+  std::fclose(file);
+
+  size_t pos = 0;
+  uint32_t magic = 0, version = 0, count = 0;
+  if (!GetRaw(bytes, pos, magic) || !GetRaw(bytes, pos, version) || magic != kCheckpointMagic || version != kCheckpointVersion)
+    return false;
+  if (!GetRaw(bytes, pos, ckpt.jobHash) || !GetRaw(bytes, pos, ckpt.framesDone) || !GetRaw(bytes, pos, count))
+    return false;
+
+  ckpt.dspStates.resize(count);
+  for (auto& state : ckpt.dspStates)
+  {
+    uint64_t size = 0;
+    if (!GetRaw(bytes, pos, size) || bytes.size() - pos < size)
+      return false;
+    state.assign(bytes.begin() + pos, bytes.begin() + pos + static_cast<size_t>(size));
+    pos += static_cast<size_t>(size);
+  }
+  return pos == bytes.size();
+}
+
+void PrintStreamUsage()
+{
+  std::fprintf(stderr,
+    "usage: lofi-render stream [--block frames] [--chunk blocks] [--checkpoint path]\n"
+    "                          [--interval seconds] [--resume] [--seed n] <in.wav> <out.wav> [Param=value ...]\n");
+}
+} // namespace
+
+int RunStreamCommand(int argc, char** argv)
+{
+  StreamSettings settings;
+  std::vector<std::string> positional;
+
+  for (int i = 0; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    if (arg == "--block" && i + 1 < argc)
+      settings.blockSize = std::clamp(std::atoi(argv[++i]), 1, 65536);
+    else if (arg == "--chunk" && i + 1 < argc)
+      settings.chunkBlocks = std::clamp(std::atoi(argv[++i]), 1, 4096);
+    else if (arg == "--checkpoint" && i + 1 < argc)
+      settings.checkpointPath = argv[++i];
+    else if (arg == "--interval" && i + 1 < argc)
+      settings.intervalSeconds = std::max(0.0, std::atof(argv[++i]));
+    else if (arg == "--resume")
+      settings.resume = true;
+    else if (arg == "--seed" && i + 1 < argc)
+      settings.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 0));
+    else
+      positional.push_back(arg);
+  }
+
+  JobSpec job;
+  std::string error;
+  if (positional.size() < 2 || !ParseJob(positional, job, error))
+  {
+    if (!error.empty())
+      std::fprintf(stderr, "error: %s\n", error.c_str());
+    PrintStreamUsage();
+    return 1;
+  }
+  if (!job.hasSeed)
+    job.seed = settings.seed;
+  if (settings.checkpointPath.empty() && settings.resume)
+    settings.checkpointPath = job.outputPath + ".ckpt";
+
+  FILE* input = std::fopen(job.inputPath.c_str(), "rb");
+  if (!input)
+  {
+    std::fprintf(stderr, "error: cannot open %s\n", job.inputPath.c_str());
+    return 1;
+  }
+
+  WavFormat fmt;
+  uint64_t dataBytes = 0;
+  if (!ReadWavHeader(input, fmt, dataBytes, error))
+  {
+    std::fprintf(stderr, "error: %s: %s\n", job.inputPath.c_str(), error.c_str());
+    std::fclose(input);
+    return 1;
+  }
+
+  const int64_t inputDataOffset = TellFile(input);
+  const int64_t totalFrames = static_cast<int64_t>(dataBytes / fmt.BlockAlign());
+  const int64_t outputDataOffset = static_cast<int64_t>(wavfile::MakeHeader(fmt, 0).size());
+  if (static_cast<uint64_t>(totalFrames) * fmt.BlockAlign() > 0xFFFFFFFFull - 64)
+  {
+    std::fprintf(stderr, "error: output would exceed the 4 GB RIFF limit\n");
+    std::fclose(input);
+    return 1;
+  }
+
+  // One stereo core per channel pair
+  const int numPairs = (fmt.numChannels + 1) / 2;
+  std::vector<std::unique_ptr<TapeSaturatorDSP>> dsps;
+  for (int p = 0; p < numPairs; ++p)
+  {
+    dsps.push_back(std::make_unique<TapeSaturatorDSP>());
+    PrepareDSP(*dsps.back(), job, fmt.sampleRate);
+  }
+
+  // Input frames consumed run `latency` ahead of output frames written; the
+  // tail is flushed with silence after the last input chunk
+  const int64_t latency = dsps.front()->GetLatencySamples();
+  const uint64_t jobHash = HashJob(job, fmt, settings.blockSize);
+  int64_t framesDone = 0;
+  FILE* output = nullptr;
+
+  Checkpoint ckpt;
+  if (settings.resume && LoadCheckpoint(settings.checkpointPath, ckpt))
+  {
+    bool valid = ckpt.jobHash == jobHash && ckpt.dspStates.size() == dsps.size() && ckpt.framesDone <= totalFrames;
+    for (size_t p = 0; valid && p < dsps.size(); ++p)
+      valid = dsps[p]->LoadState(ckpt.dspStates[p].data(), ckpt.dspStates[p].size());
+
+    std::error_code ec;
+    const int64_t framesWritten = std::max<int64_t>(0, ckpt.framesDone - latency);
+    const uint64_t resumeSize = static_cast<uint64_t>(outputDataOffset + framesWritten * fmt.BlockAlign());
+    if (valid && std::filesystem::exists(job.outputPath, ec) && std::filesystem::file_size(job.outputPath, ec) >= resumeSize)
+    {
+      // Drop anything written after the checkpoint
+      std::filesystem::resize_file(job.outputPath, resumeSize, ec);
+      output = ec ? nullptr : std::fopen(job.outputPath.c_str(), "r+b");
+    }
+
+    if (!output)
+    {
+      std::fprintf(stderr, "error: checkpoint %s does not match this job or output\n", settings.checkpointPath.c_str());
+      std::fclose(input);
+      return 1;
+    }
+
+    framesDone = ckpt.framesDone;
+    SeekFile(output, resumeSize);
+    std::printf("resuming at %.1f s\n", static_cast<double>(framesDone) / fmt.sampleRate);
+  }
+  else
+  {
+    output = std::fopen(job.outputPath.c_str(), "wb");
+    if (!output)
+    {
+      std::fprintf(stderr, "error: cannot create %s\n", job.outputPath.c_str());
+      std::fclose(input);
+      return 1;
+    }
+    const std::vector<uint8_t> header = wavfile::MakeHeader(fmt, 0);
+    std::fwrite(header.data(), 1, header.size(), output);
+  }
+
+  SeekFile(input, inputDataOffset + framesDone * fmt.BlockAlign());
+
+  // Fixed working set: one chunk of raw bytes and one of deinterleaved samples
+  const int chunkFrames = settings.blockSize * settings.chunkBlocks;
+  std::vector<uint8_t> raw(static_cast<size_t>(chunkFrames) * fmt.BlockAlign());
+  std::vector<std::vector<double>> inBuf(fmt.numChannels, std::vector<double>(chunkFrames));
+  std::vector<std::vector<double>> outBuf(fmt.numChannels, std::vector<double>(chunkFrames));
+  std::vector<double*> inPtrs(fmt.numChannels), outPtrs(fmt.numChannels), writePtrs(fmt.numChannels);
+  for (int c = 0; c < fmt.numChannels; ++c)
+  {
+    inPtrs[c] = inBuf[c].data();
+    outPtrs[c] = outBuf[c].data();
+  }
+
+  const int64_t intervalFrames = static_cast<int64_t>(settings.intervalSeconds * fmt.sampleRate);
+  const int64_t startFrame = framesDone;
+  int64_t lastCheckpoint = framesDone;
+  bool ok = true;
+  const auto start = std::chrono::steady_clock::now();
+
+  while (framesDone < totalFrames + latency)
+  {
+    const int n = static_cast<int>(std::min<int64_t>(chunkFrames, totalFrames + latency - framesDone));
+    const int readable = static_cast<int>(std::clamp<int64_t>(totalFrames - framesDone, 0, n));
+    const size_t readBytes = static_cast<size_t>(readable) * fmt.BlockAlign();
+    if (std::fread(raw.data(), 1, readBytes, input) != readBytes)
+    {
+      std::fprintf(stderr, "error: short read from %s\n", job.inputPath.c_str());
+      ok = false;
+      break;
+    }
+    DecodeFrames(raw.data(), fmt, readable, inPtrs.data());
+    for (int c = 0; c < fmt.numChannels; ++c)
+      std::fill(inBuf[c].begin() + readable, inBuf[c].begin() + n, 0.0);
+
+    for (int pos = 0; pos < n; pos += settings.blockSize)
+    {
+      const int blockFrames = std::min(settings.blockSize, n - pos);
+      for (int p = 0; p < numPairs; ++p)
+      {
+        const int first = p * 2;
+        const int pairChans = std::min(2, fmt.numChannels - first);
+        const double* in[2] = {inPtrs[first] + pos, pairChans > 1 ? inPtrs[first + 1] + pos : nullptr};
+        double* out[2] = {outPtrs[first] + pos, pairChans > 1 ? outPtrs[first + 1] + pos : nullptr};
+        dsps[p]->ProcessBlock(in, out, blockFrames, pairChans);
+      }
+    }
+
+    // Frames still inside the latency window have no output position yet
+    const int skip = static_cast<int>(std::clamp<int64_t>(latency - framesDone, 0, n));
+    for (int c = 0; c < fmt.numChannels; ++c)
+      writePtrs[c] = outPtrs[c] + skip;
+    const size_t writeBytes = static_cast<size_t>(n - skip) * fmt.BlockAlign();
+    EncodeFrames(writePtrs.data(), fmt, n - skip, raw.data());
+    if (std::fwrite(raw.data(), 1, writeBytes, output) != writeBytes)
+    {
+      std::fprintf(stderr, "error: write failed for %s\n", job.outputPath.c_str());
+      ok = false;
+      break;
+    }
+    framesDone += n;
+
+    if (!settings.checkpointPath.empty() && framesDone < totalFrames && framesDone - lastCheckpoint >= intervalFrames)
+    {
+      // Output must be on disk before the checkpoint that refers to it
+      std::fflush(output);
+      ckpt.jobHash = jobHash;
+      ckpt.framesDone = framesDone;
+      ckpt.dspStates.assign(dsps.size(), {});
+      for (size_t p = 0; p < dsps.size(); ++p)
+        dsps[p]->SaveState(ckpt.dspStates[p]);
+      if (!SaveCheckpoint(settings.checkpointPath, ckpt))
+        std::fprintf(stderr, "warning: could not write checkpoint %s\n", settings.checkpointPath.c_str());
+      lastCheckpoint = framesDone;
+    }
+  }
+
+  std::fclose(input);
+  ok = ok && PatchWavSizes(output, fmt, static_cast<uint64_t>(framesDone - latency) * fmt.BlockAlign());
+  ok = (std::fclose(output) == 0) && ok;
+  if (!ok)
+    return 1;
+
+  if (!settings.checkpointPath.empty())
+  {
+    std::error_code ec;
+    std::filesystem::remove(settings.checkpointPath, ec);
+  }
+
+  const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  const double audio = static_cast<double>(totalFrames - startFrame) / fmt.sampleRate;
+  std::printf("streamed %s (%.1f s audio, %.3f s wall, %.1fx realtime, %zu KB working set)\n", job.outputPath.c_str(), audio, wall,
+              wall > 0.0 ? audio / wall : 0.0, (raw.size() + 2 * fmt.numChannels * chunkFrames * sizeof(double)) / 1024);
+  return 0;
+}
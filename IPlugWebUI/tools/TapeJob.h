@@ -0,0 +1,239 @@
+#pragma once
+
+// Job description shared by the lofi-render commands: input/output paths plus
+// Param=value assignments resolved against the plug-in parameter table.
+
+#include "TapeSaturatorDSP.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct JobSpec
+{
+  std::string inputPath;
+  std::string outputPath;
+  std::vector<std::pair<int, double>> params;
+  uint32_t seed = 0;     // noise seed, the tools always render deterministically
+  bool hasSeed = false;  // set by a Seed=N token, otherwise --seed applies
+};
+
+// Parameters a job can set. Meters and the real-time quality controls are
+// left out: offline renders always run at full quality.
+inline bool IsJobParam(int paramIdx)
+{
+  return paramIdx >= 0 && paramIdx < kNumParams && paramIdx != kParamDriveVU && paramIdx != kParamQualityMode && paramIdx != kParamQualityTier;
+}
+
+inline bool ParseParamValue(int paramIdx, const std::string& text, double& value)
+{
+  if (paramIdx == kParamClipMode)
+  {
+    static const char* kModeNames[kNumClipModes] = {"Hard", "Soft", "Tanh"};
+    for (int m = 0; m < kNumClipModes; ++m)
+    {
+      if (text == kModeNames[m])
+      {
+        value = m;
+        return true;
+      }
+    }
+  }
+  else if (paramIdx == kParamMachine)
+  {
+    static const char* kMachineNames[kNumMachines] = {"Studio", "Cassette", "Cart", "Sampler"};
+    for (int m = 0; m < kNumMachines; ++m)
+    {
+      if (text == kMachineNames[m])
+      {
+        value = m;
+        return true;
+      }
+    }
+  }
+  else if ((paramIdx == kParamPower || paramIdx == kParamTruePeak || paramIdx == kParamAutoGain) && (text == "on" || text == "off"))
+  {
+    value = text == "on" ? 1.0 : 0.0;
+    return true;
+  }
+
+  char* end = nullptr;
+  value = std::strtod(text.c_str(), &end);
+  return end && *end == '\0' && end != text.c_str();
+}
+
+inline bool ParseParamAssignment(const std::string& token, std::pair<int, double>& out, std::string& error)
+{
+  const size_t eq = token.find('=');
+  if (eq == std::string::npos)
+  {
+    error = "expected Param=value, got '" + token + "'";
+    return false;
+  }
+
+  const std::string name = token.substr(0, eq);
+  const int idx = FindTapeParam(name.c_str());
+  if (!IsJobParam(idx))
+  {
+    error = "unknown parameter '" + name + "'";
+    return false;
+  }
+
+  double value = 0.0;
+  if (!ParseParamValue(idx, token.substr(eq + 1), value))
+  {
+    error = "bad value for " + name;
+    return false;
+  }
+
+  const TapeParamSpec& spec = GetTapeParamSpec(idx);
+  out = {idx, std::clamp(value, spec.minValue, spec.maxValue)};
+  return true;
+}
+
+// Splits on whitespace, honouring double quotes
+inline std::vector<std::string> Tokenise(const std::string& line)
+{
+  std::vector<std::string> tokens;
+  std::string current;
+  bool inQuotes = false;
+  bool hasToken = false;
+  for (char ch : line)
+  {
+    if (ch == '"')
+    {
+      inQuotes = !inQuotes;
+      hasToken = true;
+    }
+    else if (!inQuotes && (ch == ' ' || ch == '\t' || ch == '\r'))
+    {
+      if (hasToken)
+        tokens.push_back(current);
+      current.clear();
+      hasToken = false;
+    }
+    else
+    {
+      current += ch;
+      hasToken = true;
+    }
+  }
+  if (hasToken)
+    tokens.push_back(current);
+  return tokens;
+}
+
+inline bool HasExtension(const std::string& path, const char* ext)
+{
+  const size_t n = std::strlen(ext);
+  if (path.size() < n)
+    return false;
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (std::tolower(static_cast<unsigned char>(path[path.size() - n + i])) != ext[i])
+      return false;
+  }
+  return true;
+}
+
+inline bool ParseJob(const std::vector<std::string>& tokens, JobSpec& job, std::string& error)
+{
+  if (tokens.size() < 2)
+  {
+    error = "a job needs an input and an output path";
+    return false;
+  }
+
+  job.inputPath = tokens[0];
+  job.outputPath = tokens[1];
+  // Only WAV is read and written (WavFile.h); there is no FLAC codec
+  for (const std::string* path : {&job.inputPath, &job.outputPath})
+  {
+    if (HasExtension(*path, ".flac"))
+    {
+      error = "FLAC is not supported, convert to WAV first: " + *path;
+      return false;
+    }
+  }
+  for (size_t i = 2; i < tokens.size(); ++i)
+  {
+    if (tokens[i].compare(0, 5, "Seed=") == 0)
+    {
+      char* end = nullptr;
+      job.seed = static_cast<uint32_t>(std::strtoul(tokens[i].c_str() + 5, &end, 0));
+      job.hasSeed = true;
+      if (!end || *end != '\0')
+      {
+        error = "bad value for Seed";
+        return false;
+      }
+      continue;
+    }
+
+    std::pair<int, double> assignment;
+    if (!ParseParamAssignment(tokens[i], assignment, error))
+      return false;
+    job.params.push_back(assignment);
+  }
+  return true;
+}
+
+inline bool LoadJobFile(const std::string& path, std::vector<JobSpec>& jobs)
+{
+  std::ifstream file(path);
+  if (!file)
+  {
+    std::fprintf(stderr, "error: cannot open job list %s\n", path.c_str());
+    return false;
+  }
+
+  std::string line;
+  int lineNumber = 0;
+  while (std::getline(file, line))
+  {
+    ++lineNumber;
+    const std::vector<std::string> tokens = Tokenise(line);
+    if (tokens.empty() || tokens[0][0] == '#')
+      continue;
+
+    JobSpec job;
+    std::string error;
+    if (!ParseJob(tokens, job, error))
+    {
+      std::fprintf(stderr, "error: %s:%d: %s\n", path.c_str(), lineNumber, error.c_str());
+      return false;
+    }
+    jobs.push_back(std::move(job));
+  }
+  return true;
+}
+
+// Full parameter state of a job: plug-in defaults overridden by its assignments
+inline std::array<double, kNumParams> ResolveParams(const JobSpec& job)
+{
+  std::array<double, kNumParams> values;
+  for (int i = 0; i < kNumParams; ++i)
+    values[i] = GetTapeParamSpec(i).defaultValue;
+  for (const auto& p : job.params)
+    values[p.first] = p.second;
+  return values;
+}
+
+// Defaults first, then the job's assignments, then Reset at the file rate
+inline void PrepareDSP(TapeSaturatorDSP& dsp, const JobSpec& job, double sampleRate)
+{
+  dsp.ApplyDefaults();
+  for (const auto& p : job.params)
+    dsp.SetParam(p.first, p.second);
+  dsp.SetDeterministic(true, job.seed);
+  dsp.Reset(sampleRate);
+}
@@ -0,0 +1,654 @@
+// lofi-render verify: golden-output regression corpus for the DSP core.
+//
+//   lofi-render verify --record <dir> [--seconds s] [--rate hz] [--block frames] [--runs n]
+//   lofi-render verify <dir> [--runs n] [--tier high|eco|draft] [--no-perf] [--only text]
+//
+// --record renders every test signal (sweep, impulses, pink noise, a 1 kHz
+// sine and synthetic program material) through every parameter state of the
+// grid below and stores the results as 32-bit float WAVs plus a corpus.txt
+// manifest holding the render settings, the measured ns/sample and the
+// per-test tolerances. Record on a commit whose sound you trust.
+//
+// Checking re-renders each test and compares it with its reference:
+//   null   residual power relative to the reference, in dB ("exact" when the
+//          output is bit-identical after float32 rounding)
+//   thd    change of THD in dB, sine tests only
+//   band   largest third-octave band level change in dB
+//   ns     best-of-runs ns/sample against ns * budget from the manifest
+// A test fails when any of them is outside its tolerance; edit corpus.txt to
+// tighten or relax a single test. --no-perf skips the ns budget (e.g. on a
+// different machine than the one that recorded), --tier renders at a reduced
+// quality tier to see how far it is from the High references, and --only
+// restricts the run to tests whose name contains the given text.
+// The exit code is 1 if any test fails.
+
+#include "Commands.h"
+#include "Spectrum.h"
+#include "TapeJob.h"
+#include "WavFile.h"
+#include "config.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+using Signal = std::vector<std::vector<double>>;
+
+constexpr const char* kManifestName = "corpus.txt";
+// Absolute allowance on top of the relative ns budget, so near-free states
+// (bypass) do not fail on timer jitter
+constexpr double kPerfSlackNs = 5.0;
+constexpr double kSineHz = 1000.0;
+
+const char* kTierNames[kNumQualityTiers] = {"high", "eco", "draft"};
+
+struct CorpusSettings
+{
+  double seconds = 1.0;
+  double sampleRate = 48000.0;
+  int blockSize = 512;
+};
+
+struct Tolerance
+{
+  double nullDb = -100.0;  // residual must be at least this far below the reference
+  double thdDb = 0.1;      // largest allowed THD change
+  double bandDb = 0.05;    // largest allowed third-octave band change
+  double budget = 1.5;     // allowed ns/sample relative to the recording
+};
+
+// ---------------------------------------------------------------------------
+// Test signals, stereo, with the two channels deliberately different
+
+Signal MakeSweep(const CorpusSettings& s, int64_t n)
+{
+  Signal x(2, std::vector<double>(static_cast<size_t>(n)));
+  const double f0 = 20.0, f1 = std::min(20000.0, 0.45 * s.sampleRate);
+  const double duration = static_cast<double>(n) / s.sampleRate;
+  const double k = std::log(f1 / f0);
+  for (int64_t i = 0; i < n; ++i)
+  {
+    const double t = i / s.sampleRate;
+    // Exponential sweep up on the left, down on the right
+    const double up = f0 * duration / k * (std::exp(t / duration * k) - 1.0);
+    const double down = f1 * duration / k * (1.0 - std::exp(-t / duration * k));
+    x[0][i] = 0.5 * std::sin(tapedsp::kTwoPi * up);
+    x[1][i] = 0.5 * std::sin(tapedsp::kTwoPi * down);
+  }
+  return x;
+}
+
+Signal MakeImpulses(const CorpusSettings& s, int64_t n)
+{
+  Signal x(2, std::vector<double>(static_cast<size_t>(n), 0.0));
+  const int64_t period = static_cast<int64_t>(0.25 * s.sampleRate);
+  for (int64_t i = 0, k = 0; i < n; i += period, ++k)
+  {
+    x[0][i] = (k & 1) ? -0.9 : 0.9;
+    if (i + period / 2 < n)
+      x[1][i + period / 2] = 0.5;
+  }
+  return x;
+}
+
+Signal MakePinkNoise(const CorpusSettings&, int64_t n)
+{
+  Signal x(2, std::vector<double>(static_cast<size_t>(n)));
+  for (int c = 0; c < 2; ++c)
+  {
+    uint32_t state = 0x9E3779B9u * static_cast<uint32_t>(c + 1);
+    double b[7] = {};
+    for (int64_t i = 0; i < n; ++i)
+    {
+      // Paul Kellet's refined pink filter on uniform white noise
+      const double w = tapedsp::NextRandom(state) - 0.5;
+      b[0] = 0.99886 * b[0] + w * 0.0555179;
+      b[1] = 0.99332 * b[1] + w * 0.0750759;
+      b[2] = 0.96900 * b[2] + w * 0.1538520;
+      b[3] = 0.86650 * b[3] + w * 0.3104856;
+      b[4] = 0.55000 * b[4] + w * 0.5329522;
+      b[5] = -0.7616 * b[5] - w * 0.0168980;
+      x[c][i] = 0.35 * (b[0] + b[1] + b[2] + b[3] + b[4] + b[5] + b[6] + w * 0.5362);
+      b[6] = w * 0.115926;
+    }
+  }
+  return x;
+}
+
+Signal MakeSine(const CorpusSettings& s, int64_t n)
+{
+  Signal x(2, std::vector<double>(static_cast<size_t>(n)));
+  for (int64_t i = 0; i < n; ++i)
+  {
+    const double phase = tapedsp::kTwoPi * kSineHz * i / s.sampleRate;
+    x[0][i] = 0.5 * std::sin(phase);
+    x[1][i] = 0.25 * std::sin(phase + 1.0);
+  }
+  return x;
+}
+
+// Kick every half second, an A minor chord and off-beat hi-hat bursts
+Signal MakeProgram(const CorpusSettings& s, int64_t n)
+{
+  Signal x(2, std::vector<double>(static_cast<size_t>(n)));
+  const double chord[3] = {220.0, 261.63, 329.63};
+  const int64_t beat = static_cast<int64_t>(0.5 * s.sampleRate);
+  uint32_t state = 0x1234567u;
+  double kickPhase = 0.0, lastNoise = 0.0;
+
+  for (int64_t i = 0; i < n; ++i)
+  {
+    const double t = i / s.sampleRate;
+    const double tb = static_cast<double>(i % beat) / s.sampleRate;
+
+    kickPhase += tapedsp::kTwoPi * (45.0 + 80.0 * std::exp(-tb * 40.0)) / s.sampleRate;
+    const double kick = 0.8 * std::exp(-tb * 9.0) * std::sin(kickPhase);
+
+    double pad = 0.0;
+    for (double f : chord)
+    {
+      for (int h = 1; h <= 6; ++h)
+        pad += std::sin(tapedsp::kTwoPi * f * h * t) / h;
+    }
+    pad *= 0.06;
+
+    const double th = static_cast<double>((i + beat / 2) % beat) / s.sampleRate;
+    const double noise = tapedsp::NextRandom(state) - 0.5;
+    const double hat = 0.6 * std::exp(-th * 60.0) * (noise - lastNoise);
+    lastNoise = noise;
+
+    x[0][i] = kick + pad + hat;
+    x[1][i] = kick + 0.8 * pad - 0.5 * hat;
+  }
+  return x;
+}
+
+struct SignalDef
+{
+  const char* name;
+  Signal (*make)(const CorpusSettings&, int64_t);
+};
+
+const SignalDef kSignals[] = {
+  {"sweep", MakeSweep},
+  {"impulse", MakeImpulses},
+  {"noise", MakePinkNoise},
+  {"sine", MakeSine},
+  {"program", MakeProgram},
+};
+
+// ---------------------------------------------------------------------------
+// Parameter grid. Each state is rendered with every signal.
+
+struct StateDef
+{
+  const char* name;
+  const char* params;
+  Tolerance tolerance;
+};
+
+const StateDef kStates[] = {
+  {"default", "", {}},
+  {"hard", "ClipMode=Hard DriveGain=0.7 ClipThreshold=0.6", {}},
+  {"soft", "ClipMode=Soft DriveGain=0.5 ClipSlope=0.8", {}},
+  {"tanh-hot", "ClipMode=Tanh DriveGain=1 Output=-6", {}},
+  {"crush", "MPCBits=6 ResampleRatio=0.4 WowAmount=0 FlutterAmount=0", {}},
+  {"wow", "WowAmount=0.08 WowRate=1.5 FlutterAmount=0.04 FlutterRate=20", {}},
+  {"noise", "NoiseLevel=50", {}},
+  {"tone", "ToneLow=9 ToneHigh=-6 ToneMidQ=1.8 LowPassCutoff=5000 LowPassResonance=0.8", {}},
+  {"truepeak", "TruePeak=on DriveGain=0.8 Output=6", {}},
+  {"bypass", "Power=off", {}},
+  {"cassette", "Machine=Cassette DriveGain=0.5", {}},
+  {"cart", "Machine=Cart DriveGain=0.5", {}},
+  {"sampler", "Machine=Sampler DriveGain=0.5 MPCBits=12", {}},
+  {"multiband", "Bands=3 DriveGain=0.8 BandDrive1=-0.3 BandSag3=1.6", {}},
+  {"multiband4", "Bands=4 Machine=Cassette DriveGain=0.6 BandDrive4=0.3 CrossoverLow=120", {}},
+  {"autogain", "AutoGain=on DriveGain=0.9", {}},
+};
+
+struct TestCase
+{
+  std::string name;
+  std::string signal;
+  JobSpec job;
+  std::vector<std::string> paramTokens;
+  Tolerance tolerance;
+  double recordedNs = 0.0;
+};
+
+bool ParseParams(const std::vector<std::string>& tokens, JobSpec& job, std::string& error)
+{
+  for (const std::string& token : tokens)
+  {
+    std::pair<int, double> assignment;
+    if (!ParseParamAssignment(token, assignment, error))
+      return false;
+    job.params.push_back(assignment);
+  }
+  return true;
+}
+
+const SignalDef* FindSignal(const std::string& name)
+{
+  for (const SignalDef& def : kSignals)
+  {
+    if (name == def.name)
+      return &def;
+  }
+  return nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// Rendering and measurement
+
+// Latency-compensated render, best wall time of `runs` passes in ns/sample
+double RenderTest(const TestCase& test, const CorpusSettings& settings, int tier, int runs, const Signal& in, Signal& out)
+{
+  auto dsp = std::make_unique<TapeSaturatorDSP>();
+  const int64_t numFrames = static_cast<int64_t>(in[0].size());
+  double best = 1e30;
+
+  for (int run = 0; run < runs; ++run)
+  {
+    dsp->SetQualityTier(tier);
+    PrepareDSP(*dsp, test.job, settings.sampleRate);
+
+    const int64_t latency = dsp->GetLatencySamples();
+    const int64_t total = numFrames + latency;
+    Signal padded(2, std::vector<double>(static_cast<size_t>(total), 0.0));
+    Signal rendered(2, std::vector<double>(static_cast<size_t>(total)));
+    for (int c = 0; c < 2; ++c)
+      std::copy(in[c].begin(), in[c].end(), padded[c].begin());
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int64_t pos = 0; pos < total; pos += settings.blockSize)
+    {
+      const int n = static_cast<int>(std::min<int64_t>(settings.blockSize, total - pos));
+      const double* inPtrs[2] = {padded[0].data() + pos, padded[1].data() + pos};
+      double* outPtrs[2] = {rendered[0].data() + pos, rendered[1].data() + pos};
+      dsp->ProcessBlock(inPtrs, outPtrs, n, 2);
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    best = std::min(best, seconds * 1e9 / (2.0 * static_cast<double>(total)));
+
+    out.assign(2, std::vector<double>());
+    for (int c = 0; c < 2; ++c)
+      out[c].assign(rendered[c].begin() + latency, rendered[c].end());
+  }
+  return best;
+}
+
+// References are stored as float32, so outputs are compared after the same rounding
+void RoundToFloat(Signal& x)
+{
+  for (auto& channel : x)
+  {
+    for (double& v : channel)
+      v = static_cast<float>(v);
+  }
+}
+
+struct Comparison
+{
+  bool exact = false;
+  double nullDb = -HUGE_VAL;
+  double thdDeltaDb = 0.0;
+  double bandDeltaDb = 0.0;
+};
+
+Comparison Compare(const Signal& out, const Signal& ref, bool measureThd, double sampleRate)
+{
+  Comparison result;
+  double residual = 0.0, power = 0.0;
+  for (size_t c = 0; c < ref.size(); ++c)
+  {
+    for (size_t i = 0; i < ref[c].size(); ++i)
+    {
+      const double d = out[c][i] - ref[c][i];
+      residual += d * d;
+      power += ref[c][i] * ref[c][i];
+    }
+  }
+  result.exact = residual == 0.0;
+  if (!result.exact)
+    result.nullDb = 10.0 * std::log10(residual / std::max(power, 1e-30));
+
+  const int64_t numFrames = static_cast<int64_t>(ref[0].size());
+  const int fftSize = spectrum::LargestPowerOfTwo(numFrames / 4, 8192);
+  for (size_t c = 0; c < ref.size(); ++c)
+  {
+    const auto outBands = spectrum::ThirdOctaveBands(spectrum::WelchPowerSpectrum(out[c].data(), numFrames, fftSize), sampleRate, fftSize);
+    const auto refBands = spectrum::ThirdOctaveBands(spectrum::WelchPowerSpectrum(ref[c].data(), numFrames, fftSize), sampleRate, fftSize);
+    const double loudest = *std::max_element(refBands.begin(), refBands.end());
+    for (size_t b = 0; b < refBands.size(); ++b)
+    {
+      // Bands 120 dB below the loudest one are numerical noise
+      if (std::max(refBands[b], outBands[b]) < loudest * 1e-12)
+        continue;
+      const double delta = 10.0 * std::log10((outBands[b] + 1e-30) / (refBands[b] + 1e-30));
+      result.bandDeltaDb = std::max(result.bandDeltaDb, std::fabs(delta));
+    }
+
+    if (measureThd)
+    {
+      // Steady-state tail, clear of the start-up transient
+      const int64_t frames = spectrum::LargestPowerOfTwo(numFrames, 1 << 16);
+      const double* o = out[c].data() + (numFrames - frames);
+      const double* r = ref[c].data() + (numFrames - frames);
+      const double delta = spectrum::ThdDb(o, frames, sampleRate, kSineHz) - spectrum::ThdDb(r, frames, sampleRate, kSineHz);
+      result.thdDeltaDb = std::max(result.thdDeltaDb, std::fabs(delta));
+    }
+  }
+  return result;
+}
+
+// ---------------------------------------------------------------------------
+// Corpus manifest
+
+std::vector<TestCase> BuildGrid()
+{
+  std::vector<TestCase> tests;
+  for (const StateDef& state : kStates)
+  {
+    for (const SignalDef& signal : kSignals)
+    {
+      TestCase test;
+      test.name = std::string(signal.name) + "-" + state.name;
+      test.signal = signal.name;
+      test.paramTokens = Tokenise(state.params);
+      test.tolerance = state.tolerance;
+      tests.push_back(std::move(test));
+    }
+  }
+  return tests;
+}
+
+bool WriteManifest(const std::string& path, const CorpusSettings& settings, const std::vector<TestCase>& tests)
+{
+  FILE* file = std::fopen(path.c_str(), "w");
+  if (!file)
+    return false;
+
+  std::fprintf(file, "# lofi-render verify corpus, recorded with version %s\n", PLUG_VERSION_STR);
+  std::fprintf(file, "# test <name> signal=<s> null=<dB> thd=<dB> band=<dB> ns=<recorded> budget=<x> [Param=value ...]\n");
+  std::fprintf(file, "corpus seconds=%g rate=%g block=%d\n", settings.seconds, settings.sampleRate, settings.blockSize);
+  for (const TestCase& test : tests)
+  {
+    std::fprintf(file, "test %s signal=%s null=%g thd=%g band=%g ns=%.2f budget=%g", test.name.c_str(), test.signal.c_str(),
+                 test.tolerance.nullDb, test.tolerance.thdDb, test.tolerance.bandDb, test.recordedNs, test.tolerance.budget);
+    for (const std::string& token : test.paramTokens)
+      std::fprintf(file, " %s", token.c_str());
+    std::fprintf(file, "\n");
+  }
+  return std::fclose(file) == 0;
+}
+
+bool ReadManifest(const std::string& path, CorpusSettings& settings, std::vector<TestCase>& tests)
+{
+  std::ifstream file(path);
+  if (!file)
+  {
+    std::fprintf(stderr, "error: cannot read %s\n", path.c_str());
+    return false;
+  }
+
+  std::string line;
+  int lineNumber = 0;
+  while (std::getline(file, line))
+  {
+    ++lineNumber;
+    const std::vector<std::string> tokens = Tokenise(line);
+    if (tokens.empty() || tokens[0][0] == '#')
+      continue;
+
+    bool ok = true;
+    std::string error = "malformed line";
+    if (tokens[0] == "corpus")
+    {
+      for (size_t i = 1; i < tokens.size() && ok; ++i)
+      {
+        const size_t eq = tokens[i].find('=');
+        const std::string key = tokens[i].substr(0, eq);
+        const double value = eq == std::string::npos ? 0.0 : std::atof(tokens[i].c_str() + eq + 1);
+        if (key == "seconds")
+          settings.seconds = value;
+        else if (key == "rate")
+          settings.sampleRate = value;
+        else if (key == "block")
+          settings.blockSize = static_cast<int>(value);
+        else
+          ok = false;
+      }
+      ok = ok && settings.seconds > 0.0 && settings.sampleRate > 0.0 && settings.blockSize > 0;
+    }
+    else if (tokens[0] == "test" && tokens.size() >= 2)
+    {
+      TestCase test;
+      test.name = tokens[1];
+      for (size_t i = 2; i < tokens.size(); ++i)
+      {
+        const size_t eq = tokens[i].find('=');
+        const std::string key = tokens[i].substr(0, eq);
+        const char* value = eq == std::string::npos ? "" : tokens[i].c_str() + eq + 1;
+        if (key == "signal")
+          test.signal = value;
+        else if (key == "null")
+          test.tolerance.nullDb = std::atof(value);
+        else if (key == "thd")
+          test.tolerance.thdDb = std::atof(value);
+        else if (key == "band")
+          test.tolerance.bandDb = std::atof(value);
+        else if (key == "ns")
+          test.recordedNs = std::atof(value);
+        else if (key == "budget")
+          test.tolerance.budget = std::atof(value);
+        else
+          test.paramTokens.push_back(tokens[i]);
+      }
+      ok = ParseParams(test.paramTokens, test.job, error);
+      if (ok && !FindSignal(test.signal))
+      {
+        error = "unknown signal '" + test.signal + "'";
+        ok = false;
+      }
+      if (ok)
+        tests.push_back(std::move(test));
+    }
+    else
+    {
+      ok = false;
+    }
+
+    if (!ok)
+    {
+      std::fprintf(stderr, "%s:%d: %s\n", path.c_str(), lineNumber, error.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+void PrintVerifyUsage()
+{
+  std::fprintf(stderr,
+    "usage: lofi-render verify --record <dir> [--seconds s] [--rate hz] [--block frames] [--runs n]\n"
+    "       lofi-render verify <dir> [--runs n] [--tier high|eco|draft] [--no-perf] [--only text]\n");
+}
+
+std::string FormatDb(bool exact, double db)
+{
+  if (exact)
+    return "exact";
+  char text[32];
+  std::snprintf(text, sizeof(text), "%.1f", db);
+  return text;
+}
+} // namespace
+
+int RunVerifyCommand(int argc, char** argv)
+{
+  CorpusSettings settings;
+  std::string dir, only;
+  bool record = false, checkPerf = true;
+  int runs = 3;
+  int tier = kQualityTierHigh;
+
+  for (int i = 0; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    if (arg == "--record" && i + 1 < argc)
+    {
+      record = true;
+      dir = argv[++i];
+    }
+    else if (arg == "--seconds" && i + 1 < argc)
+      settings.seconds = std::clamp(std::atof(argv[++i]), 0.5, 60.0);
+    else if (arg == "--rate" && i + 1 < argc)
+      settings.sampleRate = std::clamp(std::atof(argv[++i]), 8000.0, 384000.0);
+    else if (arg == "--block" && i + 1 < argc)
+      settings.blockSize = std::clamp(std::atoi(argv[++i]), 1, 65536);
+    else if (arg == "--runs" && i + 1 < argc)
+      runs = std::clamp(std::atoi(argv[++i]), 1, 100);
+    else if (arg == "--only" && i + 1 < argc)
+      only = argv[++i];
+    else if (arg == "--no-perf")
+      checkPerf = false;
+    else if (arg == "--tier" && i + 1 < argc)
+    {
+      const std::string name = argv[++i];
+      tier = -1;
+      for (int t = 0; t < kNumQualityTiers; ++t)
+      {
+        if (name == kTierNames[t])
+          tier = t;
+      }
+      if (tier < 0)
+      {
+        PrintVerifyUsage();
+        return 1;
+      }
+    }
+    else if (dir.empty() && !arg.empty() && arg[0] != '-')
+      dir = arg;
+    else
+    {
+      PrintVerifyUsage();
+      return 1;
+    }
+  }
+
+  if (dir.empty() || (record && !only.empty()))
+  {
+    PrintVerifyUsage();
+    return 1;
+  }
+
+  const std::string manifestPath = dir + "/" + kManifestName;
+  std::vector<TestCase> tests;
+  if (record)
+  {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (ec)
+    {
+      std::fprintf(stderr, "error: cannot create %s\n", dir.c_str());
+      return 1;
+    }
+    tests = BuildGrid();
+    for (TestCase& test : tests)
+    {
+      std::string error;
+      if (!ParseParams(test.paramTokens, test.job, error))
+      {
+        std::fprintf(stderr, "error: %s\n", error.c_str());
+        return 1;
+      }
+    }
+  }
+  else if (!ReadManifest(manifestPath, settings, tests))
+  {
+    return 1;
+  }
+
+  const int64_t numFrames = static_cast<int64_t>(settings.seconds * settings.sampleRate);
+  std::printf("%s %zu tests, %.1f s stereo at %.0f Hz, block %d, best of %d, %s quality\n\n", record ? "recording" : "checking",
+              tests.size(), settings.seconds, settings.sampleRate, settings.blockSize, runs, kTierNames[tier]);
+  if (record)
+    std::printf("%-20s %10s\n", "test", "ns/sample");
+  else
+    std::printf("%-20s %8s %8s %8s %10s %10s  %s\n", "test", "null dB", "thd dB", "band dB", "ns/sample", "budget", "result");
+
+  int failures = 0, checked = 0;
+  for (TestCase& test : tests)
+  {
+    if (!only.empty() && test.name.find(only) == std::string::npos)
+      continue;
+    ++checked;
+
+    const Signal input = FindSignal(test.signal)->make(settings, numFrames);
+    Signal output;
+    const double ns = RenderTest(test, settings, tier, runs, input, output);
+    RoundToFloat(output);
+    const std::string refPath = dir + "/" + test.name + ".wav";
+
+    if (record)
+    {
+      test.recordedNs = ns;
+      WavAudio audio;
+      audio.format.numChannels = 2;
+      audio.format.sampleRate = static_cast<int>(settings.sampleRate);
+      audio.format.bitsPerSample = 32;
+      audio.format.isFloat = true;
+      audio.channels = output;
+      std::string error;
+      if (!WriteWav(refPath, audio, error))
+      {
+        std::fprintf(stderr, "error: %s: %s\n", refPath.c_str(), error.c_str());
+        return 1;
+      }
+      std::printf("%-20s %10.2f\n", test.name.c_str(), ns);
+      continue;
+    }
+
+    WavAudio reference;
+    std::string error;
+    if (!ReadWav(refPath, reference, error) || reference.channels.size() != 2 || reference.NumFrames() != numFrames)
+    {
+      std::printf("%-20s %s\n", test.name.c_str(), error.empty() ? "FAIL (reference does not match the corpus settings)" : ("FAIL (" + error + ")").c_str());
+      ++failures;
+      continue;
+    }
+
+    const Comparison cmp = Compare(output, reference.channels, test.signal == "sine", settings.sampleRate);
+    const double budgetNs = test.recordedNs * test.tolerance.budget + kPerfSlackNs;
+    const bool soundOk = (cmp.exact || cmp.nullDb <= test.tolerance.nullDb) && cmp.thdDeltaDb <= test.tolerance.thdDb && cmp.bandDeltaDb <= test.tolerance.bandDb;
+    const bool perfOk = !checkPerf || test.recordedNs <= 0.0 || ns <= budgetNs;
+    if (!soundOk || !perfOk)
+      ++failures;
+
+    std::printf("%-20s %8s %8.3f %8.3f %10.2f %10.2f  %s\n", test.name.c_str(), FormatDb(cmp.exact, cmp.nullDb).c_str(), cmp.thdDeltaDb,
+                cmp.bandDeltaDb, ns, budgetNs, soundOk ? (perfOk ? "ok" : "FAIL (slower)") : "FAIL (sound)");
+  }
+
+  if (record)
+  {
+    if (!WriteManifest(manifestPath, settings, tests))
+    {
+      std::fprintf(stderr, "error: cannot write %s\n", manifestPath.c_str());
+      return 1;
+    }
+    std::printf("\nwrote %s\n", manifestPath.c_str());
+    return 0;
+  }
+
+  std::printf("\n%d of %d tests failed\n", failures, checked);
+  return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,337 @@
+#pragma once
+
+// Minimal RIFF/WAVE reader and writer for the offline tools.
+// Handles integer PCM (8/16/24/32 bit) and IEEE float (32/64 bit), including
+// WAVE_FORMAT_EXTENSIBLE headers. Audio is exchanged as deinterleaved doubles.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct WavFormat
+{
+  int numChannels = 2;
+  int sampleRate = 44100;
+  int bitsPerSample = 24;
+  bool isFloat = false;
+
+  int BytesPerSample() const { return bitsPerSample / 8; }
+  int BlockAlign() const { return BytesPerSample() * numChannels; }
+};
+
+struct WavAudio
+{
+  WavFormat format;
+  std::vector<std::vector<double>> channels;
+
+  int64_t NumFrames() const { return channels.empty() ? 0 : static_cast<int64_t>(channels[0].size()); }
+};
+
+namespace wavfile
+{
+constexpr uint16_t kFormatPCM = 0x0001;
+constexpr uint16_t kFormatFloat = 0x0003;
+constexpr uint16_t kFormatExtensible = 0xFFFE;
+
+inline uint16_t ReadU16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+inline uint32_t ReadU32(const uint8_t* p) { return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24); }
+
+inline void PutU16(std::vector<uint8_t>& out, uint16_t v)
+{
+  out.push_back(static_cast<uint8_t>(v & 0xFF));
+  out.push_back(static_cast<uint8_t>(v >> 8));
+}
+
+inline void PutU32(std::vector<uint8_t>& out, uint32_t v)
+{
+  for (int i = 0; i < 4; ++i)
+    out.push_back(static_cast<uint8_t>((v >> (8 * i)) & 0xFF));
+}
+
+inline double DecodeSample(const uint8_t* p, const WavFormat& fmt)
+{
+  if (fmt.isFloat)
+  {
+    if (fmt.bitsPerSample == 64)
+    {
+      double d;
+      std::memcpy(&d, p, sizeof(d));
+      return d;
+    }
+    float f;
+    std::memcpy(&f, p, sizeof(f));
+    return static_cast<double>(f);
+  }
+
+  switch (fmt.bitsPerSample)
+  {
+    case 8: return (static_cast<double>(p[0]) - 128.0) / 128.0;
+    case 16: return static_cast<double>(static_cast<int16_t>(ReadU16(p))) / 32768.0;
+    case 24:
+    {
+      int32_t v = static_cast<int32_t>(p[0] | (p[1] << 8) | (p[2] << 16));
+      if (v & 0x800000)
+        v |= ~0xFFFFFF;
+      return static_cast<double>(v) / 8388608.0;
+    }
+    case 32: return static_cast<double>(static_cast<int32_t>(ReadU32(p))) / 2147483648.0;
+    default: return 0.0;
+  }
+}
+
+inline void EncodeSample(double x, uint8_t* p, const WavFormat& fmt)
+{
+  if (fmt.isFloat)
+  {
+    if (fmt.bitsPerSample == 64)
+    {
+      std::memcpy(p, &x, sizeof(x));
+    }
+    else
+    {
+      const float f = static_cast<float>(x);
+      std::memcpy(p, &f, sizeof(f));
+    }
+    return;
+  }
+
+  const double clamped = std::clamp(x, -1.0, 1.0);
+  switch (fmt.bitsPerSample)
+  {
+    case 8:
+      p[0] = static_cast<uint8_t>(std::clamp(std::lround(clamped * 128.0) + 128L, 0L, 255L));
+      break;
+    case 16:
+    {
+      const int32_t v = static_cast<int32_t>(std::clamp(std::lround(clamped * 32768.0), -32768L, 32767L));
+      p[0] = static_cast<uint8_t>(v & 0xFF);
+      p[1] = static_cast<uint8_t>((v >> 8) & 0xFF);
+      break;
+    }
+    case 24:
+    {
+      const int32_t v = static_cast<int32_t>(std::clamp(std::lround(clamped * 8388608.0), -8388608L, 8388607L));
+      p[0] = static_cast<uint8_t>(v & 0xFF);
+      p[1] = static_cast<uint8_t>((v >> 8) & 0xFF);
+      p[2] = static_cast<uint8_t>((v >> 16) & 0xFF);
+      break;
+    }
+    case 32:
+    {
+      const int64_t v = std::clamp(std::llround(clamped * 2147483648.0), -2147483648LL, 2147483647LL);
+      const uint32_t u = static_cast<uint32_t>(static_cast<int32_t>(v));
+      for (int i = 0; i < 4; ++i)
+        p[i] = static_cast<uint8_t>((u >> (8 * i)) & 0xFF);
+      break;
+    }
+    default: break;
+  }
+}
+
+inline bool IsSupported(const WavFormat& fmt)
+{
+  if (fmt.numChannels < 1 || fmt.sampleRate < 1)
+    return false;
+  if (fmt.isFloat)
+    return fmt.bitsPerSample == 32 || fmt.bitsPerSample == 64;
+  return fmt.bitsPerSample == 8 || fmt.bitsPerSample == 16 || fmt.bitsPerSample == 24 || fmt.bitsPerSample == 32;
+}
+
+// Builds a 44-byte (PCM) or 46-byte (float, with cbSize) canonical header
+inline std::vector<uint8_t> MakeHeader(const WavFormat& fmt, uint64_t dataBytes)
+{
+  std::vector<uint8_t> h;
+  const uint32_t fmtSize = fmt.isFloat ? 18u : 16u;
+  const uint32_t dataSize = static_cast<uint32_t>(std::min<uint64_t>(dataBytes, 0xFFFFFFFFull - 64));
+  h.insert(h.end(), {'R', 'I', 'F', 'F'});
+  PutU32(h, 4 + (8 + fmtSize) + (8 + dataSize));
+  h.insert(h.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+  PutU32(h, fmtSize);
+  PutU16(h, fmt.isFloat ? kFormatFloat : kFormatPCM);
+  PutU16(h, static_cast<uint16_t>(fmt.numChannels));
+  PutU32(h, static_cast<uint32_t>(fmt.sampleRate));
+  PutU32(h, static_cast<uint32_t>(fmt.sampleRate * fmt.BlockAlign()));
+  PutU16(h, static_cast<uint16_t>(fmt.BlockAlign()));
+  PutU16(h, static_cast<uint16_t>(fmt.bitsPerSample));
+  if (fmt.isFloat)
+    PutU16(h, 0);
+  h.insert(h.end(), {'d', 'a', 't', 'a'});
+  PutU32(h, dataSize);
+  return h;
+}
+} // namespace wavfile
+
+// 64-bit file positioning, multi-hour files exceed 2 GB
+inline bool SeekFile(FILE* file, int64_t offset)
+{
+#if defined(_WIN32)
+  return _fseeki64(file, offset, SEEK_SET) == 0;
+#else
+  return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+inline int64_t TellFile(FILE* file)
+{
+#if defined(_WIN32)
+  return _ftelli64(file);
+#else
+  return static_cast<int64_t>(ftello(file));
+#endif
+}
+
+// Rewrites the RIFF and data sizes of a file written with MakeHeader
+inline bool PatchWavSizes(FILE* file, const WavFormat& fmt, uint64_t dataBytes)
+{
+  const std::vector<uint8_t> header = wavfile::MakeHeader(fmt, dataBytes);
+  return SeekFile(file, 0) && std::fwrite(header.data(), 1, header.size(), file) == header.size();
+}
+
+// Parses the RIFF header of an open file and leaves it positioned at the start
+// of the sample data. dataBytes receives the size of the data chunk.
+inline bool ReadWavHeader(FILE* file, WavFormat& fmt, uint64_t& dataBytes, std::string& error)
+{
+  using namespace wavfile;
+
+  uint8_t riff[12];
+  if (std::fread(riff, 1, 12, file) != 12 || std::memcmp(riff, "RIFF", 4) != 0 || std::memcmp(riff + 8, "WAVE", 4) != 0)
+  {
+    error = "not a RIFF/WAVE file";
+    return false;
+  }
+
+  bool haveFmt = false;
+  uint8_t chunk[8];
+  while (std::fread(chunk, 1, 8, file) == 8)
+  {
+    const uint32_t size = ReadU32(chunk + 4);
+    if (std::memcmp(chunk, "fmt ", 4) == 0)
+    {
+      std::vector<uint8_t> body(size);
+      if (size < 16 || std::fread(body.data(), 1, size, file) != size)
+      {
+        error = "truncated fmt chunk";
+        return false;
+      }
+      uint16_t tag = ReadU16(&body[0]);
+      fmt.numChannels = ReadU16(&body[2]);
+      fmt.sampleRate = static_cast<int>(ReadU32(&body[4]));
+      fmt.bitsPerSample = ReadU16(&body[14]);
+      if (tag == kFormatExtensible && size >= 26)
+        tag = ReadU16(&body[24]); // first two bytes of the SubFormat GUID
+      fmt.isFloat = tag == kFormatFloat;
+      if ((tag != kFormatPCM && tag != kFormatFloat) || !IsSupported(fmt))
+      {
+        error = "unsupported sample format";
+        return false;
+      }
+      if (size & 1)
+        std::fseek(file, 1, SEEK_CUR);
+      haveFmt = true;
+    }
+    else if (std::memcmp(chunk, "data", 4) == 0)
+    {
+      if (!haveFmt)
+      {
+        error = "data chunk before fmt chunk";
+        return false;
+      }
+      dataBytes = size;
+      return true;
+    }
+    else
+    {
+      std::fseek(file, static_cast<long>(size + (size & 1)), SEEK_CUR);
+    }
+  }
+
+  error = "no data chunk";
+  return false;
+}
+
+// Deinterleaves frames from raw little-endian sample bytes
+inline void DecodeFrames(const uint8_t* src, const WavFormat& fmt, int64_t numFrames, double* const* dst)
+{
+  const int bps = fmt.BytesPerSample();
+  for (int64_t f = 0; f < numFrames; ++f)
+  {
+    for (int c = 0; c < fmt.numChannels; ++c)
+    {
+      dst[c][f] = wavfile::DecodeSample(src, fmt);
+      src += bps;
+    }
+  }
+}
+
+// Interleaves frames into raw little-endian sample bytes
+inline void EncodeFrames(const double* const* src, const WavFormat& fmt, int64_t numFrames, uint8_t* dst)
+{
+  const int bps = fmt.BytesPerSample();
+  for (int64_t f = 0; f < numFrames; ++f)
+  {
+    for (int c = 0; c < fmt.numChannels; ++c)
+    {
+      wavfile::EncodeSample(src[c][f], dst, fmt);
+      dst += bps;
+    }
+  }
+}
+
+inline bool ReadWav(const std::string& path, WavAudio& audio, std::string& error)
+{
+  FILE* file = std::fopen(path.c_str(), "rb");
+  if (!file)
+  {
+    error = "cannot open " + path;
+    return false;
+  }
+
+  uint64_t dataBytes = 0;
+  if (!ReadWavHeader(file, audio.format, dataBytes, error))
+  {
+    std::fclose(file);
+    return false;
+  }
+
+  std::vector<uint8_t> raw(static_cast<size_t>(dataBytes));
+  const size_t got = std::fread(raw.data(), 1, raw.size(), file);
+  std::fclose(file);
+
+  const int64_t numFrames = static_cast<int64_t>(got) / audio.format.BlockAlign();
+  audio.channels.assign(audio.format.numChannels, std::vector<double>(static_cast<size_t>(numFrames)));
+  std::vector<double*> dst(audio.format.numChannels);
+  for (int c = 0; c < audio.format.numChannels; ++c)
+    dst[c] = audio.channels[c].data();
+  DecodeFrames(raw.data(), audio.format, numFrames, dst.data());
+  return true;
+}
+
+inline bool WriteWav(const std::string& path, const WavAudio& audio, std::string& error)
+{
+  const WavFormat& fmt = audio.format;
+  const int64_t numFrames = audio.NumFrames();
+  std::vector<uint8_t> bytes = wavfile::MakeHeader(fmt, static_cast<uint64_t>(numFrames) * fmt.BlockAlign());
+  const size_t headerSize = bytes.size();
+  bytes.resize(headerSize + static_cast<size_t>(numFrames) * fmt.BlockAlign());
+
+  std::vector<const double*> src(fmt.numChannels);
+  for (int c = 0; c < fmt.numChannels; ++c)
+    src[c] = audio.channels[c].data();
+  EncodeFrames(src.data(), fmt, numFrames, bytes.data() + headerSize);
+
+  FILE* file = std::fopen(path.c_str(), "wb");
+  if (!file)
+  {
+    error = "cannot create " + path;
+    return false;
+  }
+  const bool ok = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+  std::fclose(file);
+  if (!ok)
+    error = "write failed for " + path;
+  return ok;
+}
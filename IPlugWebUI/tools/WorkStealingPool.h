@@ -0,0 +1,175 @@
+#pragma once
+
+// Small work-stealing thread pool for the offline tools.
+// Each worker owns a deque: it pushes and pops at the back (LIFO, cache warm),
+// idle workers steal from the front of the others (FIFO, oldest/biggest work).
+// Tasks submitted from outside the pool are dealt round-robin.
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool
+{
+public:
+  using Task = std::function<void()>;
+
+  explicit WorkStealingPool(int numThreads)
+  {
+    const int n = std::max(1, numThreads);
+    for (int i = 0; i < n; ++i)
+      mQueues.push_back(std::make_unique<Queue>());
+    for (int i = 0; i < n; ++i)
+      mThreads.emplace_back([this, i]() { WorkerLoop(i); });
+  }
+
+  ~WorkStealingPool()
+  {
+    Wait();
+    {
+      std::lock_guard<std::mutex> lock(mSleepMutex);
+      mStop = true;
+    }
+    mWake.notify_all();
+    for (auto& t : mThreads)
+      t.join();
+  }
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  int NumThreads() const { return static_cast<int>(mThreads.size()); }
+
+  void Submit(Task task)
+  {
+    mPending.fetch_add(1, std::memory_order_acq_rel);
+
+    int target = CurrentWorker();
+    if (target < 0)
+      target = static_cast<int>(mNextQueue.fetch_add(1, std::memory_order_relaxed) % mQueues.size());
+
+    {
+      std::lock_guard<std::mutex> lock(mQueues[target]->mutex);
+      mQueues[target]->tasks.push_back(std::move(task));
+    }
+    {
+      std::lock_guard<std::mutex> lock(mSleepMutex);
+      ++mSignal;
+    }
+    mWake.notify_one();
+  }
+
+  // Blocks until every submitted task (including tasks they submitted) ran
+  void Wait()
+  {
+    std::unique_lock<std::mutex> lock(mSleepMutex);
+    mDone.wait(lock, [this]() { return mPending.load(std::memory_order_acquire) == 0; });
+  }
+
+  uint64_t GetStealCount() const { return mSteals.load(std::memory_order_relaxed); }
+
+private:
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  struct WorkerId
+  {
+    const WorkStealingPool* pool = nullptr;
+    int index = -1;
+  };
+
+  static WorkerId& ThisWorker()
+  {
+    static thread_local WorkerId sId;
+    return sId;
+  }
+
+  // Index of the calling thread's queue, or -1 if it is not one of our workers
+  int CurrentWorker() const
+  {
+    const WorkerId& id = ThisWorker();
+    return id.pool == this ? id.index : -1;
+  }
+
+  bool PopLocal(int idx, Task& task)
+  {
+    Queue& q = *mQueues[idx];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty())
+      return false;
+    task = std::move(q.tasks.back());
+    q.tasks.pop_back();
+    return true;
+  }
+
+  bool Steal(int thief, Task& task)
+  {
+    const int n = static_cast<int>(mQueues.size());
+    for (int k = 1; k < n; ++k)
+    {
+      Queue& q = *mQueues[(thief + k) % n];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if (!q.tasks.empty())
+      {
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        mSteals.fetch_add(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void WorkerLoop(int idx)
+  {
+    ThisWorker() = WorkerId {this, idx};
+
+    for (;;)
+    {
+      uint64_t seen;
+      {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        seen = mSignal;
+      }
+
+      Task task;
+      if (PopLocal(idx, task) || Steal(idx, task))
+      {
+        task();
+        if (mPending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+          std::lock_guard<std::mutex> lock(mSleepMutex);
+          mDone.notify_all();
+        }
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(mSleepMutex);
+      mWake.wait(lock, [&]() { return mStop || mSignal != seen; });
+      if (mStop)
+        return;
+    }
+  }
+
+  std::vector<std::unique_ptr<Queue>> mQueues;
+  std::vector<std::thread> mThreads;
+  std::atomic<uint64_t> mNextQueue {0};
+  std::atomic<int64_t> mPending {0};
+  std::atomic<uint64_t> mSteals {0};
+
+  std::mutex mSleepMutex;
+  std::condition_variable mWake;
+  std::condition_variable mDone;
+  uint64_t mSignal = 0;
+  bool mStop = false;
+};